@@ -102,6 +102,18 @@ CompositeUndoStackObserver::notifyClearRedoEvent()
 	this->_unlock();
 }
 
+void
+CompositeUndoStackObserver::notifyUndoExpiredEvent(Event* log)
+{
+	this->_lock();
+	for (auto &i : _active) {
+		if (!i.to_remove) {
+			i.issueUndoExpired(log);
+		}
+	}
+	this->_unlock();
+}
+
 bool
 CompositeUndoStackObserver::_remove_one(UndoObserverRecordList& list, UndoStackObserver& o)
 {
@@ -103,6 +103,17 @@ public:
 			this->_observer->notifyClearRedoEvent();
 		}
 
+		/**
+		 * Issue an expired undo event to the UndoStackObserver that is associated with this
+		 * UndoStackObserverRecord.
+		 *
+		 * \param log The event log being dropped from the undo stack.
+		 */
+		void issueUndoExpired(Event* log)
+		{
+			this->_observer->notifyUndoExpiredEvent(log);
+		}
+
 	private:
 		UndoStackObserver *_observer;
 	};
@@ -154,6 +165,7 @@ public:
 
 	void notifyClearUndoEvent() override;
 	void notifyClearRedoEvent() override;
+	void notifyUndoExpiredEvent(Event* log) override;
 
 private:
 	// Remove an observer from a given list
@@ -33,6 +33,8 @@ public:
 
     void setAvoid(char const *value);
     void handleSettingChange();
+    // Whether handleSettingChange() has a change to make.
+    bool settingChanged() const { return new_setting != setting; }
 
     Geom::Point getConnectionPointPos();
 
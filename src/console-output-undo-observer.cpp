@@ -46,6 +46,12 @@ ConsoleOutputUndoObserver::notifyClearRedoEvent()
     //g_message("notifyClearRedoEvent(sp_document_clear_redo) called);
 }
 
+void
+ConsoleOutputUndoObserver::notifyUndoExpiredEvent(Event* /*log*/)
+{
+    //g_message("notifyUndoExpiredEvent(SPDocumentUndo::maybe_done) called; log=%p\n", log->event);
+}
+
 }
 
 /*
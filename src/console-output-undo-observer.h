@@ -31,6 +31,7 @@ public:
     void notifyUndoCommitEvent(Event* log) override;
     void notifyClearUndoEvent() override;
     void notifyClearRedoEvent() override;
+    void notifyUndoExpiredEvent(Event* log) override;
 
 };
 }
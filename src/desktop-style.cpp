@@ -1254,7 +1254,7 @@ objects_query_fontstyle (const std::vector<SPItem*> &objects, SPStyle *style_res
               ( style_res->font_style.computed     != style->font_style.computed   ) ||
               ( style_res->font_stretch.computed   != style->font_stretch.computed ) ||
               ( style_res->font_variant.computed   != style->font_variant.computed ) ||
-              ( style_res->font_variation_settings != style->font_variation_settings ) ) ) {
+              ( style_res->fontVariants().font_variation_settings != style->fontVariants().font_variation_settings ) ) ) {
             different = true;  // different styles
         }
 
@@ -1263,7 +1263,7 @@ objects_query_fontstyle (const std::vector<SPItem*> &objects, SPStyle *style_res
         style_res->font_style.value = style_res->font_style.computed = style->font_style.computed;
         style_res->font_stretch.value = style_res->font_stretch.computed = style->font_stretch.computed;
         style_res->font_variant.value = style_res->font_variant.computed = style->font_variant.computed;
-        style_res->font_variation_settings = style->font_variation_settings;
+        style_res->writableFontVariants().font_variation_settings = style->fontVariants().font_variation_settings;
         style_res->text_align.value = style_res->text_align.computed = style->text_align.computed;
         style_res->font_size.value = style->font_size.value;
         style_res->font_size.unit = style->font_size.unit;
@@ -1290,9 +1290,10 @@ objects_query_fontvariants (const std::vector<SPItem*> &objects, SPStyle *style_
 
     int texts = 0;
 
-    SPILigatures* ligatures_res = &(style_res->font_variant_ligatures);
-    SPINumeric* numeric_res     = &(style_res->font_variant_numeric);
-    SPIEastAsian* asian_res     = &(style_res->font_variant_east_asian);
+    auto &variants_res = style_res->writableFontVariants();
+    SPILigatures* ligatures_res = &(variants_res.font_variant_ligatures);
+    SPINumeric* numeric_res     = &(variants_res.font_variant_numeric);
+    SPIEastAsian* asian_res     = &(variants_res.font_variant_east_asian);
 
     // Stores 'and' of all values
     ligatures_res->computed = SP_CSS_FONT_VARIANT_LIGATURES_NORMAL;
@@ -1320,11 +1321,12 @@ objects_query_fontvariants (const std::vector<SPItem*> &objects, SPStyle *style_
 
         texts ++;
 
-        SPILigatures* ligatures_in = &(style->font_variant_ligatures);
-        auto*         position_in  = &(style->font_variant_position);
-        auto*         caps_in      = &(style->font_variant_caps);
-        SPINumeric*   numeric_in   = &(style->font_variant_numeric);
-        SPIEastAsian* asian_in     = &(style->font_variant_east_asian);
+        auto const &variants_in = style->fontVariants();
+        SPILigatures const* ligatures_in = &(variants_in.font_variant_ligatures);
+        auto const*         position_in  = &(variants_in.font_variant_position);
+        auto const*         caps_in      = &(variants_in.font_variant_caps);
+        SPINumeric const*   numeric_in   = &(variants_in.font_variant_numeric);
+        SPIEastAsian const* asian_in     = &(variants_in.font_variant_east_asian);
 
         // computed stores which bits are on/off, only valid if same between all selected objects.
         // value stores which bits are different between objects. This is a bit of an abuse of
@@ -1357,16 +1359,16 @@ objects_query_fontvariants (const std::vector<SPItem*> &objects, SPStyle *style_
     }
 
     // violates enum type safety!
-    style_res->font_variant_position.value = static_cast<SPCSSFontVariantPosition>(position_value);
-    style_res->font_variant_position.computed = static_cast<SPCSSFontVariantPosition>(position_computed);
-    style_res->font_variant_caps.value = static_cast<SPCSSFontVariantCaps>(caps_value);
-    style_res->font_variant_caps.computed = static_cast<SPCSSFontVariantCaps>(caps_computed);
+    variants_res.font_variant_position.value = static_cast<SPCSSFontVariantPosition>(position_value);
+    variants_res.font_variant_position.computed = static_cast<SPCSSFontVariantPosition>(position_computed);
+    variants_res.font_variant_caps.value = static_cast<SPCSSFontVariantCaps>(caps_value);
+    variants_res.font_variant_caps.computed = static_cast<SPCSSFontVariantCaps>(caps_computed);
 
-    bool different = (style_res->font_variant_ligatures.value  != 0 ||
-                      position_value                           != 0 ||
-                      caps_value                               != 0 ||
-                      style_res->font_variant_numeric.value    != 0 ||
-                      style_res->font_variant_east_asian.value != 0);
+    bool different = (variants_res.font_variant_ligatures.value  != 0 ||
+                      position_value                             != 0 ||
+                      caps_value                                 != 0 ||
+                      variants_res.font_variant_numeric.value    != 0 ||
+                      variants_res.font_variant_east_asian.value != 0);
 
     if (texts == 0 || !set)
         return QUERY_STYLE_NOTHING;
@@ -1439,7 +1441,8 @@ objects_query_fontfeaturesettings (const std::vector<SPItem*> &objects, SPStyle
     bool different = false;
     int texts = 0;
 
-    style_res->font_feature_settings.clear();
+    auto &settings_res = style_res->writableFontVariants().font_feature_settings;
+    settings_res.clear();
 
     for (auto obj : objects) {
         // std::cout << "  " << reinterpret_cast<SPObject*>(i->data)->getId() << std::endl;
@@ -1454,17 +1457,17 @@ objects_query_fontfeaturesettings (const std::vector<SPItem*> &objects, SPStyle
 
         texts ++;
 
-        if (style_res->font_feature_settings.set && //
-            strcmp(style_res->font_feature_settings.value(),
-                   style->font_feature_settings.value())) {
+        if (settings_res.set && //
+            strcmp(settings_res.value(),
+                   style->fontVariants().font_feature_settings.value())) {
             different = true;  // different fonts
         }
 
-        style_res->font_feature_settings = style->font_feature_settings;
-        style_res->font_feature_settings.set = true;
+        settings_res = style->fontVariants().font_feature_settings;
+        settings_res.set = true;
     }
 
-    if (texts == 0 || !style_res->font_feature_settings.set) {
+    if (texts == 0 || !settings_res.set) {
         return QUERY_STYLE_NOTHING;
     }
 
@@ -28,7 +28,6 @@ static const int OPENMP_THRESHOLD = 2048;
 #include <cmath>
 #include <algorithm>
 #include <cairo.h>
-#include "display/nr-3dutils.h"
 #include "display/cairo-utils.h"
 
 /**
@@ -74,6 +73,11 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
     // NOTE
     // OpenMP probably doesn't help much here.
     // It would be better to render more than 1 tile at a time.
+    // The contiguous loops are also marked simd, so that branch-free functors (e.g. arithmetic
+    // compositing) are vectorised for whatever instruction set the compiler targets. Their thread
+    // threshold is on a separate parallel construct, because since OpenMP 5.0 an if clause on a
+    // combined "parallel for simd" also applies to simd, and would disable vectorisation for
+    // small surfaces, where it helps most.
     #if HAVE_OPENMP
     int numOfThreads = get_num_filter_threads();
     #endif
@@ -83,7 +87,8 @@ void ink_cairo_surface_blend(cairo_surface_t *in1, cairo_surface_t *in2, cairo_s
         if (bpp2 == 4) {
             if (fast_path) {
                 #if HAVE_OPENMP
-                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+                #pragma omp parallel if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+                #pragma omp for simd
                 #endif
                 for (int i = 0; i < limit; ++i) {
                     *(out_data + i) = blend(*(in1_data + i), *(in2_data + i));
@@ -208,7 +213,8 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
     if (in == out) {
         if (bppin == 4) {
             #if HAVE_OPENMP
-            #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+            #pragma omp parallel if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+            #pragma omp for simd
             #endif
             for (int i = 0; i < limit; ++i) {
                 *(in_data + i) = filter(*(in_data + i));
@@ -233,7 +239,8 @@ void ink_cairo_surface_filter(cairo_surface_t *in, cairo_surface_t *out, Filter
             // bppin == 4, bppout == 4
             if (fast_path) {
                 #if HAVE_OPENMP
-                #pragma omp parallel for if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+                #pragma omp parallel if(limit > OPENMP_THRESHOLD) num_threads(numOfThreads)
+                #pragma omp for simd
                 #endif
                 for (int i = 0; i < limit; ++i) {
                     *(out_data + i) = filter(*(in_data + i));
@@ -487,148 +494,6 @@ struct SurfaceSynth {
         return result;
     }
 
-    // compute surface normal at given coordinates using 3x3 Sobel gradient filter
-    NR::Fvector surfaceNormalAt(int x, int y, double scale) const {
-        // Below there are some multiplies by zero. They will be optimized out.
-        // Do not remove them, because they improve readability.
-        // NOTE: fetching using alphaAt is slightly lazy.
-        NR::Fvector normal;
-        double fx = -scale/255.0, fy = -scale/255.0;
-        normal[Z_3D] = 1.0;
-        if (G_UNLIKELY(x == 0)) {
-            // leftmost column
-            if (G_UNLIKELY(y == 0)) {
-                // upper left corner
-                fx *= (2.0/3.0);
-                fy *= (2.0/3.0);
-                double p00 = alphaAt(x,y),   p10 = alphaAt(x+1, y),
-                       p01 = alphaAt(x,y+1), p11 = alphaAt(x+1, y+1);
-                normal[X_3D] =
-                    -2.0 * p00 +2.0 * p10
-                    -1.0 * p01 +1.0 * p11;
-                normal[Y_3D] = 
-                    -2.0 * p00 -1.0 * p10
-                    +2.0 * p01 +1.0 * p11;
-            } else if (G_UNLIKELY(y == (_h - 1))) {
-                // lower left corner
-                fx *= (2.0/3.0);
-                fy *= (2.0/3.0);
-                double p00 = alphaAt(x,y-1), p10 = alphaAt(x+1, y-1),
-                       p01 = alphaAt(x,y  ), p11 = alphaAt(x+1, y);
-                normal[X_3D] =
-                    -1.0 * p00 +1.0 * p10
-                    -2.0 * p01 +2.0 * p11;
-                normal[Y_3D] = 
-                    -2.0 * p00 -1.0 * p10
-                    +2.0 * p01 +1.0 * p11;
-            } else {
-                // leftmost column
-                fx *= (1.0/2.0);
-                fy *= (1.0/3.0);
-                double p00 = alphaAt(x, y-1), p10 = alphaAt(x+1, y-1),
-                       p01 = alphaAt(x, y  ), p11 = alphaAt(x+1, y  ),
-                       p02 = alphaAt(x, y+1), p12 = alphaAt(x+1, y+1);
-                normal[X_3D] =
-                    -1.0 * p00 +1.0 * p10
-                    -2.0 * p01 +2.0 * p11
-                    -1.0 * p02 +1.0 * p12;
-                normal[Y_3D] =
-                    -2.0 * p00 -1.0 * p10
-                    +0.0 * p01 +0.0 * p11 // this will be optimized out
-                    +2.0 * p02 +1.0 * p12;
-            }
-        } else if (G_UNLIKELY(x == (_w - 1))) {
-            // rightmost column
-            if (G_UNLIKELY(y == 0)) {
-                // top right corner
-                fx *= (2.0/3.0);
-                fy *= (2.0/3.0);
-                double p00 = alphaAt(x-1,y),   p10 = alphaAt(x, y),
-                       p01 = alphaAt(x-1,y+1), p11 = alphaAt(x, y+1);
-                normal[X_3D] =
-                    -2.0 * p00 +2.0 * p10
-                    -1.0 * p01 +1.0 * p11;
-                normal[Y_3D] = 
-                    -1.0 * p00 -2.0 * p10
-                    +1.0 * p01 +2.0 * p11;
-            } else if (G_UNLIKELY(y == (_h - 1))) {
-                // bottom right corner
-                fx *= (2.0/3.0);
-                fy *= (2.0/3.0);
-                double p00 = alphaAt(x-1,y-1), p10 = alphaAt(x, y-1),
-                       p01 = alphaAt(x-1,y  ), p11 = alphaAt(x, y);
-                normal[X_3D] =
-                    -1.0 * p00 +1.0 * p10
-                    -2.0 * p01 +2.0 * p11;
-                normal[Y_3D] = 
-                    -1.0 * p00 -2.0 * p10
-                    +1.0 * p01 +2.0 * p11;
-            } else {
-                // rightmost column
-                fx *= (1.0/2.0);
-                fy *= (1.0/3.0);
-                double p00 = alphaAt(x-1, y-1), p10 = alphaAt(x, y-1),
-                       p01 = alphaAt(x-1, y  ), p11 = alphaAt(x, y  ),
-                       p02 = alphaAt(x-1, y+1), p12 = alphaAt(x, y+1);
-                normal[X_3D] =
-                    -1.0 * p00 +1.0 * p10
-                    -2.0 * p01 +2.0 * p11
-                    -1.0 * p02 +1.0 * p12;
-                normal[Y_3D] =
-                    -1.0 * p00 -2.0 * p10
-                    +0.0 * p01 +0.0 * p11
-                    +1.0 * p02 +2.0 * p12;
-            }
-        } else {
-            // interior
-            if (G_UNLIKELY(y == 0)) {
-                // top row
-                fx *= (1.0/3.0);
-                fy *= (1.0/2.0);
-                double p00 = alphaAt(x-1, y  ), p10 = alphaAt(x, y  ), p20 = alphaAt(x+1, y  ),
-                       p01 = alphaAt(x-1, y+1), p11 = alphaAt(x, y+1), p21 = alphaAt(x+1, y+1);
-                normal[X_3D] =
-                    -2.0 * p00 +0.0 * p10 +2.0 * p20
-                    -1.0 * p01 +0.0 * p11 +1.0 * p21;
-                normal[Y_3D] =
-                    -1.0 * p00 -2.0 * p10 -1.0 * p20
-                    +1.0 * p01 +2.0 * p11 +1.0 * p21;
-            } else if (G_UNLIKELY(y == (_h - 1))) {
-                // bottom row
-                fx *= (1.0/3.0);
-                fy *= (1.0/2.0);
-                double p00 = alphaAt(x-1, y-1), p10 = alphaAt(x, y-1), p20 = alphaAt(x+1, y-1),
-                       p01 = alphaAt(x-1, y  ), p11 = alphaAt(x, y  ), p21 = alphaAt(x+1, y  );
-                normal[X_3D] =
-                    -1.0 * p00 +0.0 * p10 +1.0 * p20
-                    -2.0 * p01 +0.0 * p11 +2.0 * p21;
-                normal[Y_3D] =
-                    -1.0 * p00 -2.0 * p10 -1.0 * p20
-                    +1.0 * p01 +2.0 * p11 +1.0 * p21;
-            } else {
-                // interior pixels
-                // note: p11 is actually unused, so we don't fetch its value
-                fx *= (1.0/4.0);
-                fy *= (1.0/4.0);
-                double p00 = alphaAt(x-1, y-1), p10 = alphaAt(x, y-1), p20 = alphaAt(x+1, y-1),
-                       p01 = alphaAt(x-1, y  ), p11 = 0.0,             p21 = alphaAt(x+1, y  ),
-                       p02 = alphaAt(x-1, y+1), p12 = alphaAt(x, y+1), p22 = alphaAt(x+1, y+1);
-                normal[X_3D] =
-                    -1.0 * p00 +0.0 * p10 +1.0 * p20
-                    -2.0 * p01 +0.0 * p11 +2.0 * p21
-                    -1.0 * p02 +0.0 * p12 +1.0 * p22;
-                normal[Y_3D] =
-                    -1.0 * p00 -2.0 * p10 -1.0 * p20
-                    +0.0 * p01 +0.0 * p11 +0.0 * p21
-                    +1.0 * p02 +2.0 * p12 +1.0 * p22;
-            }
-        }
-        normal[X_3D] *= fx;
-        normal[Y_3D] *= fy;
-        NR::normalize_vector(normal);
-        return normal;
-    }
-
     unsigned char *_px;
     int _w, _h, _stride;
     bool _alpha;
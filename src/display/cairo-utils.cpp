@@ -19,7 +19,9 @@
 #include <2geom/point.h>
 #include <2geom/sbasis-to-bezier.h>
 #include <2geom/transforms.h>
+#include <algorithm>
 #include <atomic>
+#include <mutex>
 #include <boost/algorithm/string.hpp>
 #include <boost/operators.hpp>
 #include <boost/optional/optional.hpp>
@@ -120,6 +122,7 @@ Pixbuf::Pixbuf(Inkscape::Pixbuf const &other)
 
 Pixbuf::~Pixbuf()
 {
+    _clearMipmaps();
     if (!_cairo_store) {
         cairo_surface_destroy(_surface);
     }
@@ -612,6 +615,74 @@ guchar *Pixbuf::pixels() {
 }
 void Pixbuf::markDirty() {
     cairo_surface_mark_dirty(_surface);
+    _clearMipmaps();
+}
+
+/**
+ * Return a copy of an ARGB32 surface at half the scale, with each pixel the average of a 2x2 block. The size is
+ * rounded up, repeating the last row or column at an odd edge, so pixel (x, y) always covers (2x, 2y) to
+ * (2x + 2, 2y + 2) of the source. Premultiplied channels can be averaged directly.
+ */
+static cairo_surface_t *downsample_half(cairo_surface_t *src)
+{
+    int const w = cairo_image_surface_get_width(src);
+    int const h = cairo_image_surface_get_height(src);
+    int const stride = cairo_image_surface_get_stride(src);
+    auto const data = cairo_image_surface_get_data(src);
+
+    auto dest = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (w + 1) / 2, (h + 1) / 2);
+    int const w2 = cairo_image_surface_get_width(dest);
+    int const h2 = cairo_image_surface_get_height(dest);
+    int const stride2 = cairo_image_surface_get_stride(dest);
+    auto const data2 = cairo_image_surface_get_data(dest);
+
+    for (int y = 0; y < h2; y++) {
+        auto const row0 = reinterpret_cast<guint32 const *>(data + 2 * y * stride);
+        auto const row1 = reinterpret_cast<guint32 const *>(data + std::min(2 * y + 1, h - 1) * stride);
+        auto const out = reinterpret_cast<guint32 *>(data2 + y * stride2);
+        for (int x = 0; x < w2; x++) {
+            int const x0 = 2 * x;
+            int const x1 = std::min(2 * x + 1, w - 1);
+            guint32 const px[4] = { row0[x0], row0[x1], row1[x0], row1[x1] };
+            guint32 result = 0;
+            for (int shift = 0; shift < 32; shift += 8) {
+                guint32 sum = 2;
+                for (auto p : px) {
+                    sum += (p >> shift) & 0xff;
+                }
+                result |= (sum / 4) << shift;
+            }
+            out[x] = result;
+        }
+    }
+
+    cairo_surface_mark_dirty(dest);
+    copy_cairo_surface_ci(src, dest);
+    return dest;
+}
+
+/**
+ * Return the image downsampled the given number of times, which must be at least once, building any
+ * missing levels of the pyramid. The levels are kept with the pixbuf, so everything rendering a shared
+ * pixbuf shares them too. They may be built by several render threads at once.
+ */
+cairo_surface_t *Pixbuf::getMipmap(int level) const
+{
+    auto lock = std::lock_guard(_mipmaps_mutex);
+    while (_mipmaps.size() < static_cast<std::size_t>(level)) {
+        auto const src = _mipmaps.empty() ? _surface : _mipmaps.back();
+        _mipmaps.emplace_back(downsample_half(src));
+    }
+    return _mipmaps[level - 1];
+}
+
+void Pixbuf::_clearMipmaps()
+{
+    auto lock = std::lock_guard(_mipmaps_mutex);
+    for (auto surface : _mipmaps) {
+        cairo_surface_destroy(surface);
+    }
+    _mipmaps.clear();
 }
 
 void Pixbuf::_forceAlpha()
@@ -649,6 +720,9 @@ void Pixbuf::_setMimeData(guchar *data, gsize len, Glib::ustring const &format)
  */
 void Pixbuf::ensurePixelFormat(PixelFormat fmt)
 {
+    if (fmt != _pixel_format) {
+        _clearMipmaps();
+    }
     if (fmt == PF_CAIRO && _pixel_format == PF_GDK) {
         ensure_argb32(_pixbuf);
         _pixel_format = fmt;
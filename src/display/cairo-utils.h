@@ -13,6 +13,9 @@
 #ifndef SEEN_INKSCAPE_DISPLAY_CAIRO_UTILS_H
 #define SEEN_INKSCAPE_DISPLAY_CAIRO_UTILS_H
 
+#include <array>
+#include <mutex>
+#include <vector>
 #include <2geom/forward.h>
 #include <cairomm/cairomm.h>
 #include "style.h"
@@ -55,6 +58,8 @@ public:
     guchar *pixels();
     void markDirty();
 
+    cairo_surface_t *getMipmap(int level) const;
+
     bool hasMimeData() const;
     guchar const *getMimeData(gsize &len, std::string &mimetype) const;
     std::string const &originalPath() const { return _path; }
@@ -78,6 +83,7 @@ public:
     void _ensurePixelsPixbuf();
     void _forceAlpha();
     void _setMimeData(guchar *data, gsize len, Glib::ustring const &format);
+    void _clearMipmaps();
 
     GdkPixbuf *_pixbuf;
     cairo_surface_t *_surface;
@@ -85,6 +91,10 @@ public:
     std::string _path;
     PixelFormat _pixel_format;
     bool _cairo_store;
+
+    // Successively halved copies of the surface, for rendering at small zoom. Built on demand by render threads.
+    mutable std::mutex _mipmaps_mutex;
+    mutable std::vector<cairo_surface_t *> _mipmaps; ///< _mipmaps[i] is the surface downsampled i + 1 times.
 };
 
 } // namespace Inkscape
@@ -151,12 +161,26 @@ premul_alpha(const guint32 color, const guint32 alpha)
     const guint32 temp = alpha * color + 128;
     return (temp + (temp >> 8)) >> 8;
 }
+/**
+ * Fixed-point reciprocals of alpha values: unpremul_reciprocal[a] = ceil(2^24 / a).
+ * For every n < 2^16, (n * unpremul_reciprocal[a]) >> 24 equals n / a exactly, which lets
+ * unpremul_alpha() replace a division by a multiplication.
+ */
+inline constexpr auto unpremul_reciprocal = [] {
+    std::array<guint32, 256> result{};
+    for (guint32 a = 1; a < 256; ++a) {
+        result[a] = ((1u << 24) + a - 1) / a;
+    }
+    return result;
+}();
+
 G_GNUC_CONST inline guint32
 unpremul_alpha(const guint32 color, const guint32 alpha)
 {
     if (color >= alpha)
         return 0xff;
-    return (255 * color + alpha/2) / alpha;
+    // Same as (255 * color + alpha/2) / alpha, but avoids the slow integer division.
+    return (guint64{255 * color + alpha/2} * unpremul_reciprocal[alpha]) >> 24;
 }
 
 // TODO: move those to 2Geom
@@ -18,6 +18,9 @@
 #include "drawing.h"
 #include "style.h"
 
+static constexpr auto SPATIAL_INDEX_THRESHOLD = 64u; ///< Only index groups with at least this many children.
+static constexpr auto SPATIAL_INDEX_MAX_REFITS = 32u; ///< Rebuild the index after this many refits.
+
 namespace Inkscape {
 
 DrawingGroup::DrawingGroup(Drawing &drawing)
@@ -71,15 +74,88 @@ unsigned DrawingGroup::_updateItem(Geom::IntRect const &area, UpdateContext cons
         _contains_unisolated_blend |= c.unisolatedBlend();
     }
 
+    _updateSpatialIndex();
+
     return STATE_ALL;
 }
 
+/**
+ * The area within which a child can be rendered, clipped or picked.
+ */
+static Geom::OptIntRect index_box(DrawingItem const &item)
+{
+    auto box = item.bbox();
+    box.unionWith(item.drawbox());
+    if (auto glyphs = cast<DrawingGlyphs>(&item); glyphs && box) {
+        box.unionWith(glyphs->getPickBox());
+    }
+    return box;
+}
+
+/**
+ * Bring the spatial index of the children up to date with their bounding boxes.
+ *
+ * The index is refitted in linear time if only the bounds of children changed, and rebuilt if
+ * children were added, removed or reordered, or if it has been refitted too many times.
+ */
+void DrawingGroup::_updateSpatialIndex()
+{
+    auto const count = _children.size();
+    if (count < SPATIAL_INDEX_THRESHOLD) {
+        _childrenChanged();
+        return;
+    }
+
+    bool rebuild = !_hasSpatialIndex() || _index_refits >= SPATIAL_INDEX_MAX_REFITS;
+    if (!rebuild) {
+        unsigned i = 0;
+        for (auto &c : _children) {
+            if (!_spatial_index.update(i, index_box(c))) {
+                rebuild = true;
+                break;
+            }
+            i++;
+        }
+    }
+
+    if (rebuild) {
+        std::vector<Geom::OptIntRect> boxes;
+        boxes.reserve(count);
+        _indexed_children.clear();
+        _indexed_children.reserve(count);
+        for (auto &c : _children) {
+            boxes.emplace_back(index_box(c));
+            _indexed_children.emplace_back(&c);
+        }
+        _spatial_index.build(std::move(boxes));
+        _index_refits = 0;
+    } else if (_spatial_index.refit()) {
+        _index_refits++;
+    }
+}
+
+/**
+ * Invalidate the spatial index after a change to the list of children.
+ */
+void DrawingGroup::_childrenChanged()
+{
+    _spatial_index.clear();
+    _indexed_children.clear();
+    _index_refits = 0;
+}
+
 unsigned DrawingGroup::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const
 {
     if (!stop_at) {
         // normal rendering
-        for (auto &i : _children) {
-            i.render(dc, rc, area, flags, stop_at);
+        if (_hasSpatialIndex()) {
+            for (auto i : _spatial_index.query(area)) {
+                _indexed_children[i]->render(dc, rc, area, flags, stop_at);
+            }
+        } else {
+            for (auto &i : _children) {
+                i.render(dc, rc, area, flags, stop_at);
+            }
         }
     } else {
         // background rendering
@@ -101,6 +177,13 @@ unsigned DrawingGroup::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
 
 void DrawingGroup::_clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area) const
 {
+    if (_hasSpatialIndex()) {
+        for (auto i : _spatial_index.query(area)) {
+            _indexed_children[i]->clip(dc, rc, area);
+        }
+        return;
+    }
+
     for (auto &i : _children) {
         i.clip(dc, rc, area);
     }
@@ -108,6 +191,17 @@ void DrawingGroup::_clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRec
 
 DrawingItem *DrawingGroup::_pickItem(Geom::Point const &p, double delta, unsigned flags)
 {
+    if (_hasSpatialIndex()) {
+        auto query = Geom::Rect(p, p);
+        query.expandBy(delta);
+        for (auto i : _spatial_index.query(query.roundOutwards())) {
+            if (auto picked = _indexed_children[i]->pick(p, delta, flags)) {
+                return _pick_children ? picked : this;
+            }
+        }
+        return nullptr;
+    }
+
     for (auto &i : _children) {
         DrawingItem *picked = i.pick(p, delta, flags);
         if (picked) {
@@ -13,7 +13,10 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_GROUP_H
 #define INKSCAPE_DISPLAY_DRAWING_GROUP_H
 
+#include <vector>
+
 #include "display/drawing-item.h"
+#include "util/spatial-index.h"
 
 namespace Inkscape {
 
@@ -37,8 +40,19 @@ protected:
     void _clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area) const override;
     DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
     bool _canClip() const override { return true; }
+    void _childrenChanged() override;
 
     std::unique_ptr<Geom::Affine> _child_transform;
+
+private:
+    void _updateSpatialIndex();
+    bool _hasSpatialIndex() const { return !_indexed_children.empty(); }
+
+    /// For groups with many children: bounds of the children, used to skip children that do not
+    /// overlap the area being rendered or picked. Entry i corresponds to _indexed_children[i].
+    Util::SpatialIndex<Geom::IntCoord> _spatial_index;
+    std::vector<DrawingItem *> _indexed_children; ///< The children in z-order, if indexed.
+    unsigned _index_refits = 0; ///< Number of times the index was refitted since it was built.
 };
 
 } // namespace Inkscape
@@ -10,6 +10,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
 #include <2geom/bezier-curve.h>
 
 #include "drawing.h"
@@ -26,6 +27,8 @@ DrawingImage::DrawingImage(Drawing &drawing)
 {
 }
 
+DrawingImage::~DrawingImage() = default;
+
 void DrawingImage::setPixbuf(std::shared_ptr<Inkscape::Pixbuf const> pixbuf)
 {
     defer([this, pixbuf = std::move(pixbuf)] () mutable {
@@ -116,10 +119,33 @@ unsigned DrawingImage::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
 
         dc.translate(_origin);
         dc.scale(_scale);
+
         // const_cast required since Cairo needs to modify the internal refcount variable, but we do not want to give up the
         // benefits of const for the rest of our code. The underlying object is guaranteed to be non-const, so this is well-defined.
         // It is also thread-safe to modify the refcount in this way, since Cairo uses atomics internally.
-        dc.setSource(const_cast<cairo_surface_t*>(_pixbuf->getSurfaceRaw()), 0, 0);
+        auto surface = const_cast<cairo_surface_t*>(_pixbuf->getSurfaceRaw());
+
+        // When zoomed out, sample the smallest mipmap that still has at least one pixel per device pixel, rather than
+        // filtering the full image every time. Pixelated renderings are left alone, since averaging would blur them.
+        bool const pixelated = style_image_rendering == SP_CSS_IMAGE_RENDERING_OPTIMIZESPEED
+                            || style_image_rendering == SP_CSS_IMAGE_RENDERING_PIXELATED
+                            || style_image_rendering == SP_CSS_IMAGE_RENDERING_CRISPEDGES;
+        if (!pixelated && cairo_image_surface_get_format(surface) == CAIRO_FORMAT_ARGB32) {
+            auto const device = Geom::Affine(_scale) * _ctm;
+            auto const expansion = std::max(device.expansionX(), device.expansionY());
+            int level = 0;
+            for (double e = 2 * expansion; e <= 1.0 && (_pixbuf->width() >> level) > 1 && (_pixbuf->height() >> level) > 1; e *= 2) {
+                level++;
+            }
+            if (level > 0) {
+                // Each level is exactly half the scale of the one below. Its size is rounded up, so at an odd edge
+                // the last pixel reaches past the image, which EXTEND_PAD would have shown anyway.
+                surface = _pixbuf->getMipmap(level);
+                dc.scale(1 << level, 1 << level);
+            }
+        }
+
+        dc.setSource(surface, 0, 0);
         dc.patternSetExtend(CAIRO_EXTEND_PAD);
 
         // See: http://www.w3.org/TR/SVG/painting.html#ImageRenderingProperty
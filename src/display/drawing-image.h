@@ -39,7 +39,7 @@ public:
     Geom::Rect bounds() const;
 
 protected:
-    ~DrawingImage() override = default;
+    ~DrawingImage() override;
 
     unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) override;
     unsigned _renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const override;
@@ -19,6 +19,7 @@
 #include "display/drawing-surface.h"
 #include "display/drawing-text.h"
 #include "display/drawing.h"
+#include "display/filter-result-cache.h"
 
 #include "display/cairo-utils.h"
 #include "display/cairo-templates.h"
@@ -111,6 +112,7 @@ DrawingItem::~DrawingItem()
 
     // Remove from the set of cached items and delete cache.
     _setCached(false, true);
+    _drawing.filterResultCache().drop(this);
 
     _children.clear_and_dispose([] (auto c) { delete c; });
     delete _clip;
@@ -148,6 +150,7 @@ void DrawingItem::appendChild(DrawingItem *item)
 
     defer([=, this] {
         _children.push_back(*item);
+        _childrenChanged();
 
         // This ensures that _markForUpdate() called on the child will recurse to this item
         item->_state = STATE_ALL;
@@ -168,6 +171,7 @@ void DrawingItem::prependChild(DrawingItem *item)
 
     defer([=, this] {
         _children.push_front(*item);
+        _childrenChanged();
         item->_state = STATE_ALL;
         item->_markForUpdate(STATE_ALL, true);
     });
@@ -180,6 +184,7 @@ void DrawingItem::clearChildren()
         if (_children.empty()) return;
         _markForRendering();
         _children.clear_and_dispose([] (auto c) { delete c; });
+        _childrenChanged();
         _markForUpdate(STATE_ALL, false);
     });
 }
@@ -414,6 +419,7 @@ void DrawingItem::setZOrder(unsigned zorder)
         auto it2 = _parent->_children.begin();
         std::advance(it2, std::min<unsigned>(zorder, _parent->_children.size()));
         _parent->_children.insert(it2, *this);
+        _parent->_childrenChanged();
         _markForRendering();
     });
 }
@@ -535,6 +541,7 @@ void DrawingItem::update(Geom::IntRect const &area, UpdateContext const &ctx, un
         if (_cache && _cache->surface) {
             _cache->surface->markDirty();
         }
+        _drawing.filterResultCache().drop(this);
         _dropPatternCache();
     }
 
@@ -735,7 +742,10 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
     Geom::OptIntRect iarea = carea;
     // expand carea to contain the dependent area of filters.
     if (forcecache) {
-        iarea = _cacheRect();
+        // If the result will be cached, render the whole cache area so that later requests for other
+        // parts of it, e.g. while panning, can be served from the cache without running the filter.
+        // Otherwise, only render what is needed for this request.
+        iarea = _cache && !(flags & RENDER_BYPASS_CACHE) ? _cacheRect() : Geom::OptIntRect();
         if (!iarea) {
             iarea = carea;
             _filter->area_enlarge(*iarea, this);
@@ -748,10 +758,22 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
         return RENDER_OK;
     }
 
+    // Items too small to see the shape of are painted as a spot of their average colour, which
+    // also saves the intermediate surface opacity would need. Clips, masks and filters can change
+    // the colour, so those items are rendered in full.
+    if (rc.level_of_detail && !_clip && !_mask && !(_filter && render_filters) && _blend_mode == SP_CSS_BLEND_NORMAL
+        && !(flags & RENDER_FILTER_BACKGROUND))
+    {
+        if (_renderSplat(dc, _opacity)) {
+            return RENDER_OK;
+        }
+    }
+
     // Device scale for HiDPI screens (typically 1 or 2)
     int const device_scale = dc.surface()->device_scale();
 
     std::unique_lock<std::mutex> lock;
+    std::optional<FilterResultCache::Key> result_key;
 
     // Render from cache if possible, unless requested not to (hatches).
     if (_cache && !(flags & RENDER_BYPASS_CACHE)) {
@@ -765,6 +787,9 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
             dc.setOperator(ink_css_blend_to_cairo_operator(_blend_mode));
             _cache->surface->paintFromCache(dc, carea, forcecache);
             if (!carea) {
+                if (forcecache) {
+                    _drawing._filter_cache_hits.fetch_add(1, std::memory_order_relaxed);
+                }
                 dc.setSource(0, 0, 0, 0);
                 return RENDER_OK;
             }
@@ -781,6 +806,32 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
         if (!forcecache) {
             lock.unlock(); // Only hold the lock for the full duration of rendering for filters.
         }
+    } else if (forcecache && !(flags & RENDER_BYPASS_CACHE) && !_filter->uses_background()) {
+        // Filtered items not picked for caching keep their recent results in a shared cache instead,
+        // so that rendering the same area again does not run the filter. The background of a filter
+        // can change without this item being marked for rendering, so those results are not kept.
+        auto const &m = _ctm;
+        result_key = FilterResultCache::Key{
+            .item = this,
+            .filter = _filter.get(),
+            .ctm = { m[0], m[1], m[2], m[3], m[4], m[5] },
+            .area = { carea->left(), carea->top(), carea->right(), carea->bottom() },
+            .device_scale = device_scale,
+            .filter_quality = _drawing.filterQuality(),
+            .blur_quality = _drawing.blurQuality(),
+            .flags = flags,
+            .antialiasing = rc.antialiasing_override ? static_cast<int>(*rc.antialiasing_override) : -1,
+            .dithering = rc.dithering
+        };
+        if (auto result = _drawing.filterResultCache().get(*result_key)) {
+            _drawing._filter_cache_hits.fetch_add(1, std::memory_order_relaxed);
+            dc.rectangle(*carea);
+            dc.setSource(result.get());
+            dc.setOperator(ink_css_blend_to_cairo_operator(_blend_mode));
+            dc.fill();
+            dc.setSource(0, 0, 0, 0);
+            return RENDER_OK;
+        }
     } else {
         // if our caching was turned off after the last update, it was already deleted in setCached()
     }
@@ -876,6 +927,7 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
 
     // 4. Apply filter.
     if (_filter && render_filters) {
+        _drawing._filter_cache_misses.fetch_add(1, std::memory_order_relaxed);
         bool rendered = false;
         if (_filter->uses_background() && _background_accumulate) {
             auto bg_root = this;
@@ -922,6 +974,15 @@ unsigned DrawingItem::render(DrawingContext &dc, RenderContext &rc, Geom::IntRec
         cachect.setSource(&intermediate);
         cachect.fill();
         _cache->surface->markClean(*carea);
+    } else if (result_key) {
+        auto result = std::make_shared<DrawingSurface>(*carea, device_scale);
+        {
+            auto resultct = DrawingContext(*result);
+            resultct.setOperator(CAIRO_OPERATOR_SOURCE);
+            resultct.setSource(&intermediate);
+            resultct.paint();
+        }
+        _drawing.filterResultCache().put(*result_key, std::move(result));
     }
 
     dc.rectangle(*carea);
@@ -946,7 +1007,8 @@ unsigned DrawingItem::render(DrawingContext &dc, Geom::IntRect const &area, unsi
     auto rc = RenderContext{
         .outline_color = 0xff,
         .antialiasing_override = _drawing._antialiasing_override,
-        .dithering = _drawing._use_dithering
+        .dithering = _drawing._use_dithering,
+        .level_of_detail = _drawing._level_of_detail
     };
     return render(dc, rc, area, flags);
 }
@@ -1124,6 +1186,7 @@ void DrawingItem::_markForRendering()
         if (i->_cache && i->_cache->surface) {
             i->_cache->surface->markDirty(*dirty);
         }
+        _drawing.filterResultCache().drop(i);
         i->_dropPatternCache();
         if (i->_background_accumulate) {
             bkg_root = i;
@@ -1309,6 +1372,7 @@ void DrawingItem::unlink()
             case ChildType::NORMAL: {
                 auto it = _parent->_children.iterator_to(*this);
                 _parent->_children.erase(it);
+                _parent->_childrenChanged();
                 break;
             }
             case ChildType::CLIP:
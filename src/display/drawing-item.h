@@ -53,6 +53,7 @@ struct RenderContext
     std::uint32_t outline_color;
     std::optional<Antialiasing> antialiasing_override;
     bool dithering = false;
+    bool level_of_detail = false; ///< Whether items much smaller than a pixel may be approximated.
 };
 
 struct UpdateContext
@@ -192,9 +193,12 @@ protected:
     virtual unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) { return 0; }
     virtual unsigned _renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const { return RENDER_OK; }
     virtual void _clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area) const {}
+    /// Paint an approximation of an item much smaller than a pixel, if it can be approximated.
+    virtual bool _renderSplat(DrawingContext &dc, double opacity) const { return false; }
     virtual DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) { return nullptr; }
     virtual bool _canClip() const { return false; }
     virtual void _dropPatternCache() {}
+    virtual void _childrenChanged() {}
 
     Drawing &_drawing;
     DrawingItem *_parent;
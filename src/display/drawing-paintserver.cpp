@@ -1,12 +1,18 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 #include "drawing-paintserver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
 #include "cairo-utils.h"
 
 namespace Inkscape {
 
 DrawingPaintServer::~DrawingPaintServer() = default;
 
-cairo_pattern_t *DrawingSolidColor::create_pattern(cairo_t *, Geom::OptRect const &, double opacity) const
+cairo_pattern_t *DrawingSolidColor::create_pattern(cairo_t *, Geom::OptRect const &, double opacity, bool) const
 {
     return cairo_pattern_create_rgba(c[0], c[1], c[2], alpha * opacity);
 }
@@ -28,16 +34,102 @@ void DrawingGradient::common_setup(cairo_pattern_t *pat, Geom::OptRect const &bb
     }
 
     // set pattern transform matrix
+    ink_cairo_pattern_set_matrix(pat, gradient_to_user(bbox).inverse());
+}
+
+Geom::Affine DrawingGradient::gradient_to_user(Geom::OptRect const &bbox) const
+{
     auto gs2user = transform;
     if (units == SP_GRADIENT_UNITS_OBJECTBOUNDINGBOX && bbox) {
         auto bbox2user = Geom::Affine(bbox->width(), 0, 0, bbox->height(), bbox->left(), bbox->top());
         gs2user *= bbox2user;
     }
-    ink_cairo_pattern_set_matrix(pat, gs2user.inverse());
+    return gs2user;
 }
 
-cairo_pattern_t *DrawingLinearGradient::create_pattern(cairo_t *, Geom::OptRect const &bbox, double opacity) const
+GradientLut::~GradientLut()
 {
+    for (auto &[opacity, table] : tables) {
+        cairo_surface_destroy(table);
+    }
+}
+
+cairo_surface_t *GradientLut::get(double opacity)
+{
+    // Enough for the opacities a gradient is typically painted with at once.
+    std::size_t constexpr MAX_TABLES = 4;
+
+    auto lock = std::lock_guard(mutables);
+
+    for (auto &[o, table] : tables) {
+        if (o == opacity) {
+            return cairo_surface_reference(table);
+        }
+    }
+
+    auto const table = build(opacity);
+    if (!table) {
+        return nullptr;
+    }
+    if (tables.size() == MAX_TABLES) {
+        cairo_surface_destroy(tables.front().second);
+        tables.erase(tables.begin());
+    }
+    tables.emplace_back(opacity, table);
+    return cairo_surface_reference(table);
+}
+
+cairo_surface_t *GradientLut::build(double opacity) const
+{
+    if (stops.empty()) {
+        return nullptr;
+    }
+
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, SIZE, 1);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        return nullptr;
+    }
+    cairo_surface_flush(surface);
+    auto const data = reinterpret_cast<std::uint32_t *>(cairo_image_surface_get_data(surface));
+
+    // Entry i holds the colour at the centre of the i'th interval, interpolated without premultiplication like Cairo.
+    std::size_t next = 0;
+    for (int i = 0; i < SIZE; i++) {
+        double const t = (i + 0.5) / SIZE;
+        while (next < stops.size() && stops[next].offset <= t) {
+            next++;
+        }
+        auto const &a = stops[next == 0 ? 0 : next - 1];
+        auto const &b = stops[next == stops.size() ? next - 1 : next];
+        double const f = b.offset > a.offset ? (t - a.offset) / (b.offset - a.offset) : 0.0;
+        auto lerp = [f] (double u, double v) { return u + (v - u) * f; };
+
+        double const alpha = lerp(a.opacity, b.opacity) * opacity;
+        auto channel = [&] (double c) { return static_cast<std::uint32_t>(std::lround(std::clamp(c, 0.0, 1.0) * 255.0)); };
+        std::uint32_t const pa = channel(alpha);
+        std::uint32_t const pr = channel(lerp(a.color.v.c[0], b.color.v.c[0]) * alpha);
+        std::uint32_t const pg = channel(lerp(a.color.v.c[1], b.color.v.c[1]) * alpha);
+        std::uint32_t const pb = channel(lerp(a.color.v.c[2], b.color.v.c[2]) * alpha);
+        ASSEMBLE_ARGB32(px, pa, pr, pg, pb)
+        data[i] = px;
+    }
+    cairo_surface_mark_dirty(surface);
+
+    return surface;
+}
+
+cairo_pattern_t *DrawingLinearGradient::create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity, bool dither) const
+{
+    // Sampling a table is much cheaper for Pixman than evaluating the gradient at every pixel,
+    // but it has only 8 bits of precision, so cannot be used when dithering. Without Cairo 1.18,
+    // there is no dithering, so the table is always used.
+    if (!dither) {
+        if (auto pat = create_lut_pattern(ct, bbox, opacity)) {
+            return pat;
+        }
+    }
+
     auto pat = cairo_pattern_create_linear(x1, y1, x2, y2);
 
     common_setup(pat, bbox, opacity);
@@ -51,7 +143,54 @@ cairo_pattern_t *DrawingLinearGradient::create_pattern(cairo_t *, Geom::OptRect
     return pat;
 }
 
-cairo_pattern_t *DrawingRadialGradient::create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const
+cairo_pattern_t *DrawingLinearGradient::create_lut_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const
+{
+    if (stops.empty()) {
+        return nullptr;
+    }
+
+    auto const gs2user = gradient_to_user(bbox);
+    auto const d = Geom::Point(x2 - x1, y2 - y1);
+    auto const len2 = d.lengthSq();
+    if (len2 == 0.0 || gs2user.isSingular()) {
+        return nullptr;
+    }
+
+    // Measure the gradient vector on the device. The device scale is not part of the CTM, so allow for a factor of 2.
+    auto d_device = d * gs2user.withoutTranslation();
+    double dx = d_device.x(), dy = d_device.y();
+    cairo_user_to_device_distance(ct, &dx, &dy);
+    double const length = 2.0 * std::hypot(dx, dy);
+
+    // Once table entries are larger than a pixel, closely spaced stops would be visibly blurred.
+    if (length > GradientLut::SIZE) {
+        for (std::size_t i = 1; i < stops.size(); i++) {
+            if (stops[i].offset - stops[i - 1].offset < 4.0 / GradientLut::SIZE) {
+                return nullptr;
+            }
+        }
+    }
+
+    auto const surface = lut->get(opacity);
+    if (!surface) {
+        return nullptr;
+    }
+
+    auto pat = cairo_pattern_create_for_surface(surface);
+    cairo_surface_destroy(surface);
+
+    common_setup(pat, bbox, opacity);
+    cairo_pattern_set_filter(pat, CAIRO_FILTER_BILINEAR);
+
+    // Map the gradient vector onto the table, with an arbitrary perpendicular direction to keep the matrix invertible.
+    auto const gs2lut = Geom::Translate(-x1, -y1) * Geom::Affine(GradientLut::SIZE * d.x() / len2, d.y() / len2,
+                                                                 GradientLut::SIZE * d.y() / len2, -d.x() / len2, 0, 0);
+    ink_cairo_pattern_set_matrix(pat, gs2user.inverse() * gs2lut);
+
+    return pat;
+}
+
+cairo_pattern_t *DrawingRadialGradient::create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity, bool) const
 {
     Geom::Point focus(fx, fy);
     Geom::Point center(cx, cy);
@@ -61,12 +200,7 @@ cairo_pattern_t *DrawingRadialGradient::create_pattern(cairo_t *ct, Geom::OptRec
     double scale = 1.0;
     double tolerance = cairo_get_tolerance(ct);
 
-    Geom::Affine gs2user = transform;
-
-    if (units == SP_GRADIENT_UNITS_OBJECTBOUNDINGBOX && bbox) {
-        Geom::Affine bbox2user(bbox->width(), 0, 0, bbox->height(), bbox->left(), bbox->top());
-        gs2user *= bbox2user;
-    }
+    Geom::Affine gs2user = gradient_to_user(bbox);
 
     // we need to use vectors with the same direction to represent the transformed
     // radius and the focus-center delta, because gs2user might contain non-uniform scaling
@@ -109,7 +243,7 @@ cairo_pattern_t *DrawingRadialGradient::create_pattern(cairo_t *ct, Geom::OptRec
     return pat;
 }
 
-cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *, Geom::OptRect const &bbox, double opacity) const
+cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *, Geom::OptRect const &bbox, double opacity, bool) const
 {
 #ifdef MESH_DEBUG
     std::cout << "sp_meshgradient_create_pattern: " << bbox << " " << opacity << std::endl;
@@ -160,12 +294,7 @@ cairo_pattern_t *DrawingMeshGradient::create_pattern(cairo_t *, Geom::OptRect co
     }
 
     // set pattern transform matrix
-    Geom::Affine gs2user = transform;
-    if (units == SP_GRADIENT_UNITS_OBJECTBOUNDINGBOX && bbox) {
-        Geom::Affine bbox2user(bbox->width(), 0, 0, bbox->height(), bbox->left(), bbox->top());
-        gs2user *= bbox2user;
-    }
-    ink_cairo_pattern_set_matrix(pat, gs2user.inverse());
+    ink_cairo_pattern_set_matrix(pat, gradient_to_user(bbox).inverse());
 
     return pat;
 }
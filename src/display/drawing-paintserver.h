@@ -12,6 +12,9 @@
  */
 
 #include <array>
+#include <memory>
+#include <mutex>
+#include <utility>
 #include <vector>
 #include <cairo.h>
 #include <2geom/rect.h>
@@ -38,7 +41,9 @@ public:
     virtual ~DrawingPaintServer() = 0;
 
     /// Produce a pattern that can be used for painting with Cairo.
-    virtual cairo_pattern_t *create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const = 0;
+    /// If dither is true, the pattern will be dithered, so it must keep the full precision of the paint.
+    /// It is only true if ditherable() returns true.
+    virtual cairo_pattern_t *create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity, bool dither) const = 0;
 
     /// Return whether this paint server could benefit from dithering.
     virtual bool ditherable() const { return false; }
@@ -60,7 +65,7 @@ public:
         : c({c[0], c[1], c[2]})
         , alpha(alpha) {}
 
-    cairo_pattern_t *create_pattern(cairo_t *, Geom::OptRect const &, double opacity) const override;
+    cairo_pattern_t *create_pattern(cairo_t *, Geom::OptRect const &, double opacity, bool) const override;
 
 private:
     std::array<float, 3> c; ///< RGB color components.
@@ -79,16 +84,50 @@ protected:
         , units(units)
         , transform(transform) {}
 
-    bool ditherable() const override { return true; }
+    /// Dithering needs Cairo 1.18; before that, gradients are never dithered.
+    bool ditherable() const override { return CAIRO_VERSION >= CAIRO_VERSION_ENCODE(1, 18, 0); }
 
     /// Perform some common initialization steps on the given Cairo pattern.
     void common_setup(cairo_pattern_t *pat, Geom::OptRect const &bbox, double opacity) const;
 
+    /// Return the transformation from gradient space to user space.
+    Geom::Affine gradient_to_user(Geom::OptRect const &bbox) const;
+
     SPGradientSpread spread;
     SPGradientUnits units;
     Geom::Affine transform;
 };
 
+/**
+ * A table of premultiplied colours sampled along a gradient vector, used to paint linear gradients.
+ *
+ * It is built once for each gradient vector, and shared by all the paint servers made from it. The
+ * table for a given paint opacity is built when first asked for, and the last few are kept.
+ */
+class GradientLut
+{
+public:
+    /// The number of colours in a table.
+    static int constexpr SIZE = 1024;
+
+    explicit GradientLut(std::vector<SPGradientStop> stops)
+        : stops(std::move(stops)) {}
+    ~GradientLut();
+
+    GradientLut(GradientLut const &) = delete;
+    GradientLut &operator=(GradientLut const &) = delete;
+
+    /// Return a new reference to the SIZE x 1 table for the given paint opacity, or null on failure.
+    cairo_surface_t *get(double opacity);
+
+private:
+    std::vector<SPGradientStop> const stops;
+    std::mutex mutables;
+    std::vector<std::pair<double, cairo_surface_t *>> tables; ///< By opacity, most recently built last.
+
+    cairo_surface_t *build(double opacity) const;
+};
+
 /**
  * A linear gradient.
  */
@@ -97,19 +136,25 @@ class DrawingLinearGradient final
 {
 public:
     DrawingLinearGradient(SPGradientSpread spread, SPGradientUnits units, Geom::Affine const &transform,
-                          float x1, float y1, float x2, float y2, std::vector<SPGradientStop> stops)
+                          float x1, float y1, float x2, float y2, std::vector<SPGradientStop> stops,
+                          std::shared_ptr<GradientLut> lut = {})
         : DrawingGradient(spread, units, transform)
         , x1(x1)
         , y1(y1)
         , x2(x2)
         , y2(y2)
-        , stops(std::move(stops)) {}
+        , stops(std::move(stops))
+        , lut(lut ? std::move(lut) : std::make_shared<GradientLut>(this->stops)) {}
 
-    cairo_pattern_t *create_pattern(cairo_t*, Geom::OptRect const &bbox, double opacity) const override;
+    cairo_pattern_t *create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity, bool dither) const override;
 
 private:
     float x1, y1, x2, y2;
     std::vector<SPGradientStop> stops;
+    std::shared_ptr<GradientLut> lut; ///< Built from the same stops.
+
+    /// Produce a pattern sampling a lookup table of premultiplied colours, or null if that would be visibly inaccurate.
+    cairo_pattern_t *create_lut_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const;
 };
 
 /**
@@ -130,7 +175,7 @@ public:
         , fr(fr)
         , stops(std::move(stops)) {}
 
-    cairo_pattern_t *create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity) const override;
+    cairo_pattern_t *create_pattern(cairo_t *ct, Geom::OptRect const &bbox, double opacity, bool) const override;
 
     bool uses_cairo_ctx() const override { return true; }
 
@@ -163,7 +208,7 @@ public:
         , cols(cols)
         , patchdata(std::move(patchdata)) {}
 
-    cairo_pattern_t *create_pattern(cairo_t*, Geom::OptRect const &bbox, double opacity) const override;
+    cairo_pattern_t *create_pattern(cairo_t*, Geom::OptRect const &bbox, double opacity, bool) const override;
 
 private:
     int rows;
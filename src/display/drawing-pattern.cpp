@@ -10,6 +10,8 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <array>
+#include <cmath>
 #include <cairomm/region.h>
 #include <cairo.h>
 #include "cairo-utils.h"
@@ -23,17 +25,17 @@
 
 namespace Inkscape {
 
-DrawingPattern::Surface::Surface(Geom::IntRect const &rect, int device_scale)
-    : rect(rect)
-    , surface(Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, rect.width() * device_scale, rect.height() * device_scale))
-{
-    cairo_surface_set_device_scale(surface->cobj(), device_scale, device_scale);
-}
-
 DrawingPattern::DrawingPattern(Drawing &drawing)
     : DrawingGroup(drawing)
     , _overflow_steps(1)
 {
+    drawing.patternTileCache().acquire(_contentKey());
+}
+
+DrawingPattern::~DrawingPattern()
+{
+    // Other views of the same pattern may still use the tiles, which are only dropped along with the last of them.
+    drawing().patternTileCache().release(_contentKey());
 }
 
 void DrawingPattern::setPatternToUserTransform(Geom::Affine const &transform)
@@ -65,6 +67,17 @@ void DrawingPattern::setOverflow(Geom::Affine const &initial_transform, int step
     });
 }
 
+void DrawingPattern::setContentKey(void const *key)
+{
+    defer([=, this] {
+        if (key == _content_key) return;
+        auto &cache = drawing().patternTileCache();
+        cache.release(_contentKey());
+        _content_key = key;
+        cache.acquire(_contentKey());
+    });
+}
+
 cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect const &area, float opacity, int device_scale) const
 {
     if (opacity < 1e-3) {
@@ -144,9 +157,31 @@ cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect
     auto const area_orig = (Geom::Rect(area) * screen_to_tile).roundOutwards();
     auto const area_tile = canonicalised(area_orig);
 
-    // Simplest solution for now to protecting pattern cache is a mutex. This makes all
-    // pattern rendering single-threaded, however patterns are typically not the bottleneck.
-    auto lock = std::lock_guard(mutables);
+    // Look up the tiles shared by all patterns rendering the same content with the same parameters.
+    auto to_array = [] (Geom::Affine const &a) {
+        return std::array{a[0], a[1], a[2], a[3], a[4], a[5]};
+    };
+    auto const key = PatternTileCache::Key{
+        .content = _contentKey(),
+        .tile_rect = {_tile_rect->left(), _tile_rect->top(), _tile_rect->right(), _tile_rect->bottom()},
+        .child_transform = to_array(_child_transform ? *_child_transform : Geom::identity()),
+        .overflow_initial = to_array(_overflow_initial_transform),
+        .overflow_step = to_array(_overflow_step_transform),
+        .overflow_steps = _overflow_steps,
+        .resolution = {_pattern_resolution.x(), _pattern_resolution.y()},
+        .opacity = opacity,
+        .device_scale = device_scale,
+        .antialiasing = rc.antialiasing_override ? static_cast<int>(*rc.antialiasing_override) : -1,
+        .outline_color = rc.outline_color,
+        .dithering = rc.dithering
+    };
+    auto &cache = drawing().patternTileCache();
+    auto const tiles = cache.get(key);
+    auto &surfaces = tiles->surfaces;
+
+    // The tiles are protected by a mutex. This serialises the rendering of each tile, but different
+    // patterns, or the same pattern at different resolutions, can still be rendered concurrently.
+    auto lock = std::lock_guard(tiles->mutex);
 
     auto get_surface = [&, this] () -> std::pair<Surface*, Cairo::RefPtr<Cairo::Region>> {
         // If there is a rectangle containing the requested area, just use that.
@@ -252,6 +287,7 @@ cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect
             }
         }
         dirty.clear();
+        cache.resize(key, tiles->size());
     }
 
     // Debug: Show pattern tile.
@@ -270,8 +306,6 @@ cairo_pattern_t *DrawingPattern::renderPattern(RenderContext &rc, Geom::IntRect
 
 unsigned DrawingPattern::_updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset)
 {
-    _dropPatternCache();
-
     if (!_tile_rect || _tile_rect->hasZeroArea()) {
         return STATE_NONE;
     }
@@ -280,6 +314,8 @@ unsigned DrawingPattern::_updateItem(Geom::IntRect const &area, UpdateContext co
     double const det_ctm = ctx.ctm.det();
     double const det_ps2user = _pattern_to_user ? _pattern_to_user->det() : 1.0;
     double scale = std::sqrt(std::abs(det_ctm * det_ps2user));
+    // Round the scale up to an eighth of an octave, so that patterns on items at similar scales share tiles.
+    scale = std::exp2(std::ceil(std::log2(scale) * 8) / 8);
     // Fixme: When scale is too big (zooming in a pattern), Cairo doesn't render the pattern.
     // More precisely it fails when setting pattern matrix in DrawingPattern::renderPattern.
     // Correct solution should make use of visible area and change pattern tile rect accordingly.
@@ -295,7 +331,7 @@ unsigned DrawingPattern::_updateItem(Geom::IntRect const &area, UpdateContext co
 
 void DrawingPattern::_dropPatternCache()
 {
-    surfaces.clear();
+    drawing().patternTileCache().drop(_contentKey());
 }
 
 } // namespace Inkscape
@@ -13,9 +13,9 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_PATTERN_H
 #define INKSCAPE_DISPLAY_DRAWING_PATTERN_H
 
-#include <mutex>
 #include <cairomm/surface.h>
 #include "drawing-group.h"
+#include "pattern-tile-cache.h"
 
 using cairo_pattern_t = struct _cairo_pattern;
 
@@ -55,6 +55,15 @@ public:
      */
     void setOverflow(Geom::Affine const &initial_transform, int steps, Geom::Affine const &step_transform);
 
+    /**
+     * Share rendered tiles with the other patterns in the drawing that have the same content key.
+     *
+     * Patterns with the same key must render the same content given the same tile rect, child transform,
+     * overflow and resolution. The key must stay unique for as long as this pattern exists. If no key
+     * is set, tiles are not shared.
+     */
+    void setContentKey(void const *key);
+
     /**
      * Render the pattern.
      *
@@ -63,7 +72,7 @@ public:
     cairo_pattern_t *renderPattern(RenderContext &rc, Geom::IntRect const &area, float opacity, int device_scale) const;
 
 protected:
-    ~DrawingPattern() override = default;
+    ~DrawingPattern() override;
 
     unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) override;
 
@@ -78,20 +87,14 @@ protected:
 
     Geom::OptRect _tile_rect;
 
+    void const *_content_key = nullptr;
+
     // Set on update.
     Geom::IntPoint _pattern_resolution;
 
-    struct Surface
-    {
-        Surface(Geom::IntRect const &rect, int device_scale);
-        Geom::IntRect rect;
-        Cairo::RefPtr<Cairo::ImageSurface> surface;
-    };
-
-    mutable std::mutex mutables;
+    using Surface = PatternTileCache::Surface;
 
-    // Parts of the pattern tile that have been rendered. Read/written on render, cleared on update.
-    mutable std::vector<Surface> surfaces;
+    void const *_contentKey() const { return _content_key ? _content_key : this; }
 };
 
 } // namespace Inkscape
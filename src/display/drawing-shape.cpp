@@ -22,6 +22,7 @@
 #include "drawing.h"
 #include "drawing-context.h"
 #include "drawing-shape.h"
+#include "flattened-path.h"
 #include "control/canvas-item-drawing.h"
 
 #include "helper/geom.h"
@@ -42,11 +43,46 @@ DrawingShape::DrawingShape(Drawing &drawing)
 {
 }
 
+namespace {
+
+/**
+ * Approximate the area enclosed by a path and its length, from a few points on each curve.
+ * This is only used to paint items smaller than a pixel, so it need not be exact.
+ */
+std::pair<double, double> approximate_area_and_length(Geom::PathVector const &pathv)
+{
+    constexpr int samples = 4;
+    double area = 0.0;
+    double length = 0.0;
+    for (auto const &path : pathv) {
+        if (path.empty()) {
+            continue;
+        }
+        auto prev = path.initialPoint();
+        for (auto const &curve : path) {
+            int const n = curve.isLineSegment() ? 1 : samples;
+            for (int i = 1; i <= n; ++i) {
+                auto const p = i == n ? curve.finalPoint() : curve.pointAt(static_cast<double>(i) / n);
+                area += Geom::cross(p, prev);
+                length += Geom::distance(prev, p);
+                prev = p;
+            }
+        }
+        // Fills close open subpaths.
+        area += Geom::cross(path.initialPoint(), prev);
+    }
+    return { std::abs(area) * 0.5, length };
+}
+
+} // namespace
+
 void DrawingShape::setPath(std::shared_ptr<SPCurve const> curve)
 {
     defer([this, curve = std::move(curve)] () mutable {
         _markForRendering();
         _curve = std::move(curve);
+        _flat.reset();
+        _measure.reset();
         _markForUpdate(STATE_ALL, false);
     });
 }
@@ -99,7 +135,7 @@ unsigned DrawingShape::_updateItem(Geom::IntRect const &area, UpdateContext cons
         _nrstyle.invalidate();
     }
 
-    auto calc_curve_bbox = [&, this] () -> Geom::OptIntRect {
+    auto calc_curve_bbox = [&, this] () -> Geom::OptRect {
         if (!_curve) {
             return {};
         }
@@ -109,87 +145,170 @@ unsigned DrawingShape::_updateItem(Geom::IntRect const &area, UpdateContext cons
             return {};
         }
 
-        float stroke_max = 0.0f;
+        auto const stroke_max = _strokeExtent(ctx.ctm);
 
-        // Get the normal stroke.
-        if (_drawing.renderMode() != RenderMode::OUTLINE && _nrstyle.data.stroke.type != NRStyleData::PaintType::NONE) {
-            // Expand by stroke width.
-            stroke_max = _nrstyle.data.stroke_width * 0.5f;
+        // Apply expansion if non-zero.
+        if (stroke_max > 0.01) {
+            rect->expandBy(stroke_max);
+        }
 
-            // Scale by view transformation, unless vector effect stroke.
-            if (!style_vector_effect_stroke) {
-                stroke_max *= max_expansion(ctx.ctm);
-            }
+        return rect;
+    };
 
-            // Cap minimum line width if asked.
-            if (_drawing.renderMode() == RenderMode::VISIBLE_HAIRLINES || style_stroke_extensions_hairline) {
-                stroke_max = std::max(stroke_max, 0.5f);
-            }
+    if (flags & STATE_BBOX) {
+        _curve_bounds = calc_curve_bbox();
+        _bbox = _curve_bounds ? _curve_bounds->roundOutwards() : Geom::OptIntRect();
+
+        for (auto &c : _children) {
+            _bbox.unionWith(c.bbox());
+        }
+    }
+
+    return _state | flags;
+}
+
+/**
+ * The furthest distance in drawing coordinates that the stroke drawn by the current render mode
+ * reaches from the path, apart from caps, given the transform from user to drawing coordinates.
+ */
+float DrawingShape::_strokeExtent(Geom::Affine const &ctm) const
+{
+    float stroke_max = 0.0f;
+
+    // Get the normal stroke.
+    if (_drawing.renderMode() != RenderMode::OUTLINE && _nrstyle.data.stroke.type != NRStyleData::PaintType::NONE) {
+        // Expand by stroke width.
+        stroke_max = _nrstyle.data.stroke_width * 0.5f;
+
+        // Scale by view transformation, unless vector effect stroke.
+        if (!style_vector_effect_stroke) {
+            stroke_max *= max_expansion(ctm);
         }
 
-        // Get the outline stroke.
-        if (_drawing.renderMode() == RenderMode::OUTLINE || _drawing.outlineOverlay()) {
+        // Cap minimum line width if asked.
+        if (_drawing.renderMode() == RenderMode::VISIBLE_HAIRLINES || style_stroke_extensions_hairline) {
             stroke_max = std::max(stroke_max, 0.5f);
         }
+    }
 
-        if (stroke_max > 0.0f) {
-            // Expand by mitres, if present.
-            if (_nrstyle.data.line_join == CAIRO_LINE_JOIN_MITER && _nrstyle.data.miter_limit >= 1.0f) {
-                stroke_max *= _nrstyle.data.miter_limit;
-            }
+    // Get the outline stroke.
+    if (_drawing.renderMode() == RenderMode::OUTLINE || _drawing.outlineOverlay()) {
+        stroke_max = std::max(stroke_max, 0.5f);
+    }
 
-            // Apply expansion if non-zero.
-            if (stroke_max > 0.01) {
-                rect->expandBy(stroke_max);
-            }
-        }
+    // Expand by mitres, if present.
+    if (_nrstyle.data.line_join == CAIRO_LINE_JOIN_MITER && _nrstyle.data.miter_limit >= 1.0f) {
+        stroke_max *= _nrstyle.data.miter_limit;
+    }
 
-        return rect->roundOutwards();
-    };
+    return stroke_max;
+}
 
-    if (flags & STATE_BBOX) {
-        _bbox = calc_curve_bbox();
+/**
+ * Get the path flattened at the current transform, for rendering an area of it, or null if the
+ * path should be fed to Cairo as it is.
+ *
+ * Must be called with the context in drawing coordinates.
+ */
+std::shared_ptr<FlattenedPath const> DrawingShape::_flatPath(DrawingContext &dc, Geom::IntRect const &area) const
+{
+    // Only shapes rendered in several pieces gain from the cache. Vector surfaces keep the curves.
+    if (area.contains(_bbox) || cairo_surface_get_type(cairo_get_group_target(dc.raw())) != CAIRO_SURFACE_TYPE_IMAGE) {
+        return {};
+    }
 
-        for (auto &c : _children) {
-            _bbox.unionWith(c.bbox());
+    // Flatten as finely as Cairo does by default, in device pixels.
+    double dx = 1.0, dy = 0.0;
+    dc.user_to_device_distance(dx, dy);
+    auto const scale = std::hypot(dx, dy) * dc.surface()->device_scale();
+    if (scale <= 0.0) {
+        return {};
+    }
+    auto const tolerance = 0.1 / scale;
+
+    auto lock = std::lock_guard(_flat_mutex);
+    if (!_flat || _flat->ctm() != _ctm || _flat->tolerance() != tolerance) {
+        _flat = std::make_shared<FlattenedPath const>(_curve->get_pathvector(), _ctm, tolerance);
+    }
+    if (!_flat->valid()) {
+        return {};
+    }
+    return _flat;
+}
+
+/**
+ * Feed the path for filling an area, and leave the context in the coordinates of the item.
+ * Must be called with the context in drawing coordinates.
+ */
+void DrawingShape::_feedFill(DrawingContext &dc, FlattenedPath const *flat, Geom::IntRect const &area) const
+{
+    if (flat) {
+        flat->feedFill(dc, area);
+        dc.transform(_ctm);
+    } else {
+        dc.transform(_ctm);
+        dc.path(_curve->get_pathvector());
+    }
+}
+
+/**
+ * Feed the path for stroking an area up to margin away from the path, and leave the context in
+ * the coordinates the stroke is drawn in. Must be called with the context in drawing coordinates.
+ */
+void DrawingShape::_feedStroke(DrawingContext &dc, FlattenedPath const *flat, Geom::IntRect const &area, double margin) const
+{
+    if (flat) {
+        // Dashes would restart at the cuts, so dashed strokes are fed whole.
+        if (_nrstyle.data.dash.empty()) {
+            flat->feedStroke(dc, area, margin);
+        } else {
+            flat->feed(dc);
         }
+    } else {
+        Inkscape::DrawingContext::Save save(dc);
+        dc.transform(_ctm);
+        dc.path(_curve->get_pathvector());
     }
 
-    return _state | flags;
+    if (!style_vector_effect_stroke) {
+        dc.transform(_ctm);
+    }
 }
 
 void DrawingShape::_renderFill(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area) const
 {
     Inkscape::DrawingContext::Save save(dc);
-    dc.transform(_ctm);
-
-    auto has_fill = _nrstyle.prepareFill(dc, rc, area, _item_bbox, _fill_pattern);
+    CairoPatternUniqPtr has_fill;
+    {
+        Inkscape::DrawingContext::Save save(dc);
+        dc.transform(_ctm);
+        has_fill = _nrstyle.prepareFill(dc, rc, area, _item_bbox, _fill_pattern);
+    }
 
     if (has_fill) {
-        dc.path(_curve->get_pathvector());
+        auto const flat = _flatPath(dc, area);
+        _feedFill(dc, flat.get(), area);
         _nrstyle.applyFill(dc, has_fill);
-        dc.fillPreserve();
-        dc.newPath(); // clear path
+        dc.fill();
     }
 }
 
 void DrawingShape::_renderStroke(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags) const
 {
     Inkscape::DrawingContext::Save save(dc);
-    dc.transform(_ctm);
-
-    auto has_stroke = _nrstyle.prepareStroke(dc, rc, area, _item_bbox, _stroke_pattern);
+    CairoPatternUniqPtr has_stroke;
+    {
+        Inkscape::DrawingContext::Save save(dc);
+        dc.transform(_ctm);
+        has_stroke = _nrstyle.prepareStroke(dc, rc, area, _item_bbox, _stroke_pattern);
+    }
     if (!style_stroke_extensions_hairline && _nrstyle.data.stroke_width == 0) {
         has_stroke.reset();
     }
 
     if (has_stroke) {
-        // TODO: remove segments outside of bbox when no dashes present
-        dc.path(_curve->get_pathvector());
-        if (style_vector_effect_stroke) {
-            dc.restore();
-            dc.save();
-        }
+        auto const flat = _flatPath(dc, area);
+        _feedStroke(dc, flat.get(), area, _strokeExtent(_ctm) * 1.5 + 1.0);
         _nrstyle.applyStroke(dc, has_stroke);
 
         // If the stroke is a hairline, set it to exactly 1px on screen.
@@ -203,8 +322,7 @@ void DrawingShape::_renderStroke(DrawingContext &dc, RenderContext &rc, Geom::In
             }
         }
 
-        dc.strokePreserve();
-        dc.newPath(); // clear path
+        dc.stroke();
     }
 }
 
@@ -225,14 +343,26 @@ unsigned DrawingShape::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
 
     bool outline = flags & RENDER_OUTLINE;
 
+    // Flatten shapes only a few pixels across more coarsely, where the difference cannot be seen.
+    Inkscape::DrawingContext::Save save_tolerance;
+    if (rc.level_of_detail && _curve_bounds && _curve_bounds->maxExtent() * dc.surface()->device_scale() < 16.0) {
+        save_tolerance.save(dc);
+        dc.setTolerance(0.5);
+    }
+
     if (outline) {
         auto rgba = rc.outline_color;
 
         // paint-order doesn't matter
         {
             Inkscape::DrawingContext::Save save(dc);
-            dc.transform(_ctm);
-            dc.path(_curve->get_pathvector());
+            auto const flat = _flatPath(dc, *visible);
+            if (flat) {
+                flat->feedStroke(dc, *visible, 0.5);
+            } else {
+                dc.transform(_ctm);
+                dc.path(_curve->get_pathvector());
+            }
         }
         {
             Inkscape::DrawingContext::Save save(dc);
@@ -249,49 +379,51 @@ unsigned DrawingShape::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
     if (_nrstyle.data.paint_order_layer[0] == NRStyleData::PAINT_ORDER_NORMAL) {
         // This is the most common case, special case so we don't call get_pathvector(), etc. twice
 
+        // we assume the context has no path
+        CairoPatternUniqPtr has_fill, has_stroke;
         {
-            // we assume the context has no path
             Inkscape::DrawingContext::Save save(dc);
             dc.transform(_ctm);
 
             // update fill and stroke paints.
             // this cannot be done during nr_arena_shape_update, because we need a Cairo context
             // to render svg:pattern
-            auto has_fill   = _nrstyle.prepareFill(dc, rc, *visible, _item_bbox, _fill_pattern);
-            auto has_stroke = _nrstyle.prepareStroke(dc, rc, *visible, _item_bbox, _stroke_pattern);
+            has_fill   = _nrstyle.prepareFill(dc, rc, *visible, _item_bbox, _fill_pattern);
+            has_stroke = _nrstyle.prepareStroke(dc, rc, *visible, _item_bbox, _stroke_pattern);
             if (!_nrstyle.data.hairline && _nrstyle.data.stroke_width == 0) {
                 has_stroke.reset();
             }
-            if (has_fill || has_stroke) {
-                dc.path(_curve->get_pathvector());
-                // TODO: remove segments outside of bbox when no dashes present
-                if (has_fill) {
-                    _nrstyle.applyFill(dc, has_fill);
-                    dc.fillPreserve();
-                }
-                if (style_vector_effect_stroke) {
-                    dc.restore();
-                    dc.save();
-                }
-                if (has_stroke) {
-                    _nrstyle.applyStroke(dc, has_stroke);
-
-                    // If the draw mode is set to visible hairlines, don't let anything get smaller
-                    // than half a pixel.
-                    if (flags & RENDER_VISIBLE_HAIRLINES) {
-                        double dx = 1.0, dy = 0.0;
-                        dc.device_to_user_distance(dx, dy);
-                        auto half_pixel_size = std::hypot(dx, dy) * 0.5;
-                        if (_nrstyle.data.stroke_width < half_pixel_size) {
-                            dc.setLineWidth(half_pixel_size);
-                        }
-                    }
+        }
 
-                    dc.strokePreserve();
+        if (has_fill || has_stroke) {
+            // The path is fed in drawing coordinates, where the cached flattening lives, and
+            // only the parts of it that can reach the area being rendered.
+            auto const flat = _flatPath(dc, *visible);
+            if (has_fill) {
+                Inkscape::DrawingContext::Save save(dc);
+                _feedFill(dc, flat.get(), *visible);
+                _nrstyle.applyFill(dc, has_fill);
+                dc.fill();
+            }
+            if (has_stroke) {
+                Inkscape::DrawingContext::Save save(dc);
+                _feedStroke(dc, flat.get(), *visible, _strokeExtent(_ctm) * 1.5 + 1.0);
+                _nrstyle.applyStroke(dc, has_stroke);
+
+                // If the draw mode is set to visible hairlines, don't let anything get smaller
+                // than half a pixel.
+                if (flags & RENDER_VISIBLE_HAIRLINES) {
+                    double dx = 1.0, dy = 0.0;
+                    dc.device_to_user_distance(dx, dy);
+                    auto half_pixel_size = std::hypot(dx, dy) * 0.5;
+                    if (_nrstyle.data.stroke_width < half_pixel_size) {
+                        dc.setLineWidth(half_pixel_size);
+                    }
                 }
-                dc.newPath(); // clear path
-            } // has fill or stroke pattern
-        }
+
+                dc.stroke();
+            }
+        } // has fill or stroke pattern
         _renderMarkers(dc, rc, area, flags, stop_at);
         return RENDER_OK;
 
@@ -318,7 +450,68 @@ unsigned DrawingShape::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::
     return RENDER_OK;
 }
 
-void DrawingShape::_clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &/*area*/) const
+bool DrawingShape::_renderSplat(DrawingContext &dc, double opacity) const
+{
+    if (!_curve || !_curve_bounds || !_children.empty()) {
+        return false;
+    }
+
+    int const device_scale = dc.surface()->device_scale();
+    if (_curve_bounds->maxExtent() * device_scale > 1.0) {
+        return false;
+    }
+
+    auto const &fill = _nrstyle.data.fill;
+    auto const &stroke = _nrstyle.data.stroke;
+    if (fill.type == NRStyleData::PaintType::SERVER || stroke.type == NRStyleData::PaintType::SERVER) {
+        return false;
+    }
+
+    auto const box_area = _curve_bounds->area();
+    if (box_area <= 0.0) {
+        return true;
+    }
+
+    // Only splatted shapes need their area and length, so measure them on first use.
+    auto const [curve_area, curve_length] = [this] {
+        auto lock = std::lock_guard(_flat_mutex);
+        if (!_measure) {
+            _measure = approximate_area_and_length(_curve->get_pathvector());
+        }
+        return *_measure;
+    }();
+
+    // Paint the bounds with each colour at the coverage that leaves the same amount of ink as the
+    // shape would have, so that many such items average out to the right colour.
+    Inkscape::DrawingContext::Save save(dc);
+    dc.setOperator(CAIRO_OPERATOR_OVER);
+    auto const det = std::abs(_ctm.det());
+    auto splat = [&] (NRStyleData::Paint const &paint, double ink_area) {
+        auto const coverage = std::min(ink_area / box_area, 1.0);
+        auto const &c = paint.color.v.c;
+        dc.rectangle(*_curve_bounds);
+        dc.setSource(c[0], c[1], c[2], paint.opacity * coverage * opacity);
+        dc.fill();
+    };
+
+    if (fill.type == NRStyleData::PaintType::COLOR) {
+        splat(fill, curve_area * det);
+    }
+    if (stroke.type == NRStyleData::PaintType::COLOR && (_nrstyle.data.stroke_width > 0 || style_stroke_extensions_hairline)) {
+        double width = _nrstyle.data.stroke_width;
+        if (!style_vector_effect_stroke) {
+            width *= std::sqrt(det);
+        }
+        if (style_stroke_extensions_hairline) {
+            width = 1.0 / device_scale;
+        }
+        splat(stroke, curve_length * std::sqrt(det) * width);
+    }
+
+    return true;
+}
+
+void DrawingShape::_clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area) const
 {
     if (!_curve) return;
 
@@ -328,8 +521,8 @@ void DrawingShape::_clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRec
     } else {
         dc.setFillRule(CAIRO_FILL_RULE_WINDING);
     }
-    dc.transform(_ctm);
-    dc.path(_curve->get_pathvector());
+    auto const flat = _flatPath(dc, area);
+    _feedFill(dc, flat.get(), area);
     dc.fill();
 }
 
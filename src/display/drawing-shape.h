@@ -13,6 +13,11 @@
 #ifndef INKSCAPE_DISPLAY_DRAWING_SHAPE_H
 #define INKSCAPE_DISPLAY_DRAWING_SHAPE_H
 
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
 #include "display/drawing-item.h"
 #include "display/nr-style.h"
 
@@ -21,6 +26,8 @@ class SPCurve;
 
 namespace Inkscape {
 
+class FlattenedPath;
+
 class DrawingShape
     : public DrawingItem
 {
@@ -38,6 +45,7 @@ protected:
     unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) override;
     unsigned _renderItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const override;
     void _clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area) const override;
+    bool _renderSplat(DrawingContext &dc, double opacity) const override;
     DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
     bool _canClip() const override { return true; }
 
@@ -45,6 +53,11 @@ protected:
     void _renderStroke(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags) const;
     void _renderMarkers(DrawingContext &dc, RenderContext &rc, Geom::IntRect const &area, unsigned flags, DrawingItem const *stop_at) const;
 
+    float _strokeExtent(Geom::Affine const &ctm) const;
+    std::shared_ptr<FlattenedPath const> _flatPath(DrawingContext &dc, Geom::IntRect const &area) const;
+    void _feedFill(DrawingContext &dc, FlattenedPath const *flat, Geom::IntRect const &area) const;
+    void _feedStroke(DrawingContext &dc, FlattenedPath const *flat, Geom::IntRect const &area, double margin) const;
+
     bool style_vector_effect_stroke : 1;
     bool style_stroke_extensions_hairline : 1;
     SPWindRule style_clip_rule;
@@ -52,8 +65,15 @@ protected:
     unsigned style_opacity : 24;
 
     std::shared_ptr<SPCurve const> _curve;
+    Geom::OptRect _curve_bounds; ///< Exact bounds of the path and its stroke, in drawing coordinates.
     NRStyle _nrstyle;
 
+    // The path flattened at the last transform it was rendered at, shared by the tiles rendering it.
+    mutable std::mutex _flat_mutex;
+    mutable std::shared_ptr<FlattenedPath const> _flat;
+    // The approximate area enclosed by the path and its length in user units, guarded by the same mutex.
+    mutable std::optional<std::pair<double, double>> _measure;
+
     DrawingItem *_last_pick;
     unsigned _repick_after;
 };
@@ -18,9 +18,11 @@
 
 #include "cairo-utils.h"
 #include "drawing-context.h"
+#include "filter-result-cache.h"
 #include "control/canvas-item-drawing.h"
 #include "nr-filter-gaussian.h"
 #include "nr-filter-types.h"
+#include "pattern-tile-cache.h"
 
 namespace Inkscape {
 
@@ -51,6 +53,8 @@ static auto default_numthreads()
 Drawing::Drawing(Inkscape::CanvasItemDrawing *canvas_item_drawing)
     : _canvas_item_drawing(canvas_item_drawing)
     , _grayscale_matrix(std::vector<double>(grayscale_matrix.begin(), grayscale_matrix.end()))
+    , _pattern_tiles(std::make_unique<PatternTileCache>())
+    , _filter_results(std::make_unique<FilterResultCache>())
 {
     _loadPrefs();
 }
@@ -188,10 +192,23 @@ void Drawing::setDithering(bool use_dithering)
     });
 }
 
+void Drawing::setLevelOfDetail(bool level_of_detail)
+{
+    defer([=, this] {
+        _level_of_detail = level_of_detail;
+        if (_rendermode != RenderMode::OUTLINE) {
+            _root->_markForUpdate(DrawingItem::STATE_ALL, true);
+            _clearCache();
+        }
+    });
+}
+
 void Drawing::setCacheBudget(size_t bytes)
 {
     defer([=, this] {
         _cache_budget = bytes;
+        _pattern_tiles->setBudget(bytes);
+        _filter_results->setBudget(bytes);
         _pickItemsForCaching();
     });
 }
@@ -242,7 +259,8 @@ void Drawing::render(DrawingContext &dc, Geom::IntRect const &area, unsigned fla
     auto rc = RenderContext{
         .outline_color = 0xff,
         .antialiasing_override = _antialiasing_override,
-        .dithering = _use_dithering
+        .dithering = _use_dithering,
+        .level_of_detail = _level_of_detail
     };
     flags |= rendermode_to_renderflags(_rendermode);
 
@@ -262,6 +280,14 @@ DrawingItem *Drawing::pick(Geom::Point const &p, double delta, unsigned flags)
     return _root->pick(p, delta, flags);
 }
 
+Drawing::FilterCacheStats Drawing::takeFilterCacheStats()
+{
+    return {
+        .hits = _filter_cache_hits.exchange(0, std::memory_order_relaxed),
+        .misses = _filter_cache_misses.exchange(0, std::memory_order_relaxed)
+    };
+}
+
 void Drawing::snapshot()
 {
     assert(!_snapshotted);
@@ -311,6 +337,8 @@ void Drawing::_clearCache()
     for (auto item : to_uncache) {
         item->_setCached(false, true);
     }
+    _pattern_tiles->clear();
+    _filter_results->clear();
 }
 
 void Drawing::_loadPrefs()
@@ -336,6 +364,13 @@ void Drawing::_loadPrefs()
         _cache_budget = 0;
     }
 
+    // Approximating tiny items is only worth it for the interactive display; other drawings are exact.
+    _level_of_detail = _canvas_item_drawing && prefs->getBool("/options/rendering/levelofdetail", true);
+
+    // Non-canvas drawings are short-lived, so they keep all their pattern tiles until destroyed.
+    _pattern_tiles->setBudget(_canvas_item_drawing ? _cache_budget : SIZE_MAX);
+    _filter_results->setBudget(_cache_budget);
+
     // Set the global variable governing the number of filter threads, and track it too. (This is ugly, but hopefully transitional.)
     set_num_filter_threads(prefs->getIntLimited("/options/threading/numthreads", default_numthreads(), 1, 256));
 
@@ -351,6 +386,7 @@ void Drawing::_loadPrefs()
         actions.emplace("/options/filterquality/value",          [this] (auto &entry) { setFilterQuality(entry.getIntLimited(0, Filters::FILTER_QUALITY_WORST, Filters::FILTER_QUALITY_BEST)); });
         actions.emplace("/options/blurquality/value",            [this] (auto &entry) { setBlurQuality(entry.getInt(0)); });
         actions.emplace("/options/dithering/value",              [this] (auto &entry) { setDithering(entry.getBool(true)); });
+        actions.emplace("/options/rendering/levelofdetail",      [this] (auto &entry) { setLevelOfDetail(entry.getBool(true)); });
         actions.emplace("/options/cursortolerance/value",        [this] (auto &entry) { setCursorTolerance(entry.getDouble(1.0)); });
         actions.emplace("/options/selection/zeroopacity",        [this] (auto &entry) { setSelectZeroOpacity(entry.getBool(false)); });
         actions.emplace("/options/renderingcache/size",          [this] (auto &entry) { setCacheBudget((1 << 20) * entry.getIntLimited(64, 0, 4096)); });
@@ -383,6 +419,7 @@ void Drawing::setExact()
 {
     setFilterQuality(Filters::FILTER_QUALITY_BEST);
     setBlurQuality(BLUR_QUALITY_BEST);
+    setLevelOfDetail(false);
 }
 
 /*
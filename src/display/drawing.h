@@ -15,6 +15,7 @@
 
 #include <optional>
 #include <set>
+#include <atomic>
 #include <cstdint>
 #include <vector>
 #include <boost/operators.hpp>
@@ -33,6 +34,8 @@ namespace Inkscape {
 class DrawingItem;
 class CanvasItemDrawing;
 class DrawingContext;
+class FilterResultCache;
+class PatternTileCache;
 
 class Drawing
 {
@@ -57,6 +60,7 @@ public:
     void setFilterQuality(int);
     void setBlurQuality(int);
     void setDithering(bool);
+    void setLevelOfDetail(bool);
     void setCursorTolerance(double tol) { _cursor_tolerance = tol; }
     void setSelectZeroOpacity(bool select_zero_opacity) { _select_zero_opacity = select_zero_opacity; }
     void setCacheBudget(size_t bytes);
@@ -75,9 +79,22 @@ public:
     int filterQuality() const { return _filter_quality; }
     int blurQuality() const { return _blur_quality; }
     bool useDithering() const { return _use_dithering; }
+    bool levelOfDetail() const { return _level_of_detail; }
     double cursorTolerance() const { return _cursor_tolerance; }
     bool selectZeroOpacity() const { return _select_zero_opacity; }
+    size_t cacheBudget() const { return _cache_budget; }
     Geom::OptIntRect const &cacheLimit() const { return _cache_limit; }
+    PatternTileCache &patternTileCache() const { return *_pattern_tiles; }
+    FilterResultCache &filterResultCache() const { return *_filter_results; }
+
+    /// Counts of filtered items painted from their cache and rendered afresh.
+    struct FilterCacheStats
+    {
+        unsigned long hits = 0;
+        unsigned long misses = 0;
+    };
+    /// Return the filter cache counters accumulated since the last call, and reset them.
+    FilterCacheStats takeFilterCacheStats();
 
     void update(Geom::IntRect const &area = Geom::IntRect::infinite(), Geom::Affine const &affine = Geom::identity(),
                 unsigned flags = DrawingItem::STATE_ALL, unsigned reset = 0);
@@ -88,6 +105,13 @@ public:
     void unsnapshot();
     bool snapshotted() const { return _snapshotted; }
 
+    /**
+     * Record the changes that the calling thread makes to any drawing into a log, rather than
+     * applying them, until called again with nullptr. Replaying the log on the main thread then
+     * applies them. Used to update independent parts of the object tree on worker threads.
+     */
+    static void redirectChanges(Util::FuncLog *log) { _redirect = log; }
+
     // Convenience
     void averageColor(Geom::IntRect const &area, double &R, double &G, double &B, double &A) const;
     void setExact();
@@ -113,6 +137,7 @@ private:
     int _filter_quality;
     int _blur_quality;
     bool _use_dithering;
+    bool _level_of_detail; ///< Approximate items smaller than a pixel by their average colour.
     double _cursor_tolerance;
     size_t _cache_budget; ///< Maximum allowed size of cache.
     Geom::OptIntRect _cache_limit;
@@ -122,6 +147,8 @@ private:
 
     std::set<DrawingItem*> _cached_items; // modified by DrawingItem::_setCached()
     CacheList _candidate_items;           // keep this list always sorted with std::greater
+    std::unique_ptr<PatternTileCache> _pattern_tiles; ///< Shared by all patterns; limited by the cache budget.
+    std::unique_ptr<FilterResultCache> _filter_results; ///< For filtered items without a cache; limited by the cache budget.
 
     /*
      * Simple cacheline separator compatible with x86 (64 bytes) and M* (128 bytes).
@@ -131,10 +158,20 @@ private:
     char cacheline_separator[127];
 
     bool _snapshotted = false;
+    mutable std::atomic<unsigned long> _filter_cache_hits = 0;   ///< Modified by DrawingItem::render().
+    mutable std::atomic<unsigned long> _filter_cache_misses = 0; ///< Modified by DrawingItem::render().
     Util::FuncLog _funclog;
+    static inline thread_local Util::FuncLog *_redirect = nullptr;
 
     template<typename F>
-    void defer(F &&f) { _snapshotted ? _funclog.emplace(std::forward<F>(f)) : f(); }
+    void defer(F &&f)
+    {
+        if (_redirect) {
+            _redirect->emplace([this, f = std::forward<F>(f)] () mutable { defer(std::move(f)); });
+        } else {
+            _snapshotted ? _funclog.emplace(std::forward<F>(f)) : f();
+        }
+    }
 
     friend class DrawingItem;
 };
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Cache of the filter results of items that are not picked for caching.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "filter-result-cache.h"
+
+#include <iterator>
+
+#include "drawing-surface.h"
+
+namespace Inkscape {
+
+void FilterResultCache::setBudget(std::size_t bytes)
+{
+    auto lock = std::lock_guard(_mutex);
+    _budget = bytes;
+    _evict();
+}
+
+std::shared_ptr<DrawingSurface> FilterResultCache::get(Key const &key)
+{
+    auto lock = std::lock_guard(_mutex);
+
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        return {};
+    }
+
+    _entries.splice(_entries.begin(), _entries, it->second);
+    return it->second->result;
+}
+
+void FilterResultCache::put(Key const &key, std::shared_ptr<DrawingSurface> result)
+{
+    auto const pixels = result->pixels();
+    auto const scale = result->device_scale();
+    std::size_t const size = static_cast<std::size_t>(pixels.x()) * pixels.y() * scale * scale * 4;
+
+    auto lock = std::lock_guard(_mutex);
+
+    if (auto it = _index.find(key); it != _index.end()) {
+        // Rendered by another thread at the same time.
+        _erase(it->second);
+    }
+
+    _entries.push_front({ key, std::move(result), size });
+    _index.emplace(key, _entries.begin());
+    _counts[key.item]++;
+    _size += size;
+    _evict();
+}
+
+void FilterResultCache::drop(DrawingItem const *item)
+{
+    auto lock = std::lock_guard(_mutex);
+
+    // Every item marked for rendering drops its results, so return quickly if there is nothing to do.
+    if (!_counts.contains(item)) {
+        return;
+    }
+
+    for (auto it = _entries.begin(); it != _entries.end(); ) {
+        auto next = std::next(it);
+        if (it->key.item == item) {
+            _erase(it);
+        }
+        it = next;
+    }
+}
+
+void FilterResultCache::clear()
+{
+    auto lock = std::lock_guard(_mutex);
+    _entries.clear();
+    _index.clear();
+    _counts.clear();
+    _size = 0;
+}
+
+void FilterResultCache::_erase(std::list<Entry>::iterator it)
+{
+    _size -= it->size;
+    _index.erase(it->key);
+    if (auto c = _counts.find(it->key.item); --c->second == 0) {
+        _counts.erase(c);
+    }
+    _entries.erase(it);
+}
+
+void FilterResultCache::_evict()
+{
+    // Always keep the most recently used entry, so that repeating the last render is always cheap.
+    while (_size > _budget && _entries.size() > 1) {
+        _erase(std::prev(_entries.end()));
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Cache of the filter results of items that are not picked for caching.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_DISPLAY_FILTER_RESULT_CACHE_H
+#define INKSCAPE_DISPLAY_FILTER_RESULT_CACHE_H
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Inkscape {
+
+class DrawingItem;
+class DrawingSurface;
+
+/**
+ * The filtered renderings of the items in a Drawing that have no DrawingCache of their own.
+ *
+ * Rendering the same area of such an item again, e.g. when a tile is redrawn, paints the stored
+ * result instead of running the filter. Entries are kept in least-recently-used order and
+ * evicted once their total size exceeds the budget. All entries for an item are dropped when
+ * the item or anything it depends on is marked for rendering.
+ *
+ * All methods are thread-safe. Stored surfaces are never modified, so they may be painted from
+ * several threads at once.
+ */
+class FilterResultCache
+{
+public:
+    /// The parameters that determine the pixels of a filter result.
+    struct Key
+    {
+        DrawingItem const *item;
+        void const *filter;            ///< The filter renderer, which is replaced whenever the filter changes.
+        std::array<double, 6> ctm;
+        std::array<int, 4> area;       ///< The area rendered, in screen pixels.
+        int device_scale;
+        int filter_quality;
+        int blur_quality;
+        unsigned flags;                ///< The render flags.
+        int antialiasing;              ///< The antialiasing override, or -1 for none.
+        bool dithering;
+
+        auto operator<=>(Key const &) const = default;
+    };
+
+    /// Set the total size of entries above which the least recently used ones are evicted.
+    void setBudget(std::size_t bytes);
+
+    /// Return the result stored for a key, or null, and mark it as most recently used.
+    std::shared_ptr<DrawingSurface> get(Key const &key);
+
+    /// Store the result for a key, and evict entries if over budget.
+    void put(Key const &key, std::shared_ptr<DrawingSurface> result);
+
+    /// Drop all entries for an item.
+    void drop(DrawingItem const *item);
+
+    /// Drop all entries.
+    void clear();
+
+private:
+    struct Entry
+    {
+        Key key;
+        std::shared_ptr<DrawingSurface> result;
+        std::size_t size = 0;
+    };
+
+    std::mutex _mutex;
+    std::list<Entry> _entries; ///< Most recently used first.
+    std::map<Key, std::list<Entry>::iterator> _index;
+    std::unordered_map<DrawingItem const *, unsigned> _counts; ///< The number of entries for each item.
+    std::size_t _size = 0;
+    std::size_t _budget = 0;
+
+    void _erase(std::list<Entry>::iterator it);
+    void _evict();
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_DISPLAY_FILTER_RESULT_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Path flattened to line segments, for rendering many small areas of it.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "flattened-path.h"
+
+#include <algorithm>
+#include <cairo.h>
+#include <2geom/pathvector.h>
+
+#include "cairo-utils.h"
+#include "drawing-context.h"
+
+namespace Inkscape {
+namespace {
+
+// The number of line segments whose bounds are kept together.
+std::size_t constexpr ChunkSize = 32;
+
+// Paths that flatten to more points than this are fed to Cairo as they are.
+std::size_t constexpr MaxPoints = 1 << 20;
+
+} // namespace
+
+FlattenedPath::FlattenedPath(Geom::PathVector const &pathv, Geom::Affine const &ctm, double tolerance)
+    : _ctm(ctm)
+    , _tolerance(tolerance)
+{
+    if (!ctm.isInvertible()) {
+        return;
+    }
+
+    // Let Cairo flatten the path, in the same way as it does when rendering.
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+    auto ct = cairo_create(surface);
+    cairo_set_tolerance(ct, tolerance);
+    ink_cairo_transform(ct, ctm);
+    feed_pathvector_to_cairo(ct, pathv);
+    auto path = cairo_copy_path_flat(ct);
+    cairo_destroy(ct);
+    cairo_surface_destroy(surface);
+
+    if (path->status != CAIRO_STATUS_SUCCESS) {
+        cairo_path_destroy(path);
+        return;
+    }
+
+    std::size_t count = 0;
+    auto const end = path->data + path->num_data;
+    for (auto p = path->data; p < end && count <= MaxPoints; p += p->header.length) {
+        switch (p->header.type) {
+            case CAIRO_PATH_MOVE_TO:
+                _subpaths.emplace_back();
+                [[fallthrough]];
+            case CAIRO_PATH_LINE_TO:
+                // The path is in user space, and transformed back to drawing coordinates.
+                _subpaths.back().points.emplace_back(Geom::Point(p[1].point.x, p[1].point.y) * ctm);
+                ++count;
+                break;
+            case CAIRO_PATH_CLOSE_PATH: {
+                auto &subpath = _subpaths.back();
+                subpath.closed = true;
+                subpath.points.push_back(subpath.points.front());
+                ++count;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    cairo_path_destroy(path);
+
+    if (count > MaxPoints) {
+        _subpaths.clear();
+        return;
+    }
+
+    // Cairo starts a new subpath at the initial point after closing one; drop it if nothing follows.
+    std::erase_if(_subpaths, [] (Subpath const &s) { return s.points.size() == 1 && !s.closed; });
+
+    for (auto &subpath : _subpaths) {
+        auto const &points = subpath.points;
+        subpath.bounds = Geom::Rect(points.front(), points.front());
+        for (std::size_t i = 0; i + 1 < points.size(); i += ChunkSize) {
+            auto const last = std::min(i + ChunkSize, points.size() - 1);
+            Geom::Rect chunk(points[i], points[i]);
+            for (auto j = i + 1; j <= last; ++j) {
+                chunk.expandTo(points[j]);
+            }
+            subpath.chunks.push_back(chunk);
+            subpath.bounds.unionWith(chunk);
+        }
+    }
+    _valid = true;
+}
+
+void FlattenedPath::_feedSubpath(DrawingContext &dc, Subpath const &subpath) const
+{
+    dc.moveTo(subpath.points.front());
+    for (std::size_t i = 1; i < subpath.points.size(); ++i) {
+        dc.lineTo(subpath.points[i]);
+    }
+    if (subpath.closed) {
+        dc.closePath();
+    }
+}
+
+void FlattenedPath::feed(DrawingContext &dc) const
+{
+    for (auto const &subpath : _subpaths) {
+        _feedSubpath(dc, subpath);
+    }
+}
+
+void FlattenedPath::feedFill(DrawingContext &dc, Geom::IntRect const &area) const
+{
+    // A subpath has a winding number of zero outside its bounds, so it cannot affect the fill of
+    // an area it does not touch. (One pixel of slack is kept for antialiasing.)
+    auto rect = Geom::Rect(area);
+    rect.expandBy(1.0);
+
+    for (auto const &subpath : _subpaths) {
+        if (subpath.bounds.intersects(rect)) {
+            _feedSubpath(dc, subpath);
+        }
+    }
+}
+
+void FlattenedPath::feedStroke(DrawingContext &dc, Geom::IntRect const &area, double margin) const
+{
+    auto rect = Geom::Rect(area);
+    rect.expandBy(margin + 1.0);
+
+    for (auto const &subpath : _subpaths) {
+        if (!subpath.bounds.intersects(rect)) {
+            continue;
+        }
+
+        auto const n = subpath.chunks.size();
+        auto const first_hidden = std::find_if(subpath.chunks.begin(), subpath.chunks.end(),
+                                               [&] (Geom::Rect const &c) { return !c.intersects(rect); });
+        if (first_hidden == subpath.chunks.end()) {
+            _feedSubpath(dc, subpath);
+            continue;
+        }
+
+        // Feed the runs of chunks near the area as open subpaths. Their ends are shared with
+        // chunks that are further than the margin from the area, so the caps drawn there instead
+        // of joins are never visible. A closed subpath is walked from a hidden chunk, so that a
+        // run through its initial point is fed in one piece.
+        auto const start = subpath.closed ? static_cast<std::size_t>(first_hidden - subpath.chunks.begin()) : 0;
+        bool in_run = false;
+        for (std::size_t k = 0; k < n; ++k) {
+            auto const c = (start + k) % n;
+            if (!subpath.chunks[c].intersects(rect)) {
+                in_run = false;
+                continue;
+            }
+            auto const begin = c * ChunkSize;
+            auto const last = std::min(begin + ChunkSize, subpath.points.size() - 1);
+            if (!in_run) {
+                dc.moveTo(subpath.points[begin]);
+                in_run = true;
+            }
+            for (auto i = begin + 1; i <= last; ++i) {
+                dc.lineTo(subpath.points[i]);
+            }
+        }
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
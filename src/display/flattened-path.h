@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Path flattened to line segments, for rendering many small areas of it.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_DISPLAY_FLATTENED_PATH_H
+#define INKSCAPE_DISPLAY_FLATTENED_PATH_H
+
+#include <cstddef>
+#include <vector>
+#include <2geom/affine.h>
+#include <2geom/forward.h>
+#include <2geom/int-rect.h>
+#include <2geom/rect.h>
+
+namespace Inkscape {
+
+class DrawingContext;
+
+/**
+ * A path flattened to line segments in drawing coordinates, as Cairo would flatten it.
+ *
+ * The line segments of each subpath are grouped into short runs with their bounding boxes, so
+ * that rendering a tile only feeds Cairo the parts of the path that can affect it, rather than
+ * having Cairo flatten and stroke the whole path again for every tile.
+ *
+ * Feed methods must be called with the drawing coordinate transform in effect.
+ */
+class FlattenedPath
+{
+public:
+    FlattenedPath(Geom::PathVector const &pathv, Geom::Affine const &ctm, double tolerance);
+
+    /// Whether the path was flattened. Paths too large to keep flattened are not.
+    bool valid() const { return _valid; }
+    Geom::Affine const &ctm() const { return _ctm; }
+    double tolerance() const { return _tolerance; }
+
+    /// Feed the whole path.
+    void feed(DrawingContext &dc) const;
+
+    /// Feed the subpaths that can affect the fill of an area.
+    void feedFill(DrawingContext &dc, Geom::IntRect const &area) const;
+
+    /// Feed the parts of the path that can affect a stroke of an area, where the stroke extends
+    /// at most margin from the path. Parts are cut where they are further than that from the area.
+    void feedStroke(DrawingContext &dc, Geom::IntRect const &area, double margin) const;
+
+private:
+    struct Subpath
+    {
+        std::vector<Geom::Point> points; ///< Closed subpaths end with their initial point.
+        std::vector<Geom::Rect> chunks;  ///< The bounds of each run of ChunkSize segments.
+        Geom::Rect bounds;
+        bool closed = false;
+    };
+
+    std::vector<Subpath> _subpaths;
+    Geom::Affine _ctm;
+    double _tolerance;
+    bool _valid = false;
+
+    void _feedSubpath(DrawingContext &dc, Subpath const &subpath) const;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_DISPLAY_FLATTENED_PATH_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -11,6 +11,8 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
@@ -52,118 +54,108 @@ struct MultiplyAlpha
     }
 };
 
+/**
+ * Base for the transfer functions, which act on one 8-bit component at a time. Since there are
+ * only 256 possible inputs, the function is evaluated once for each of them in the constructor,
+ * and applying it to a pixel is a table lookup.
+ */
 struct ComponentTransfer
 {
     ComponentTransfer(guint32 color)
         : _shift(color * 8)
         , _mask(0xff << _shift) {}
 
+    guint32 operator()(guint32 in)
+    {
+        guint32 component = (in & _mask) >> _shift;
+        return (in & ~_mask) | (_lut[component] << _shift);
+    }
+
 protected:
+    template <typename F>
+    void _fill(F &&f)
+    {
+        for (guint32 component = 0; component < 256; ++component) {
+            _lut[component] = f(component);
+        }
+    }
+
     guint32 _shift;
     guint32 _mask;
+    std::array<guint32, 256> _lut;
 };
 
 struct ComponentTransferTable : public ComponentTransfer
 {
     ComponentTransferTable(guint32 color, std::vector<double> const &values)
         : ComponentTransfer(color)
-        , _v(values.size())
     {
+        std::vector<guint32> v(values.size());
         for (unsigned i = 0; i < values.size(); ++i) {
-            _v[i] = std::round(std::clamp(values[i], 0.0, 1.0) * 255);
-        }
-    }
-    
-    guint32 operator()(guint32 in)
-    {
-        if (_v.empty()) {
-            return in;
+            v[i] = std::round(std::clamp(values[i], 0.0, 1.0) * 255);
         }
 
-        guint32 component = (in & _mask) >> _shift;
-        if (_v.size() == 1 || component == 255) {
-            component = _v.back();
-        } else {
-            guint32 k = (_v.size() - 1) * component;
+        _fill([&] (guint32 component) {
+            if (v.empty()) {
+                return component;
+            }
+            if (v.size() == 1 || component == 255) {
+                return v.back();
+            }
+            guint32 k = (v.size() - 1) * component;
             guint32 dx = k % 255;
             k /= 255;
-            component = _v[k] * 255 + (_v[k + 1] - _v[k]) * dx;
-            component = (component + 127) / 255;
-        }
-        return (in & ~_mask) | (component << _shift);
+            component = v[k] * 255 + (v[k + 1] - v[k]) * dx;
+            return (component + 127) / 255;
+        });
     }
-    
-private:
-    std::vector<guint32> _v;
 };
 
 struct ComponentTransferDiscrete : public ComponentTransfer
 {
     ComponentTransferDiscrete(guint32 color, std::vector<double> const &values)
         : ComponentTransfer(color)
-        , _v(values.size())
     {
+        std::vector<guint32> v(values.size());
         for (unsigned i = 0; i< values.size(); ++i) {
-            _v[i] = std::round(std::clamp(values[i], 0.0, 1.0) * 255);
+            v[i] = std::round(std::clamp(values[i], 0.0, 1.0) * 255);
         }
+
+        _fill([&] (guint32 component) {
+            guint32 k = v.size() * component / 255;
+            if (k == v.size()) --k;
+            return v[k];
+        });
     }
-    
-    guint32 operator()(guint32 in)
-    {
-        guint32 component = (in & _mask) >> _shift;
-        guint32 k = _v.size() * component / 255;
-        if (k == _v.size()) --k;
-        component = _v[k];
-        return (in & ~_mask) | ((guint32)component << _shift);
-    }
-    
-private:
-    std::vector<guint32> _v;
 };
 
 struct ComponentTransferLinear : public ComponentTransfer
 {
-    ComponentTransferLinear(guint32 color, double intercept, double slope)
+    ComponentTransferLinear(guint32 color, double intercept_in, double slope_in)
         : ComponentTransfer(color)
-        , _intercept(round(intercept * 255 * 255))
-        , _slope(round(slope * 255)) {}
-    
-    guint32 operator()(guint32 in)
     {
-        gint32 component = (in & _mask) >> _shift;
-
-        // TODO: this can probably be reduced to something simpler
-        component = pxclamp(_slope * component + _intercept, 0, 255 * 255);
-        component = (component + 127) / 255;
-        return (in & ~_mask) | (component << _shift);
+        gint32 intercept = round(intercept_in * 255 * 255);
+        gint32 slope = round(slope_in * 255);
+
+        _fill([&] (gint32 component) {
+            // TODO: this can probably be reduced to something simpler
+            component = pxclamp(slope * component + intercept, 0, 255 * 255);
+            return guint32((component + 127) / 255);
+        });
     }
-    
-private:
-    gint32 _intercept;
-    gint32 _slope;
 };
 
 struct ComponentTransferGamma : public ComponentTransfer
 {
     ComponentTransferGamma(guint32 color, double amplitude, double exponent, double offset)
         : ComponentTransfer(color)
-        , _amplitude(amplitude)
-        , _exponent(exponent)
-        , _offset(offset) {}
-    
-    guint32 operator()(guint32 in)
     {
-        double component = (in & _mask) >> _shift;
-        component /= 255.0;
-        component = _amplitude * std::pow(component, _exponent) + _offset;
-        guint32 cpx = pxclamp(component * 255.0, 0, 255);
-        return (in & ~_mask) | (cpx << _shift);
+        _fill([&] (guint32 in) {
+            double component = in / 255.0;
+            component = amplitude * std::pow(component, exponent) + offset;
+            return guint32(pxclamp(component * 255.0, 0, 255));
+        });
     }
-
-private:
-    double _amplitude;
-    double _exponent;
-    double _offset;
 };
 
 void FilterComponentTransfer::render_cairo(FilterSlot &slot) const
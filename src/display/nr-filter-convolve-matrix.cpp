@@ -11,6 +11,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <complex>
 #include <vector>
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
@@ -26,76 +29,277 @@ FilterConvolveMatrix::FilterConvolveMatrix() = default;
 
 FilterConvolveMatrix::~FilterConvolveMatrix() = default;
 
-enum PreserveAlphaMode
+namespace {
+
+// Kernels with at least this many elements are applied with an FFT, unless they are separable.
+int const FFT_THRESHOLD = 15 * 15;
+
+// The part of an axis of length n that the kernel covers at position x. Near the start, the
+// window is shifted rather than clipped, so the kernel is always applied from its first element.
+struct Window
 {
-    PRESERVE_ALPHA,
-    NO_PRESERVE_ALPHA
+    int start;
+    int length;
 };
 
-template <PreserveAlphaMode preserve_alpha>
-struct ConvolveMatrix : public SurfaceSynth
-{
-    ConvolveMatrix(cairo_surface_t *s, int targetX, int targetY, int orderX, int orderY,
-                   double divisor, double bias, std::vector<double> const &kernel)
-        : SurfaceSynth(s)
-        , _kernel(kernel.size())
-        , _targetX(targetX)
-        , _targetY(targetY)
-        , _orderX(orderX)
-        , _orderY(orderY)
-        , _bias(bias)
-    {
-        for (unsigned i = 0; i < _kernel.size(); ++i) {
-            _kernel[i] = kernel[i] / divisor;
+Window kernel_window(int x, int n, int order, int target)
+{
+    int start = std::max(0, x - target);
+    return { start, std::min(n, start + order) - start };
+}
+
+// One channel of a surface, with its pixels stored in rows of doubles.
+using Plane = std::vector<double>;
+
+// Add the 1-D convolution of a row with a kernel to dst, for the positions [x0, x1).
+void accumulate_row(double *dst, double const *src, int x0, int x1, int w,
+                    double const *kernel, int order, int target)
+{
+    // In the interior, the window is a fixed offset from x, so the loops below vectorise.
+    int const interior0 = std::clamp(target, x0, x1);
+    int const interior1 = std::clamp(w - order + target + 1, interior0, x1);
+
+    auto edge = [&] (int x) {
+        auto const win = kernel_window(x, w, order, target);
+        for (int j = 0; j < win.length; ++j) {
+            dst[x] += src[win.start + j] * kernel[j];
+        }
+    };
+    for (int x = x0; x < interior0; ++x) {
+        edge(x);
+    }
+    for (int j = 0; j < order; ++j) {
+        double const coeff = kernel[j];
+        if (coeff == 0.0) {
+            continue;
+        }
+        int const offset = j - target;
+        for (int x = interior0; x < interior1; ++x) {
+            dst[x] += src[x + offset] * coeff;
+        }
+    }
+    for (int x = interior1; x < x1; ++x) {
+        edge(x);
+    }
+}
+
+// Apply the kernel directly to the output rectangle [x0, x1) x [y0, y1).
+void convolve_direct(Plane const &in, Plane &out, int w, int h, std::vector<double> const &kernel,
+                     int orderX, int orderY, int targetX, int targetY, int x0, int x1, int y0, int y1)
+{
+#if HAVE_OPENMP
+    #pragma omp parallel for if((x1 - x0) * (y1 - y0) > OPENMP_THRESHOLD) num_threads(get_num_filter_threads())
+#endif
+    for (int y = y0; y < y1; ++y) {
+        double *dst = out.data() + y * w;
+        std::fill(dst + x0, dst + x1, 0.0);
+        auto const win = kernel_window(y, h, orderY, targetY);
+        for (int i = 0; i < win.length; ++i) {
+            accumulate_row(dst, in.data() + (win.start + i) * w, x0, x1, w,
+                           kernel.data() + i * orderX, orderX, targetX);
+        }
+    }
+}
+
+// Split the kernel into a column and a row whose outer product it is, if it has rank 1.
+bool separate_kernel(std::vector<double> const &kernel, int orderX, int orderY,
+                     std::vector<double> &column, std::vector<double> &row)
+{
+    auto const pivot = std::max_element(kernel.begin(), kernel.end(),
+                                        [] (double a, double b) { return std::abs(a) < std::abs(b); });
+    double const max = std::abs(*pivot);
+    int const pi = (pivot - kernel.begin()) / orderX;
+    int const pj = (pivot - kernel.begin()) % orderX;
+
+    column.resize(orderY);
+    row.resize(orderX);
+    for (int i = 0; i < orderY; ++i) {
+        column[i] = kernel[i * orderX + pj];
+    }
+    for (int j = 0; j < orderX; ++j) {
+        row[j] = max == 0.0 ? 0.0 : kernel[pi * orderX + j] / *pivot;
+    }
+
+    double const tolerance = max * 1e-9;
+    for (int i = 0; i < orderY; ++i) {
+        for (int j = 0; j < orderX; ++j) {
+            if (std::abs(kernel[i * orderX + j] - column[i] * row[j]) > tolerance) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Apply a rank-1 kernel as a horizontal pass followed by a vertical pass.
+void convolve_separable(Plane const &in, Plane &out, int w, int h,
+                        std::vector<double> const &column, std::vector<double> const &row,
+                        int targetX, int targetY)
+{
+    int const orderX = row.size();
+    int const orderY = column.size();
+    Plane tmp(in.size());
+
+#if HAVE_OPENMP
+    #pragma omp parallel for if(w * h > OPENMP_THRESHOLD) num_threads(get_num_filter_threads())
+#endif
+    for (int y = 0; y < h; ++y) {
+        accumulate_row(tmp.data() + y * w, in.data() + y * w, 0, w, w, row.data(), orderX, targetX);
+    }
+
+#if HAVE_OPENMP
+    #pragma omp parallel for if(w * h > OPENMP_THRESHOLD) num_threads(get_num_filter_threads())
+#endif
+    for (int y = 0; y < h; ++y) {
+        double *dst = out.data() + y * w;
+        std::fill(dst, dst + w, 0.0);
+        auto const win = kernel_window(y, h, orderY, targetY);
+        for (int i = 0; i < win.length; ++i) {
+            double const coeff = column[i];
+            double const *src = tmp.data() + (win.start + i) * w;
+            for (int x = 0; x < w; ++x) {
+                dst[x] += src[x] * coeff;
+            }
         }
-        // the matrix is given rotated 180 degrees
-        // which corresponds to reverse element order
-        std::reverse(_kernel.begin(), _kernel.end());
+    }
+}
+
+// In-place radix-2 FFT of n complex values, where n is a power of two.
+void fft(std::complex<double> *data, int n, bool inverse)
+{
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+    for (int len = 2; len <= n; len <<= 1) {
+        auto const step = std::polar(1.0, (inverse ? 2 : -2) * M_PI / len);
+        for (int i = 0; i < n; i += len) {
+            std::complex<double> twiddle = 1.0;
+            for (int j = 0; j < len / 2; ++j) {
+                auto const u = data[i + j];
+                auto const v = data[i + j + len / 2] * twiddle;
+                data[i + j] = u + v;
+                data[i + j + len / 2] = u - v;
+                twiddle *= step;
+            }
+        }
+    }
+}
+
+// 2-D FFT of an nx by ny array, of which only the first `rows` rows may be non-zero.
+void fft2d(std::vector<std::complex<double>> &data, int nx, int ny, int rows, bool inverse)
+{
+#if HAVE_OPENMP
+    #pragma omp parallel for num_threads(get_num_filter_threads())
+#endif
+    for (int y = 0; y < rows; ++y) {
+        fft(data.data() + y * nx, nx, inverse);
     }
 
-    guint32 operator()(int x, int y) const
+#if HAVE_OPENMP
+    #pragma omp parallel num_threads(get_num_filter_threads())
+#endif
     {
-        int startx = std::max(0, x - _targetX);
-        int starty = std::max(0, y - _targetY);
-        int endx = std::min(_w, startx + _orderX);
-        int endy = std::min(_h, starty + _orderY);
-        int limitx = endx - startx;
-        int limity = endy - starty;
-        double suma = 0.0, sumr = 0.0, sumg = 0.0, sumb = 0.0;
-
-        for (int i = 0; i < limity; ++i) {
-            for (int j = 0; j < limitx; ++j) {
-                guint32 px = pixelAt(startx + j, starty + i);
-                double coeff = _kernel[i * _orderX + j];
-                EXTRACT_ARGB32(px, a,r,g,b)
+        std::vector<std::complex<double>> column(ny);
+#if HAVE_OPENMP
+        #pragma omp for
+#endif
+        for (int x = 0; x < nx; ++x) {
+            for (int y = 0; y < ny; ++y) {
+                column[y] = data[y * nx + x];
+            }
+            fft(column.data(), ny, inverse);
+            for (int y = 0; y < ny; ++y) {
+                data[y * nx + x] = column[y];
+            }
+        }
+    }
+}
 
-                sumr += r * coeff;
-                sumg += g * coeff;
-                sumb += b * coeff;
-                if (preserve_alpha == NO_PRESERVE_ALPHA) {
-                    suma += a * coeff;
-                }
+int next_power_of_two(int n)
+{
+    int result = 1;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Apply a large kernel by multiplying spectra. Only the interior, where the kernel window is not
+// affected by the edges, is a true convolution; the pixels around it are computed directly.
+// Two planes are transformed at once, as the real and imaginary parts of one complex array.
+void convolve_fft(std::vector<Plane const *> const &in, std::vector<Plane *> const &out, int w, int h,
+                  std::vector<double> const &kernel, int orderX, int orderY, int targetX, int targetY)
+{
+    int const x0 = targetX, x1 = w - orderX + targetX + 1;
+    int const y0 = targetY, y1 = h - orderY + targetY + 1;
+    if (x0 >= x1 || y0 >= y1) {
+        for (unsigned c = 0; c < in.size(); ++c) {
+            convolve_direct(*in[c], *out[c], w, h, kernel, orderX, orderY, targetX, targetY, 0, w, 0, h);
+        }
+        return;
+    }
+
+    int const nx = next_power_of_two(w + orderX - 1);
+    int const ny = next_power_of_two(h + orderY - 1);
+    double const scale = 1.0 / (static_cast<double>(nx) * ny);
+
+    // Convolving with the flipped kernel correlates with the kernel, as the direct path does.
+    std::vector<std::complex<double>> kernel_spectrum(nx * ny);
+    for (int i = 0; i < orderY; ++i) {
+        for (int j = 0; j < orderX; ++j) {
+            kernel_spectrum[(orderY - 1 - i) * nx + (orderX - 1 - j)] = kernel[i * orderX + j] * scale;
+        }
+    }
+    fft2d(kernel_spectrum, nx, ny, orderY, false);
+
+    std::vector<std::complex<double>> spectrum(nx * ny);
+    for (unsigned c = 0; c < in.size(); c += 2) {
+        bool const pair = c + 1 < in.size();
+
+        std::fill(spectrum.begin(), spectrum.end(), 0.0);
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                spectrum[y * nx + x] = { (*in[c])[y * w + x], pair ? (*in[c + 1])[y * w + x] : 0.0 };
             }
         }
-        if (preserve_alpha == PRESERVE_ALPHA) {
-            suma = alphaAt(x, y);
-        } else {
-            suma += _bias * 255;
+        fft2d(spectrum, nx, ny, h, false);
+        for (int i = 0; i < nx * ny; ++i) {
+            spectrum[i] *= kernel_spectrum[i];
+        }
+        fft2d(spectrum, nx, ny, ny, true);
+
+        int const dx = orderX - 1 - targetX;
+        int const dy = orderY - 1 - targetY;
+        for (int y = y0; y < y1; ++y) {
+            for (int x = x0; x < x1; ++x) {
+                auto const v = spectrum[(y + dy) * nx + x + dx];
+                (*out[c])[y * w + x] = v.real();
+                if (pair) {
+                    (*out[c + 1])[y * w + x] = v.imag();
+                }
+            }
         }
+    }
 
-        guint32 ao = pxclamp(round(suma), 0, 255);
-        guint32 ro = pxclamp(round(sumr + ao * _bias), 0, ao);
-        guint32 go = pxclamp(round(sumg + ao * _bias), 0, ao);
-        guint32 bo = pxclamp(round(sumb + ao * _bias), 0, ao);
-        ASSEMBLE_ARGB32(pxout, ao,ro,go,bo);
-        return pxout;
+    for (unsigned c = 0; c < in.size(); ++c) {
+        auto direct = [&] (int xa, int xb, int ya, int yb) {
+            convolve_direct(*in[c], *out[c], w, h, kernel, orderX, orderY, targetX, targetY, xa, xb, ya, yb);
+        };
+        direct(0, w, 0, y0);
+        direct(0, w, y1, h);
+        direct(0, x0, y0, y1);
+        direct(x1, w, y0, y1);
     }
+}
 
-private:
-    std::vector<double> _kernel;
-    int _targetX, _targetY, _orderX, _orderY;
-    double _bias;
-};
+} // namespace
 
 void FilterConvolveMatrix::render_cairo(FilterSlot &slot) const
 {
@@ -140,30 +344,88 @@ void FilterConvolveMatrix::render_cairo(FilterSlot &slot) const
         edge_warning = true;
     }
 
-    //guint32 *in_data = reinterpret_cast<guint32*>(cairo_image_surface_get_data(input));
-    //guint32 *out_data = reinterpret_cast<guint32*>(cairo_image_surface_get_data(out));
+    int const w = cairo_image_surface_get_width(input);
+    int const h = cairo_image_surface_get_height(input);
+    bool const alpha_only = cairo_image_surface_get_format(input) == CAIRO_FORMAT_A8;
+
+    // The kernel is divided by the divisor and given rotated by 180 degrees, which corresponds to
+    // reverse element order. (The code that creates this object makes sure that divisor != 0.)
+    std::vector<double> kernel(kernelMatrix.rbegin(), kernelMatrix.rend());
+    for (auto &k : kernel) {
+        k /= divisor;
+    }
 
-    //int width = cairo_image_surface_get_width(input);
-    //int height = cairo_image_surface_get_height(input);
+    // Unpack the channels that are convolved: the premultiplied colors, and alpha unless preserved.
+    cairo_surface_flush(input);
+    unsigned char const *in_data = cairo_image_surface_get_data(input);
+    int const in_stride = cairo_image_surface_get_stride(input);
+    int const channels = alpha_only ? 1 : 4;
+    std::vector<Plane> planes(channels, Plane(w * h));
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            if (alpha_only) {
+                planes[0][y * w + x] = in_data[y * in_stride + x];
+            } else {
+                guint32 px = reinterpret_cast<guint32 const *>(in_data + y * in_stride)[x];
+                EXTRACT_ARGB32(px, a,r,g,b)
+                planes[0][y * w + x] = a;
+                planes[1][y * w + x] = r;
+                planes[2][y * w + x] = g;
+                planes[3][y * w + x] = b;
+            }
+        }
+    }
 
-    // Set up predivided kernel matrix
-    /*std::vector<double> kernel(kernelMatrix);
-    for(size_t i=0; i<kernel.size(); i++) {
-        kernel[i] /= divisor; // The code that creates this object makes sure that divisor != 0
-    }*/
+    std::vector<Plane const *> inputs;
+    std::vector<Plane *> results;
+    std::vector<Plane> sums(channels);
+    for (int c = preserveAlpha ? 1 : 0; c < channels; ++c) {
+        sums[c].resize(w * h);
+        inputs.push_back(&planes[c]);
+        results.push_back(&sums[c]);
+    }
 
-    if (preserveAlpha) {
-        //convolve2D<true>(out_data, in_data, width, height, &kernel.front(), orderX, orderY,
-        //    targetX, targetY, bias);
-        ink_cairo_surface_synthesize(out, ConvolveMatrix<PRESERVE_ALPHA>(input,
-            targetX, targetY, orderX, orderY, divisor, bias, kernelMatrix));
+    std::vector<double> column, row;
+    bool const separable = orderX > 1 && orderY > 1 && separate_kernel(kernel, orderX, orderY, column, row);
+    auto chosen = method;
+    if (chosen == Method::Automatic || (chosen == Method::Separable && !separable)) {
+        chosen = separable ? Method::Separable : orderX * orderY >= FFT_THRESHOLD ? Method::FFT : Method::Direct;
+    }
+
+    if (inputs.empty()) {
+        // Only the preserved alpha channel is left.
+    } else if (chosen == Method::Separable) {
+        for (unsigned c = 0; c < inputs.size(); ++c) {
+            convolve_separable(*inputs[c], *results[c], w, h, column, row, targetX, targetY);
+        }
+    } else if (chosen == Method::FFT) {
+        convolve_fft(inputs, results, w, h, kernel, orderX, orderY, targetX, targetY);
     } else {
-        //convolve2D<false>(out_data, in_data, width, height, &kernel.front(), orderX, orderY,
-        //    targetX, targetY, bias);
-        ink_cairo_surface_synthesize(out, ConvolveMatrix<NO_PRESERVE_ALPHA>(input,
-            targetX, targetY, orderX, orderY, divisor, bias, kernelMatrix));
+        for (unsigned c = 0; c < inputs.size(); ++c) {
+            convolve_direct(*inputs[c], *results[c], w, h, kernel, orderX, orderY, targetX, targetY, 0, w, 0, h);
+        }
     }
 
+    unsigned char *out_data = cairo_image_surface_get_data(out);
+    int const out_stride = cairo_image_surface_get_stride(out);
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            int const i = y * w + x;
+            guint32 ao = preserveAlpha ? static_cast<guint32>(planes[0][i])
+                                       : pxclamp(round(sums[0][i] + bias * 255), 0, 255);
+            if (alpha_only) {
+                out_data[y * out_stride + x] = ao;
+            } else {
+                guint32 ro = pxclamp(round(sums[1][i] + ao * bias), 0, ao);
+                guint32 go = pxclamp(round(sums[2][i] + ao * bias), 0, ao);
+                guint32 bo = pxclamp(round(sums[3][i] + ao * bias), 0, ao);
+                ASSEMBLE_ARGB32(pxout, ao,ro,go,bo);
+                reinterpret_cast<guint32 *>(out_data + y * out_stride)[x] = pxout;
+            }
+        }
+    }
+    cairo_surface_mark_dirty(out);
+
     slot.set(_output, out);
     cairo_surface_destroy(out);
 }
@@ -213,6 +475,11 @@ void FilterConvolveMatrix::set_preserveAlpha(bool pa)
     preserveAlpha = pa;
 }
 
+void FilterConvolveMatrix::set_method(Method m)
+{
+    method = m;
+}
+
 void FilterConvolveMatrix::area_enlarge(Geom::IntRect &area, Geom::Affine const &/*trans*/) const
 {
     //Seems to me that since this filter's operation is resolution dependent,
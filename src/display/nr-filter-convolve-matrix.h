@@ -32,6 +32,15 @@ enum FilterConvolveMatrixEdgeMode
 class FilterConvolveMatrix : public FilterPrimitive
 {
 public:
+    /// The ways of applying the kernel, which give the same result up to rounding.
+    enum class Method
+    {
+        Automatic, ///< The fastest one for the kernel.
+        Direct,
+        Separable, ///< Only for kernels of rank 1; others are applied automatically.
+        FFT
+    };
+
     FilterConvolveMatrix();
     ~FilterConvolveMatrix() override;
 
@@ -48,6 +57,7 @@ public:
     void set_divisor(double d);
     void set_edgeMode(FilterConvolveMatrixEdgeMode mode);
     void set_preserveAlpha(bool pa);
+    void set_method(Method m);
 
     Glib::ustring name() const override { return Glib::ustring("Convolve Matrix"); }
 
@@ -58,6 +68,7 @@ private:
     double divisor, bias;
     FilterConvolveMatrixEdgeMode edgeMode;
     bool preserveAlpha;
+    Method method = Method::Automatic;
 };
 
 } // namespace Filters
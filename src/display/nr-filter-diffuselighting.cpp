@@ -20,12 +20,11 @@
 
 #include "display/cairo-templates.h"
 #include "display/cairo-utils.h"
-#include "display/nr-3dutils.h"
 #include "display/nr-filter-diffuselighting.h"
+#include "display/nr-filter-lighting.h"
 #include "display/nr-filter-slot.h"
 #include "display/nr-filter-units.h"
 #include "display/nr-filter-utils.h"
-#include "display/nr-light.h"
 #include "svg/svg-color.h"
 
 namespace Inkscape {
@@ -39,99 +38,6 @@ FilterDiffuseLighting::FilterDiffuseLighting()
 
 FilterDiffuseLighting::~FilterDiffuseLighting() = default;
 
-struct DiffuseLight : public SurfaceSynth
-{
-    DiffuseLight(cairo_surface_t *bumpmap, double scale, double kd)
-        : SurfaceSynth(bumpmap)
-        , _scale(scale)
-        , _kd(kd) {}
-
-protected:
-    guint32 diffuseLighting(int x, int y, NR::Fvector const &light, NR::Fvector const &light_components)
-    {
-        NR::Fvector normal = surfaceNormalAt(x, y, _scale);
-        double k = _kd * NR::scalar_product(normal, light);
-
-        guint32 r = CLAMP_D_TO_U8(k * light_components[LIGHT_RED]);
-        guint32 g = CLAMP_D_TO_U8(k * light_components[LIGHT_GREEN]);
-        guint32 b = CLAMP_D_TO_U8(k * light_components[LIGHT_BLUE]);
-
-        ASSEMBLE_ARGB32(pxout, 255, r, g, b)
-        return pxout;
-    }
-
-    double _scale, _kd;
-};
-
-struct DiffuseDistantLight : public DiffuseLight
-{
-    DiffuseDistantLight(cairo_surface_t *bumpmap, DistantLightData const &light, guint32 color,
-                        double scale, double diffuse_constant)
-        : DiffuseLight(bumpmap, scale, diffuse_constant)
-    {
-        DistantLight dl(light, color);
-        dl.light_vector(_lightv);
-        dl.light_components(_light_components);
-    }
-
-    guint32 operator()(int x, int y)
-    {
-        return diffuseLighting(x, y, _lightv, _light_components);
-    }
-
-private:
-    NR::Fvector _lightv, _light_components;
-};
-
-struct DiffusePointLight : public DiffuseLight
-{
-    DiffusePointLight(cairo_surface_t *bumpmap, PointLightData const &light, guint32 color,
-                      Geom::Affine const &trans, double scale, double diffuse_constant,
-                      double x0, double y0, int device_scale)
-        : DiffuseLight(bumpmap, scale, diffuse_constant)
-        , _light(light, color, trans, device_scale)
-        , _x0(x0)
-        , _y0(y0)
-    {
-        _light.light_components(_light_components);
-    }
-
-    guint32 operator()(int x, int y)
-    {
-        NR::Fvector light;
-        _light.light_vector(light, _x0 + x, _y0 + y, _scale * alphaAt(x, y) / 255.0);
-        return diffuseLighting(x, y, light, _light_components);
-    }
-
-private:
-    PointLight _light;
-    NR::Fvector _light_components;
-    double _x0, _y0;
-};
-
-struct DiffuseSpotLight : public DiffuseLight
-{
-    DiffuseSpotLight(cairo_surface_t *bumpmap, SpotLightData const &light, guint32 color,
-                     Geom::Affine const &trans, double scale, double diffuse_constant,
-                     double x0, double y0, int device_scale)
-        : DiffuseLight(bumpmap, scale, diffuse_constant)
-        , _light(light, color, trans, device_scale)
-        , _x0(x0)
-        , _y0(y0) {}
-
-    guint32 operator()(int x, int y)
-    {
-        NR::Fvector light, light_components;
-        _light.light_vector(light, _x0 + x, _y0 + y, _scale * alphaAt(x, y)/255.0);
-        _light.light_components(light_components, light);
-        return diffuseLighting(x, y, light, light_components);
-    }
-
-private:
-    SpotLight _light;
-    double _x0, _y0;
-};
-
 void FilterDiffuseLighting::render_cairo(FilterSlot &slot) const
 {
     cairo_surface_t *input = slot.getcairo(_input);
@@ -171,18 +77,17 @@ void FilterDiffuseLighting::render_cairo(FilterSlot &slot) const
 
     Geom::Affine trans = slot.get_units().get_matrix_primitiveunits2pb();
 
-    double x0 = p.x(), y0 = p.y();
     double scale = surfaceScale * trans.descrim() * device_scale;
 
     switch (light_type) {
     case DISTANT_LIGHT:
-        ink_cairo_surface_synthesize(out, DiffuseDistantLight(input, light.distant, color, scale, diffuseConstant));
+        render_diffuse_lighting(out, *slot.get_bumpmap(_input), LightSource(light.distant, color), scale, diffuseConstant);
         break;
     case POINT_LIGHT:
-        ink_cairo_surface_synthesize(out, DiffusePointLight(input, light.point, color, trans, scale, diffuseConstant, x0, y0, device_scale));
+        render_diffuse_lighting(out, *slot.get_bumpmap(_input), LightSource(light.point, color, trans, p, device_scale), scale, diffuseConstant);
         break;
     case SPOT_LIGHT:
-        ink_cairo_surface_synthesize(out, DiffuseSpotLight(input, light.spot, color, trans, scale, diffuseConstant, x0, y0, device_scale));
+        render_diffuse_lighting(out, *slot.get_bumpmap(_input), LightSource(light.spot, color, trans, p, device_scale), scale, diffuseConstant);
         break;
     default: {
         cairo_t *ct = cairo_create(out);
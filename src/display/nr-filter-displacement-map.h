@@ -30,6 +30,7 @@ public:
 
     void set_input(int slot) override;
     void set_input(int input, int slot) override;
+    std::vector<int> get_inputs() const override { return {_input, _input2}; }
     void set_scale(double s);
     void set_channel_selector(int s, FilterDisplacementMapChannelSelector channel);
 
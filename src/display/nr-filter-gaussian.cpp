@@ -17,11 +17,14 @@
 #endif
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 #include <complex>
+#include <cstdint>
 #include <cstdlib>
 #include <glib.h>
 #include <limits>
+#include <vector>
 #if HAVE_OPENMP
 #include <omp.h>
 #endif //HAVE_OPENMP
@@ -56,6 +59,14 @@
 // filters are used).
 static size_t const N = 3;
 
+// Number of adjacent columns filtered together in the vertical IIR pass. Each step then reads and
+// writes a run of IIR_BLOCK pixels along a row instead of one pixel per cache line, and the inner
+// loops run over IIR_BLOCK * PC independent values, which the compiler can vectorise.
+static unsigned int const IIR_BLOCK = 16;
+
+// Number of box filters used to approximate a Gaussian at the lowest blur qualities.
+static int const BOX_PASSES = 3;
+
 template<typename InIt, typename OutIt, typename Size>
 inline void copy_n(InIt beg_in, Size N, OutIt beg_out) {
     std::copy(beg_in, beg_in+N, beg_out);
@@ -285,7 +296,8 @@ static void calcTriggsSdikaInitialization(double const M[N*N], IIRValue const uo
 }
 
 // Filters over 1st dimension
-template<typename PT, unsigned int PC, bool PREMULTIPLIED_ALPHA>
+// Lines are processed in groups of up to BLOCK lines, which must be adjacent in memory if BLOCK > 1.
+template<typename PT, unsigned int PC, bool PREMULTIPLIED_ALPHA, unsigned int BLOCK>
 static void
 filter2D_IIR(PT *const dest, int const dstr1, int const dstr2,
              PT const *const src, int const sstr1, int const sstr2,
@@ -293,6 +305,10 @@ filter2D_IIR(PT *const dest, int const dstr1, int const dstr2,
              IIRValue *const tmpdata[], int const num_threads)
 {
     assert(src && dest);
+    assert(BLOCK == 1 || (sstr2 == PC && dstr2 == PC));
+
+    // Maximum number of values filtered together.
+    static unsigned int const L = BLOCK * PC;
 
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
     static unsigned int const alpha_PC = PC-1;
@@ -302,62 +318,154 @@ filter2D_IIR(PT *const dest, int const dstr1, int const dstr2,
     #define PREMUL_ALPHA_LOOP for(unsigned int c=1; c<PC; ++c)
 #endif
 
+    int const num_groups = (n2 + BLOCK - 1) / BLOCK;
+
 INK_UNUSED(num_threads); // to suppress unused argument compiler warning
 #if HAVE_OPENMP
 #pragma omp parallel for num_threads(num_threads)
 #endif // HAVE_OPENMP
-    for ( int c2 = 0 ; c2 < n2 ; c2++ ) {
+    for ( int g = 0 ; g < num_groups ; g++ ) {
 #if HAVE_OPENMP
         unsigned int tid = omp_get_thread_num();
 #else
         unsigned int tid = 0;
 #endif // HAVE_OPENMP
-        // corresponding line in the source and output buffer
+        int const c2 = g * BLOCK;
+        unsigned int const count = std::min<int>(BLOCK, n2 - c2);
+        unsigned int const lanes = count * PC;
+        IIRValue *const tmp = tmpdata[tid];
+
+        // corresponding lines in the source and output buffer
         PT const * srcimg = src  + c2*sstr2;
         PT       * dstimg = dest + c2*dstr2 + n1*dstr1;
         // Border constants
-        IIRValue imin[PC];  copy_n(srcimg + (0)*sstr1, PC, imin);
-        IIRValue iplus[PC]; copy_n(srcimg + (n1-1)*sstr1, PC, iplus);
+        IIRValue imin[L] = {};  copy_n(srcimg + (0)*sstr1, lanes, imin);
+        IIRValue iplus[L] = {}; copy_n(srcimg + (n1-1)*sstr1, lanes, iplus);
         // Forward pass
-        IIRValue u[N+1][PC];
-        for(unsigned int i=0; i<N; i++) copy_n(imin, PC, u[i]);
+        IIRValue u[N+1][L] = {};
+        for(unsigned int i=0; i<N; i++) copy_n(imin, lanes, u[i]);
         for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
-            for(unsigned int i=N; i>0; i--) copy_n(u[i-1], PC, u[i]);
-            copy_n(srcimg, PC, u[0]);
+            for(unsigned int i=N; i>0; i--) copy_n(u[i-1], lanes, u[i]);
+            copy_n(srcimg, lanes, u[0]);
             srcimg += sstr1;
-            for(unsigned int c=0; c<PC; c++) u[0][c] *= b[0];
+            for(unsigned int c=0; c<lanes; c++) u[0][c] *= b[0];
             for(unsigned int i=1; i<N+1; i++) {
-                for(unsigned int c=0; c<PC; c++) u[0][c] += u[i][c]*b[i];
+                for(unsigned int c=0; c<lanes; c++) u[0][c] += u[i][c]*b[i];
             }
-            copy_n(u[0], PC, tmpdata[tid]+c1*PC);
+            copy_n(u[0], lanes, tmp+c1*lanes);
         }
         // Backward pass
-        IIRValue v[N+1][PC];
-        calcTriggsSdikaInitialization<PC>(M, u, iplus, iplus, b[0], v);
-        dstimg -= dstr1;
-        if ( PREMULTIPLIED_ALPHA ) {
-            dstimg[alpha_PC] = clip_round_cast<PT>(v[0][alpha_PC]);
-            PREMUL_ALPHA_LOOP dstimg[c] = clip_round_cast_varmax<PT>(v[0][c], dstimg[alpha_PC]);
-        } else {
-            for(unsigned int c=0; c<PC; c++) dstimg[c] = clip_round_cast<PT>(v[0][c]);
-        }
+        IIRValue v[N+1][L];
+        calcTriggsSdikaInitialization<L>(M, u, iplus, iplus, b[0], v);
+        auto store = [&] {
+            dstimg -= dstr1;
+            for(unsigned int k=0; k<count; k++) {
+                PT *const px = dstimg + k*PC;
+                IIRValue const *const val = v[0] + k*PC;
+                if ( PREMULTIPLIED_ALPHA ) {
+                    px[alpha_PC] = clip_round_cast<PT>(val[alpha_PC]);
+                    PREMUL_ALPHA_LOOP px[c] = clip_round_cast_varmax<PT>(val[c], px[alpha_PC]);
+                } else {
+                    for(unsigned int c=0; c<PC; c++) px[c] = clip_round_cast<PT>(val[c]);
+                }
+            }
+        };
+        store();
         int c1=n1-1;
         while(c1-->0) {
-            for(unsigned int i=N; i>0; i--) copy_n(v[i-1], PC, v[i]);
-            copy_n(tmpdata[tid]+c1*PC, PC, v[0]);
-            for(unsigned int c=0; c<PC; c++) v[0][c] *= b[0];
+            for(unsigned int i=N; i>0; i--) copy_n(v[i-1], lanes, v[i]);
+            copy_n(tmp+c1*lanes, lanes, v[0]);
+            for(unsigned int c=0; c<lanes; c++) v[0][c] *= b[0];
             for(unsigned int i=1; i<N+1; i++) {
-                for(unsigned int c=0; c<PC; c++) v[0][c] += v[i][c]*b[i];
+                for(unsigned int c=0; c<lanes; c++) v[0][c] += v[i][c]*b[i];
             }
-            dstimg -= dstr1;
-            if ( PREMULTIPLIED_ALPHA ) {
-                dstimg[alpha_PC] = clip_round_cast<PT>(v[0][alpha_PC]);
-                PREMUL_ALPHA_LOOP dstimg[c] = clip_round_cast_varmax<PT>(v[0][c], dstimg[alpha_PC]);
-            } else {
-                for(unsigned int c=0; c<PC; c++) dstimg[c] = clip_round_cast<PT>(v[0][c]);
+            store();
+        }
+    }
+
+    #undef PREMUL_ALPHA_LOOP
+}
+
+// Compute the widths of BOX_PASSES box filters whose successive application approximates a Gaussian.
+// From: P. Kovesi, Fast Almost-Gaussian Filtering, DICTA 2010.
+static std::array<int, BOX_PASSES> box_widths(double const sigma)
+{
+    int const n = BOX_PASSES;
+    int wl = static_cast<int>(std::sqrt(12 * sqr(sigma) / n + 1));
+    if (wl % 2 == 0) wl--;
+    int const wu = wl + 2;
+    int const m = static_cast<int>(std::round((12 * sqr(sigma) - n * sqr(wl) - 4 * n * wl - 3 * n) / (-4 * wl - 4)));
+
+    std::array<int, BOX_PASSES> widths;
+    for (int i = 0; i < n; i++) {
+        widths[i] = i < m ? wl : wu;
+    }
+    return widths;
+}
+
+// Filters over 1st dimension with a cascade of box filters, in place.
+// Lines are processed in groups of up to BLOCK lines, which must be adjacent in memory if BLOCK > 1.
+// Premultiplied alpha is preserved without clamping, since every channel is averaged with the same weights.
+template<typename PT, unsigned int PC, unsigned int BLOCK>
+static void
+filter2D_box(PT *const data, int const str1, int const str2, int const n1, int const n2,
+             std::array<int, BOX_PASSES> const &widths, int const num_threads)
+{
+    assert(data);
+    assert(BLOCK == 1 || str2 == PC);
+
+    static unsigned int const L = BLOCK * PC;
+    int const num_groups = (n2 + BLOCK - 1) / BLOCK;
+
+INK_UNUSED(num_threads); // to suppress unused argument compiler warning
+#if HAVE_OPENMP
+#pragma omp parallel num_threads(num_threads)
+#endif // HAVE_OPENMP
+    {
+    // Each thread works on a contiguous copy of its lines, ping-ponging between two buffers.
+    std::vector<std::uint32_t> a(n1 * L), b(n1 * L);
+
+#if HAVE_OPENMP
+#pragma omp for
+#endif // HAVE_OPENMP
+    for ( int g = 0 ; g < num_groups ; g++ ) {
+        int const c2 = g * BLOCK;
+        unsigned int const count = std::min<int>(BLOCK, n2 - c2);
+        unsigned int const lanes = count * PC;
+        PT *const line = data + c2*str2;
+
+        for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
+            std::copy_n(line + c1*str1, lanes, a.data() + c1*lanes);
+        }
+
+        for (int const w : widths) {
+            int const r = w / 2;
+            float const inv_w = 1.0f / w;
+
+            // Running sums over the window, with the edge pixels repeated outwards.
+            std::uint32_t acc[L] = {};
+            for(unsigned int c=0; c<lanes; c++) acc[c] = (r+1) * a[c];
+            for ( int i = 1 ; i <= r ; i++ ) {
+                auto const in = a.data() + std::min(i, n1-1)*lanes;
+                for(unsigned int c=0; c<lanes; c++) acc[c] += in[c];
             }
+
+            for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
+                auto const out = b.data() + c1*lanes;
+                for(unsigned int c=0; c<lanes; c++) out[c] = static_cast<std::uint32_t>(acc[c] * inv_w + 0.5f);
+                auto const add = a.data() + std::min(c1+r+1, n1-1)*lanes;
+                auto const sub = a.data() + std::max(c1-r, 0)*lanes;
+                for(unsigned int c=0; c<lanes; c++) acc[c] += add[c] - sub[c];
+            }
+
+            std::swap(a, b);
+        }
+
+        for ( int c1 = 0 ; c1 < n1 ; c1++ ) {
+            std::copy_n(a.data() + c1*lanes, lanes, line + c1*str1);
         }
     }
+    }
 }
 
 // Filters over 1st dimension
@@ -494,19 +602,33 @@ gaussian_pass_IIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_su
     int h = cairo_image_surface_get_height(src);
     if (d != Geom::X) std::swap(w, h);
 
-    // Filter
+    // Filter (rows one at a time, columns in blocks)
     switch (cairo_image_surface_get_format(src)) {
     case CAIRO_FORMAT_A8:        ///< Grayscale
-        filter2D_IIR<unsigned char,1,false>(
-            cairo_image_surface_get_data(dest), d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
-            cairo_image_surface_get_data(src),  d == Geom::X ? 1 : stride, d == Geom::X ? stride : 1,
-            w, h, b, M, tmpdata, num_threads);
+        if (d == Geom::X) {
+            filter2D_IIR<unsigned char,1,false,1>(
+                cairo_image_surface_get_data(dest), 1, stride,
+                cairo_image_surface_get_data(src),  1, stride,
+                w, h, b, M, tmpdata, num_threads);
+        } else {
+            filter2D_IIR<unsigned char,1,false,IIR_BLOCK>(
+                cairo_image_surface_get_data(dest), stride, 1,
+                cairo_image_surface_get_data(src),  stride, 1,
+                w, h, b, M, tmpdata, num_threads);
+        }
         break;
     case CAIRO_FORMAT_ARGB32: ///< Premultiplied 8 bit RGBA
-        filter2D_IIR<unsigned char,4,true>(
-            cairo_image_surface_get_data(dest), d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
-            cairo_image_surface_get_data(src),  d == Geom::X ? 4 : stride, d == Geom::X ? stride : 4,
-            w, h, b, M, tmpdata, num_threads);
+        if (d == Geom::X) {
+            filter2D_IIR<unsigned char,4,true,1>(
+                cairo_image_surface_get_data(dest), 4, stride,
+                cairo_image_surface_get_data(src),  4, stride,
+                w, h, b, M, tmpdata, num_threads);
+        } else {
+            filter2D_IIR<unsigned char,4,true,IIR_BLOCK>(
+                cairo_image_surface_get_data(dest), stride, 4,
+                cairo_image_surface_get_data(src),  stride, 4,
+                w, h, b, M, tmpdata, num_threads);
+        }
         break;
     default:
         g_warning("gaussian_pass_IIR: unsupported image format");
@@ -546,6 +668,37 @@ gaussian_pass_FIR(Geom::Dim2 d, double deviation, cairo_surface_t *src, cairo_su
     };
 }
 
+static void
+gaussian_pass_box(Geom::Dim2 d, double deviation, cairo_surface_t *surface, int num_threads)
+{
+    auto const widths = box_widths(deviation);
+
+    int stride = cairo_image_surface_get_stride(surface);
+    int w = cairo_image_surface_get_width(surface);
+    int h = cairo_image_surface_get_height(surface);
+    if (d != Geom::X) std::swap(w, h);
+
+    // Filter (rows one at a time, columns in blocks)
+    switch (cairo_image_surface_get_format(surface)) {
+    case CAIRO_FORMAT_A8:        ///< Grayscale
+        if (d == Geom::X) {
+            filter2D_box<unsigned char,1,1>(cairo_image_surface_get_data(surface), 1, stride, w, h, widths, num_threads);
+        } else {
+            filter2D_box<unsigned char,1,IIR_BLOCK>(cairo_image_surface_get_data(surface), stride, 1, w, h, widths, num_threads);
+        }
+        break;
+    case CAIRO_FORMAT_ARGB32: ///< Premultiplied 8 bit RGBA
+        if (d == Geom::X) {
+            filter2D_box<unsigned char,4,1>(cairo_image_surface_get_data(surface), 4, stride, w, h, widths, num_threads);
+        } else {
+            filter2D_box<unsigned char,4,IIR_BLOCK>(cairo_image_surface_get_data(surface), stride, 4, w, h, widths, num_threads);
+        }
+        break;
+    default:
+        g_warning("gaussian_pass_box: unsupported image format");
+    };
+}
+
 void FilterGaussian::render_cairo(FilterSlot &slot) const
 {
     cairo_surface_t *in = slot.getcairo(_input);
@@ -599,6 +752,7 @@ void FilterGaussian::render_cairo(FilterSlot &slot) const
 
     int quality = slot.get_blurquality();
     int threads = get_num_filter_threads();
+
     int x_step = 1 << _effect_subsample_step_log2(deviation_x_orig, quality);
     int y_step = 1 << _effect_subsample_step_log2(deviation_y_orig, quality);
     bool resampling = x_step > 1 || y_step > 1;
@@ -619,13 +773,23 @@ void FilterGaussian::render_cairo(FilterSlot &slot) const
     bool use_IIR_x = deviation_x > 3;
     bool use_IIR_y = deviation_y > 3;
 
+    // At the lowest qualities, a cascade of box filters replaces the IIR filter for the large deviations
+    // that subsampling leaves over (only when the subsampling step is at its limit). Small deviations
+    // are still filtered exactly, as box filters approximate them too coarsely.
+    bool const use_box = _method == Method::Box ||
+        (_method == Method::Automatic && (quality == BLUR_QUALITY_WORSE || quality == BLUR_QUALITY_WORST));
+    bool const use_box_x = use_box && use_IIR_x;
+    bool const use_box_y = use_box && use_IIR_y;
+    if (use_box_x) use_IIR_x = false;
+    if (use_box_y) use_IIR_y = false;
+
     // Temporary storage for IIR filter
     // NOTE: This can be eliminated, but it reduces the precision a bit
     IIRValue * tmpdata[threads];
     std::fill_n(tmpdata, threads, (IIRValue*)0);
     if ( use_IIR_x || use_IIR_y ) {
         for(int i = 0; i < threads; ++i) {
-            tmpdata[i] = new IIRValue[std::max(w_downsampled,h_downsampled)*bytes_per_pixel];
+            tmpdata[i] = new IIRValue[std::max(w_downsampled,h_downsampled)*bytes_per_pixel*IIR_BLOCK];
         }
     }
 
@@ -646,7 +810,9 @@ void FilterGaussian::render_cairo(FilterSlot &slot) const
     cairo_surface_flush(downsampled);
 
     if (scr_len_x > 0) {
-        if (use_IIR_x) {
+        if (use_box_x) {
+            gaussian_pass_box(Geom::X, deviation_x, downsampled, threads);
+        } else if (use_IIR_x) {
             gaussian_pass_IIR(Geom::X, deviation_x, downsampled, downsampled, tmpdata, threads);
         } else {
             gaussian_pass_FIR(Geom::X, deviation_x, downsampled, downsampled, threads);
@@ -654,7 +820,9 @@ void FilterGaussian::render_cairo(FilterSlot &slot) const
     }
 
     if (scr_len_y > 0) {
-        if (use_IIR_y) {
+        if (use_box_y) {
+            gaussian_pass_box(Geom::Y, deviation_y, downsampled, threads);
+        } else if (use_IIR_y) {
             gaussian_pass_IIR(Geom::Y, deviation_y, downsampled, downsampled, tmpdata, threads);
         } else {
             gaussian_pass_FIR(Geom::Y, deviation_y, downsampled, downsampled, threads);
@@ -732,6 +900,11 @@ void FilterGaussian::set_deviation(double x, double y)
     }
 }
 
+void FilterGaussian::set_method(Method m)
+{
+    _method = m;
+}
+
 } // namespace Filters
 } // namespace Inkscape
 
@@ -33,6 +33,14 @@ namespace Filters {
 class FilterGaussian : public FilterPrimitive
 {
 public:
+    /// The ways of filtering passes whose deviation is too large for a direct kernel.
+    enum class Method
+    {
+        Automatic, ///< Box filters at the lowest qualities, IIR otherwise.
+        IIR,
+        Box ///< A cascade of box filters, which only approximates the Gaussian.
+    };
+
     FilterGaussian();
     ~FilterGaussian() override;
 
@@ -59,11 +67,14 @@ public:
      */
     void set_deviation(double x, double y);
 
+    void set_method(Method m);
+
     Glib::ustring name() const override { return Glib::ustring("Gaussian Blur"); }
 
 private:
     double _deviation_x;
     double _deviation_y;
+    Method _method = Method::Automatic;
 };
 
 } // namespace Filters
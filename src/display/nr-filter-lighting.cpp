@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Shared renderer for the feDiffuseLighting and feSpecularLighting filter primitives
+ *
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"  // only include where actually required!
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <2geom/point.h>
+
+#include "display/cairo-templates.h"
+#include "display/cairo-utils.h"
+#include "display/nr-filter-lighting.h"
+#include "display/nr-light.h"
+#include "color.h"
+
+namespace Inkscape {
+namespace Filters {
+
+BumpMap::BumpMap(cairo_surface_t *surface)
+    : _w(cairo_image_surface_get_width(surface))
+    , _h(cairo_image_surface_get_height(surface))
+    , _slope_x(_w * _h)
+    , _slope_y(_w * _h)
+    , _heights(_w * _h)
+{
+    cairo_surface_flush(surface);
+    unsigned char const *data = cairo_image_surface_get_data(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+    bool const alpha_only = cairo_image_surface_get_format(surface) == CAIRO_FORMAT_A8;
+
+    std::vector<float> alpha(_w * _h);
+    for (int y = 0; y < _h; ++y) {
+        for (int x = 0; x < _w; ++x) {
+            alpha[y * _w + x] = alpha_only ? data[y * stride + x]
+                                           : reinterpret_cast<guint32 const *>(data + y * stride)[x] >> 24;
+            _heights[y * _w + x] = alpha[y * _w + x] / 255.0f;
+        }
+    }
+
+    // The Sobel kernels, where the rows and columns outside the surface are left out and the
+    // factors adjusted to match. This gives the edge and corner kernels of the specification.
+#if HAVE_OPENMP
+    #pragma omp parallel for if(_w * _h > OPENMP_THRESHOLD) num_threads(get_num_filter_threads())
+#endif
+    for (int y = 0; y < _h; ++y) {
+        int const ya = std::max(y - 1, 0), yb = std::min(y + 1, _h - 1);
+        float const *above = alpha.data() + ya * _w;
+        float const *row = alpha.data() + y * _w;
+        float const *below = alpha.data() + yb * _w;
+        float const wa = ya != y, wb = yb != y;
+        float const span_y = yb - ya;
+
+        for (int x = 0; x < _w; ++x) {
+            int const xa = std::max(x - 1, 0), xb = std::min(x + 1, _w - 1);
+            float const wl = xa != x, wr = xb != x;
+            float const span_x = xb - xa;
+
+            float const left = wa * above[xa] + 2.0f * row[xa] + wb * below[xa];
+            float const right = wa * above[xb] + 2.0f * row[xb] + wb * below[xb];
+            float const top = wl * above[xa] + 2.0f * above[x] + wr * above[xb];
+            float const bottom = wl * below[xa] + 2.0f * below[x] + wr * below[xb];
+
+            float const fx = span_x == 0.0f ? 0.0f : -2.0f / (255.0f * span_x * (2.0f + wa + wb));
+            float const fy = span_y == 0.0f ? 0.0f : -2.0f / (255.0f * span_y * (2.0f + wl + wr));
+            _slope_x[y * _w + x] = fx * (right - left);
+            _slope_y[y * _w + x] = fy * (bottom - top);
+        }
+    }
+}
+
+LightSource::LightSource(DistantLightData const &light, guint32 lighting_color)
+    : type(DISTANT_LIGHT)
+    , color{ float(SP_RGBA32_R_U(lighting_color)), float(SP_RGBA32_G_U(lighting_color)),
+             float(SP_RGBA32_B_U(lighting_color)) }
+    , direction{}
+    , cos_limit(-1)
+    , exponent(1)
+{
+    DistantLight dl(light, lighting_color);
+    NR::Fvector v;
+    dl.light_vector(v);
+    for (int i = 0; i < 3; ++i) {
+        vector[i] = v[i];
+    }
+}
+
+LightSource::LightSource(PointLightData const &light, guint32 lighting_color, Geom::Affine const &trans,
+                         Geom::Point const &origin, int device_scale)
+    : type(POINT_LIGHT)
+    , color{ float(SP_RGBA32_R_U(lighting_color)), float(SP_RGBA32_G_U(lighting_color)),
+             float(SP_RGBA32_B_U(lighting_color)) }
+    , direction{}
+    , cos_limit(-1)
+    , exponent(1)
+{
+    auto const p = PointLight(light, lighting_color, trans, device_scale).position();
+    vector[X_3D] = p[X_3D] - origin[Geom::X];
+    vector[Y_3D] = p[Y_3D] - origin[Geom::Y];
+    vector[Z_3D] = p[Z_3D];
+}
+
+LightSource::LightSource(SpotLightData const &light, guint32 lighting_color, Geom::Affine const &trans,
+                         Geom::Point const &origin, int device_scale)
+    : type(SPOT_LIGHT)
+    , color{ float(SP_RGBA32_R_U(lighting_color)), float(SP_RGBA32_G_U(lighting_color)),
+             float(SP_RGBA32_B_U(lighting_color)) }
+{
+    SpotLight sl(light, lighting_color, trans, device_scale);
+    auto const p = sl.position();
+    vector[X_3D] = p[X_3D] - origin[Geom::X];
+    vector[Y_3D] = p[Y_3D] - origin[Geom::Y];
+    vector[Z_3D] = p[Z_3D];
+    for (int i = 0; i < 3; ++i) {
+        direction[i] = sl.direction()[i];
+    }
+    cos_limit = sl.cos_limiting_cone_angle();
+    exponent = sl.specular_exponent();
+}
+
+namespace {
+
+// log2(x) for x > 0, with an absolute error below 1e-6.
+inline float fast_log2(float x)
+{
+    // Split x into 2^e * m, with m in [sqrt(1/2), sqrt(2)).
+    auto const bits = std::bit_cast<std::int32_t>(x);
+    auto const e = (bits - 0x3f3504f3) >> 23;
+    float const m = std::bit_cast<float>(bits - (e << 23));
+    // log2(m) = 2 atanh(s) / ln(2), where s = (m - 1) / (m + 1) is less than 0.172 in magnitude.
+    float const s = (m - 1.0f) / (m + 1.0f);
+    float const s2 = s * s;
+    return e + s * (2.88539008f + s2 * (0.961796694f + s2 * (0.577078016f + s2 * 0.412198583f)));
+}
+
+// 2^t, with a relative error below 1e-6.
+inline float fast_exp2(float t)
+{
+    t = std::clamp(t, -125.0f, 125.0f);
+    // Split t into i + f, with f in [-1/2, 1/2].
+    float const r = t + 0.5f;
+    int i = static_cast<int>(r);
+    i -= i > r;
+    float const f = t - i;
+    // 2^f = e^(f ln(2)), by its Taylor series.
+    float const p = 1.0f + f * (0.693147181f + f * (0.240226507f + f * (0.0555041087f + f * (0.00961812911f
+                  + f * (0.00133335581f + f * 0.000154035304f)))));
+    return std::bit_cast<float>(std::bit_cast<std::int32_t>(p) + (i << 23));
+}
+
+// x^e for x > 0, accurate far beyond the 8-bit output, but inlined and vectorisable unlike std::pow().
+inline float fast_pow(float x, float e)
+{
+    return fast_exp2(e * fast_log2(x));
+}
+
+inline guint32 to_u8(float v)
+{
+    return v > 0.0f ? static_cast<guint32>(std::min(v, 255.0f) + 0.5f) : 0;
+}
+
+// Light a bump map. The lighting of each row is computed in float in loops over the pixels,
+// which the compiler can vectorise, and only packed into pixels at the end.
+template <LightType type, bool specular>
+void render_lighting(cairo_surface_t *out, BumpMap const &bumpmap, LightSource const &light,
+                     float scale, float constant, float exponent)
+{
+    int const w = bumpmap.width();
+    int const h = bumpmap.height();
+    int const stride = cairo_image_surface_get_stride(out);
+    unsigned char *data = cairo_image_surface_get_data(out);
+
+#if HAVE_OPENMP
+    #pragma omp parallel for if(w * h > OPENMP_THRESHOLD) num_threads(get_num_filter_threads())
+#endif
+    for (int y = 0; y < h; ++y) {
+        float const *slope_x = bumpmap.slope_x(y);
+        float const *slope_y = bumpmap.slope_y(y);
+        float const *heights = bumpmap.heights(y);
+        std::vector<float> intensity(w);
+
+        for (int x = 0; x < w; ++x) {
+            // The surface normal.
+            float nx = scale * slope_x[x];
+            float ny = scale * slope_y[x];
+            float const nz = 1.0f / std::sqrt(nx * nx + ny * ny + 1.0f);
+            nx *= nz;
+            ny *= nz;
+
+            // The unit vector towards the light.
+            float lx = light.vector[X_3D], ly = light.vector[Y_3D], lz = light.vector[Z_3D];
+            if constexpr (type != DISTANT_LIGHT) {
+                lx -= x;
+                ly -= y;
+                lz -= scale * heights[x];
+                float const inv = 1.0f / std::sqrt(lx * lx + ly * ly + lz * lz);
+                lx *= inv;
+                ly *= inv;
+                lz *= inv;
+            }
+
+            float k;
+            if constexpr (specular) {
+                // The halfway vector between the light and the eye, at (0, 0, 1).
+                float const hz = lz + 1.0f;
+                float const sp = (nx * lx + ny * ly + nz * hz) / std::sqrt(lx * lx + ly * ly + hz * hz);
+                k = sp <= 0.0f ? 0.0f : constant * fast_pow(sp, exponent);
+            } else {
+                k = constant * (nx * lx + ny * ly + nz * lz);
+            }
+
+            if constexpr (type == SPOT_LIGHT) {
+                float const c = -(lx * light.direction[X_3D] + ly * light.direction[Y_3D] + lz * light.direction[Z_3D]);
+                k *= c <= light.cos_limit || c <= 0.0f ? 0.0f : fast_pow(c, light.exponent);
+            }
+            intensity[x] = k;
+        }
+
+        auto row = reinterpret_cast<guint32 *>(data + y * stride);
+        for (int x = 0; x < w; ++x) {
+            guint32 r = to_u8(intensity[x] * light.color[LIGHT_RED]);
+            guint32 g = to_u8(intensity[x] * light.color[LIGHT_GREEN]);
+            guint32 b = to_u8(intensity[x] * light.color[LIGHT_BLUE]);
+            if constexpr (specular) {
+                guint32 a = std::max(std::max(r, g), b);
+                r = premul_alpha(r, a);
+                g = premul_alpha(g, a);
+                b = premul_alpha(b, a);
+                ASSEMBLE_ARGB32(pxout, a,r,g,b)
+                row[x] = pxout;
+            } else {
+                ASSEMBLE_ARGB32(pxout, 255,r,g,b)
+                row[x] = pxout;
+            }
+        }
+    }
+    cairo_surface_mark_dirty(out);
+}
+
+template <bool specular>
+void render_lighting(cairo_surface_t *out, BumpMap const &bumpmap, LightSource const &light,
+                     float scale, float constant, float exponent)
+{
+    switch (light.type) {
+        case DISTANT_LIGHT:
+            render_lighting<DISTANT_LIGHT, specular>(out, bumpmap, light, scale, constant, exponent);
+            break;
+        case POINT_LIGHT:
+            render_lighting<POINT_LIGHT, specular>(out, bumpmap, light, scale, constant, exponent);
+            break;
+        case SPOT_LIGHT:
+            render_lighting<SPOT_LIGHT, specular>(out, bumpmap, light, scale, constant, exponent);
+            break;
+        default:
+            break;
+    }
+}
+
+} // namespace
+
+void render_diffuse_lighting(cairo_surface_t *out, BumpMap const &bumpmap, LightSource const &light,
+                             double scale, double diffuse_constant)
+{
+    render_lighting<false>(out, bumpmap, light, scale, diffuse_constant, 1.0);
+}
+
+void render_specular_lighting(cairo_surface_t *out, BumpMap const &bumpmap, LightSource const &light,
+                              double scale, double specular_constant, double specular_exponent)
+{
+    render_lighting<true>(out, bumpmap, light, scale, specular_constant, specular_exponent);
+}
+
+} // namespace Filters
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
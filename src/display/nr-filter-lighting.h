@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+#ifndef SEEN_NR_FILTER_LIGHTING_H
+#define SEEN_NR_FILTER_LIGHTING_H
+
+/*
+ * Shared renderer for the feDiffuseLighting and feSpecularLighting filter primitives
+ *
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <vector>
+#include <2geom/forward.h>
+
+#include "display/nr-light-types.h"
+
+extern "C" {
+typedef struct _cairo_surface cairo_surface_t;
+}
+typedef unsigned int guint32;
+
+namespace Inkscape {
+namespace Filters {
+
+/**
+ * The slope of the alpha channel of a surface, which the lighting primitives use as a bump map.
+ *
+ * The slopes are computed with the Sobel kernels of the specification, but without the surface
+ * scale, so that all the lighting primitives reading the same input can share one bump map.
+ */
+class BumpMap
+{
+public:
+    explicit BumpMap(cairo_surface_t *surface);
+
+    int width() const { return _w; }
+    int height() const { return _h; }
+
+    /// The horizontal slopes of a row of the surface, per unit of surface scale.
+    float const *slope_x(int y) const { return _slope_x.data() + y * _w; }
+    /// The vertical slopes of a row of the surface, per unit of surface scale.
+    float const *slope_y(int y) const { return _slope_y.data() + y * _w; }
+    /// The heights of a row of the surface, as fractions of the surface scale.
+    float const *heights(int y) const { return _heights.data() + y * _w; }
+
+private:
+    int _w, _h;
+    std::vector<float> _slope_x, _slope_y, _heights;
+};
+
+/// A light source, in the pixel coordinates of the surface being lit.
+struct LightSource
+{
+    LightSource(DistantLightData const &light, guint32 color);
+    LightSource(PointLightData const &light, guint32 color, Geom::Affine const &trans,
+                Geom::Point const &origin, int device_scale);
+    LightSource(SpotLightData const &light, guint32 color, Geom::Affine const &trans,
+                Geom::Point const &origin, int device_scale);
+
+    LightType type;
+    float color[3];     ///< The red, green and blue components, from 0 to 255.
+    float vector[3];    ///< The unit vector towards a distant light, or the position of another light.
+    float direction[3]; ///< The unit vector in the direction a spot light points at.
+    float cos_limit;    ///< The cosine of the limiting cone angle of a spot light.
+    float exponent;     ///< The exponent of the falloff of a spot light.
+};
+
+/// Fill an image surface with the diffuse lighting of a bump map.
+void render_diffuse_lighting(cairo_surface_t *out, BumpMap const &bumpmap, LightSource const &light,
+                             double scale, double diffuse_constant);
+
+/// Fill an image surface with the specular lighting of a bump map.
+void render_specular_lighting(cairo_surface_t *out, BumpMap const &bumpmap, LightSource const &light,
+                              double scale, double specular_constant, double specular_exponent);
+
+} // namespace Filters
+} // namespace Inkscape
+
+#endif // SEEN_NR_FILTER_LIGHTING_H
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
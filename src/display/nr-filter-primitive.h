@@ -13,6 +13,7 @@
 #define SEEN_NR_FILTER_PRIMITIVE_H
 
 #include <memory>
+#include <vector>
 #include <2geom/forward.h>
 #include <2geom/rect.h>
 
@@ -72,6 +73,15 @@ public:
      */
     virtual void set_output(int slot);
 
+    /**
+     * Returns the slots read by this primitive, as set with set_input(). Unset inputs are
+     * returned as NR_FILTER_SLOT_NOT_SET.
+     */
+    virtual std::vector<int> get_inputs() const { return {_input}; }
+
+    /** Returns the slot written by this primitive, or NR_FILTER_SLOT_NOT_SET if unset. */
+    int get_output() const { return _output; }
+
     // returns cache score factor, reflecting the cost of rendering this filter
     // this should return how many times slower this primitive is that normal rendering
     virtual double complexity(Geom::Affine const &/*ctm*/) const { return 1.0; }
@@ -21,13 +21,15 @@
 #include "drawing-surface.h"
 #include "nr-filter-types.h"
 #include "nr-filter-gaussian.h"
+#include "nr-filter-lighting.h"
 #include "nr-filter-slot.h"
 #include "nr-filter-units.h"
 
 namespace Inkscape {
 namespace Filters {
 
-FilterSlot::FilterSlot(DrawingContext *bgdc, DrawingContext &graphic, FilterUnits const &units, RenderContext &rc, int blurquality)
+FilterSlot::FilterSlot(DrawingContext *bgdc, DrawingContext &graphic, FilterUnits const &units, RenderContext &rc, int blurquality,
+                       std::size_t cache_budget)
     : _source_graphic(graphic.rawTarget())
     , _background_ct(bgdc ? bgdc->raw() : nullptr)
     , _source_graphic_area(graphic.targetLogicalBounds().roundOutwards()) // fixme
@@ -35,6 +37,7 @@ FilterSlot::FilterSlot(DrawingContext *bgdc, DrawingContext &graphic, FilterUnit
     , _units(units)
     , _last_out(NR_FILTER_SOURCEGRAPHIC)
     , _blurquality(blurquality)
+    , _cache_budget(cache_budget)
     , rc(rc)
     , device_scale(graphic.surface()->device_scale())
 {
@@ -62,6 +65,9 @@ FilterSlot::~FilterSlot()
     for (auto &_slot : _slots) {
         cairo_surface_destroy(_slot.second);
     }
+    for (auto &b : _bumpmaps) {
+        cairo_surface_destroy(b.first);
+    }
 }
 
 cairo_surface_t *FilterSlot::getcairo(int slot_nr)
@@ -239,6 +245,34 @@ void FilterSlot::set(int slot_nr, cairo_surface_t *surface)
     _last_out = slot_nr;
 }
 
+void FilterSlot::release(int slot_nr)
+{
+    if (slot_nr == NR_FILTER_SLOT_NOT_SET || slot_nr == _last_out)
+        return;
+
+    SlotMap::iterator s = _slots.find(slot_nr);
+    if (s != _slots.end()) {
+        if (auto b = _bumpmaps.find(s->second); b != _bumpmaps.end()) {
+            cairo_surface_destroy(b->first);
+            _bumpmaps.erase(b);
+        }
+        cairo_surface_destroy(s->second);
+        _slots.erase(s);
+    }
+}
+
+std::shared_ptr<BumpMap const> FilterSlot::get_bumpmap(int slot_nr)
+{
+    cairo_surface_t *surface = getcairo(slot_nr);
+
+    auto &bumpmap = _bumpmaps[surface];
+    if (!bumpmap) {
+        bumpmap = std::make_shared<BumpMap const>(surface);
+        cairo_surface_reference(surface);
+    }
+    return bumpmap;
+}
+
 void FilterSlot::set_primitive_area(int slot_nr, Geom::Rect &area)
 {
     if (slot_nr == NR_FILTER_SLOT_NOT_SET)
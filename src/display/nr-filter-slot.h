@@ -15,7 +15,9 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cstddef>
 #include <map>
+#include <memory>
 #include "nr-filter-types.h"
 #include "nr-filter-units.h"
 
@@ -31,11 +33,14 @@ class RenderContext;
 
 namespace Filters {
 
+class BumpMap;
+
 class FilterSlot final
 {
 public:
     /** Creates a new FilterSlot object. */
-    FilterSlot(DrawingContext *bgdc, DrawingContext &graphic, FilterUnits const &units, RenderContext &rc, int blurquality);
+    FilterSlot(DrawingContext *bgdc, DrawingContext &graphic, FilterUnits const &units, RenderContext &rc, int blurquality,
+               std::size_t cache_budget = 0);
 
     /** Destroys the FilterSlot object and all its contents */
     ~FilterSlot();
@@ -57,6 +62,16 @@ public:
 
     cairo_surface_t *get_result(int slot_nr);
 
+    /** Frees the pixblock in the given slot once no more primitives will read it.
+     * The output of the most recently rendered primitive is never freed, since it
+     * is the implicit input of the next one.
+     */
+    void release(int slot);
+
+    /** Returns the bump map of the pixblock in the specified slot, computing it on first use
+     * so that all the lighting primitives reading the same input share it. */
+    std::shared_ptr<BumpMap const> get_bumpmap(int slot);
+
     void set_primitive_area(int slot, Geom::Rect &area);
     Geom::Rect get_primitive_area(int slot) const;
     
@@ -66,6 +81,9 @@ public:
     /** Gets the gaussian filtering quality. Affects used interpolation methods */
     int get_blurquality() const { return _blurquality; }
 
+    /** Gets the rendering cache budget of the drawing, in bytes, which bounds what primitives keep between renders. */
+    std::size_t get_cache_budget() const { return _cache_budget; }
+
     /** Gets the device scale; for high DPI monitors. */
     int get_device_scale() const { return device_scale; }
 
@@ -82,6 +100,10 @@ private:
     using PrimitiveAreaMap = std::map<int, Geom::Rect>;
     PrimitiveAreaMap _primitiveAreas;
 
+    // Bump maps by the surface they were computed from, which is referenced until the bump map is dropped
+    using BumpMapMap = std::map<cairo_surface_t *, std::shared_ptr<BumpMap const>>;
+    BumpMapMap _bumpmaps;
+
     int _slot_w, _slot_h;
     double _slot_x, _slot_y;
     cairo_surface_t *_source_graphic;
@@ -91,6 +113,7 @@ private:
     FilterUnits const &_units;
     int _last_out;
     int _blurquality;
+    std::size_t _cache_budget;
     int device_scale;
     RenderContext &rc;
 
@@ -24,7 +24,15 @@
 #include "display/nr-filter-turbulence.h"
 #include "display/nr-filter-units.h"
 #include "display/nr-filter-utils.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 namespace Inkscape {
 namespace Filters{
@@ -49,6 +57,12 @@ public:
 
     void init(long seed, Geom::Rect const &tile, Geom::Point const &freq, bool stitch, bool fractalnoise, int octaves)
     {
+        // Several render threads may get here at once.
+        auto lock = std::lock_guard(_mutex);
+        if (_inited) {
+            return;
+        }
+
         // setup random number generator
         _setupSeed(seed);
 
@@ -116,109 +130,21 @@ public:
         _inited = true;
     }
 
-    G_GNUC_PURE
-    guint32 turbulencePixel(Geom::Point const &p) const
+    /// Compute the turbulence at n consecutive pixels of a row, starting at pixel (x, y),
+    /// where pixel positions are mapped to filter units by trans.
+    void turbulenceRow(Geom::Affine const &trans, int x, int y, int n, guint32 *out) const
     {
-        int wrapx = _wrapx, wrapy = _wrapy, wrapw = _wrapw, wraph = _wraph;
-
-        double pixel[4];
-        double x = p[Geom::X] * _baseFreq[Geom::X];
-        double y = p[Geom::Y] * _baseFreq[Geom::Y];
-        double ratio = 1.0;
-
-        for (double & k : pixel)
-            k = 0.0;
-
-        for (int octave = 0; octave < _octaves; ++octave)
-        {
-            double tx = x + PerlinOffset;
-            double bx = floor(tx);
-            double rx0 = tx - bx, rx1 = rx0 - 1.0;
-            int bx0 = bx, bx1 = bx0 + 1;
-
-            double ty = y + PerlinOffset;
-            double by = floor(ty);
-            double ry0 = ty - by, ry1 = ry0 - 1.0;
-            int by0 = by, by1 = by0 + 1;
-
-            if (_stitchTiles) {
-                if (bx0 >= wrapx) bx0 -= wrapw;
-                if (bx1 >= wrapx) bx1 -= wrapw;
-                if (by0 >= wrapy) by0 -= wraph;
-                if (by1 >= wrapy) by1 -= wraph;
-            }
-            bx0 &= BMask;
-            bx1 &= BMask;
-            by0 &= BMask;
-            by1 &= BMask;
-
-            int i = _latticeSelector[bx0];
-            int j = _latticeSelector[bx1];
-            int b00 = _latticeSelector[i + by0];
-            int b01 = _latticeSelector[i + by1];
-            int b10 = _latticeSelector[j + by0];
-            int b11 = _latticeSelector[j + by1];
-
-            double sx = _scurve(rx0);
-            double sy = _scurve(ry0);
-
-            double result[4];
-            // channel numbering: R=0, G=1, B=2, A=3
-            for (int k = 0; k < 4; ++k) {
-                double const *qxa = _gradient[b00][k];
-                double const *qxb = _gradient[b10][k];
-                double a = _lerp(sx, rx0 * qxa[0] + ry0 * qxa[1],
-                                     rx1 * qxb[0] + ry0 * qxb[1]);
-                double const *qya = _gradient[b01][k];
-                double const *qyb = _gradient[b11][k];
-                double b = _lerp(sx, rx0 * qya[0] + ry1 * qya[1],
-                                     rx1 * qyb[0] + ry1 * qyb[1]);
-                result[k] = _lerp(sy, a, b);
-            }
-
-            if (_fractalnoise) {
-                for (int k = 0; k < 4; ++k)
-                    pixel[k] += result[k] / ratio;
-            } else {
-                for (int k = 0; k < 4; ++k)
-                    pixel[k] += fabs(result[k]) / ratio;
-            }
-
-            x *= 2;
-            y *= 2;
-            ratio *= 2;
-
-            if(_stitchTiles)
-            {
-                // Update stitch values. Subtracting PerlinOffset before the multiplication and
-                // adding it afterward simplifies to subtracting it once.
-                wrapw *= 2;
-                wraph *= 2;
-                wrapx = wrapx*2 - PerlinOffset;
-                wrapy = wrapy*2 - PerlinOffset;
+        for (int i = 0; i < n; i += Lanes) {
+            int const count = std::min(Lanes, n - i);
+            double px[Lanes], py[Lanes];
+            for (int l = 0; l < Lanes; ++l) {
+                // Spare lanes repeat the last pixel, so that they stay within the lattice.
+                Geom::Point point(x + i + std::min(l, count - 1), y);
+                point *= trans;
+                px[l] = point[Geom::X];
+                py[l] = point[Geom::Y];
             }
-        }
-
-        if (_fractalnoise) {
-            guint32 r = CLAMP_D_TO_U8((pixel[0]*255.0 + 255.0) / 2);
-            guint32 g = CLAMP_D_TO_U8((pixel[1]*255.0 + 255.0) / 2);
-            guint32 b = CLAMP_D_TO_U8((pixel[2]*255.0 + 255.0) / 2);
-            guint32 a = CLAMP_D_TO_U8((pixel[3]*255.0 + 255.0) / 2);
-            r = premul_alpha(r, a);
-            g = premul_alpha(g, a);
-            b = premul_alpha(b, a);
-            ASSEMBLE_ARGB32(pxout, a,r,g,b);
-            return pxout;
-        } else {
-            guint32 r = CLAMP_D_TO_U8(pixel[0]*255.0);
-            guint32 g = CLAMP_D_TO_U8(pixel[1]*255.0);
-            guint32 b = CLAMP_D_TO_U8(pixel[2]*255.0);
-            guint32 a = CLAMP_D_TO_U8(pixel[3]*255.0);
-            r = premul_alpha(r, a);
-            g = premul_alpha(g, a);
-            b = premul_alpha(b, a);
-            ASSEMBLE_ARGB32(pxout, a,r,g,b);
-            return pxout;
+            _turbulenceLanes(px, py, count, out + i);
         }
     }
 
@@ -247,10 +173,232 @@ public:
         }
     }*/
 
+    /// Fill an image surface with the turbulence at the pixels starting at (x0, y0), which are
+    /// mapped to filter units by trans. Noise is generated in cells that are kept for reuse while
+    /// the transform stays the same, so that panning only generates the newly exposed cells.
+    /// The cells kept take at most 1/CacheShare of cache_budget, and never more than MaxCells, but
+    /// always enough to cover the surface twice, so that the cells of the last view survive a pan.
+    void render(cairo_surface_t *surface, Geom::Affine const &trans, int x0, int y0, std::size_t cache_budget)
+    {
+        cairo_surface_flush(surface);
+        int const width = cairo_image_surface_get_width(surface);
+        int const height = cairo_image_surface_get_height(surface);
+        int const stride = cairo_image_surface_get_stride(surface);
+        unsigned char *data = cairo_image_surface_get_data(surface);
+
+        if (width * height < CellSize * CellSize) {
+            // Not worth generating whole cells for.
+            for (int y = 0; y < height; ++y) {
+                turbulenceRow(trans, x0, y0 + y, width, reinterpret_cast<guint32 *>(data + y * stride));
+            }
+            cairo_surface_mark_dirty(surface);
+            return;
+        }
+
+        auto cell_index = [] (int v) { return v >= 0 ? v / CellSize : -((-v - 1) / CellSize) - 1; };
+        int const cx0 = cell_index(x0), cx1 = cell_index(x0 + width - 1);
+        int const cy0 = cell_index(y0), cy1 = cell_index(y0 + height - 1);
+
+        struct Needed
+        {
+            CellKey key;
+            std::shared_ptr<Cell const> cell;
+            bool generated = false;
+        };
+        std::vector<Needed> needed;
+        unsigned generation;
+        {
+            auto lock = std::lock_guard(_mutex);
+            if (trans != _cellTrans) {
+                _dropCells();
+                _cellTrans = trans;
+            }
+            generation = _generation;
+            for (int cy = cy0; cy <= cy1; ++cy) {
+                for (int cx = cx0; cx <= cx1; ++cx) {
+                    auto &n = needed.emplace_back();
+                    n.key = { cx, cy };
+                    if (auto it = _cellIndex.find(n.key); it != _cellIndex.end()) {
+                        _cells.splice(_cells.begin(), _cells, it->second);
+                        n.cell = it->second->second;
+                    }
+                }
+            }
+        }
+
+        int const count = needed.size();
+#if HAVE_OPENMP
+        #pragma omp parallel for num_threads(get_num_filter_threads())
+#endif
+        for (int i = 0; i < count; ++i) {
+            auto &n = needed[i];
+            if (n.cell) {
+                continue;
+            }
+            auto cell = std::make_shared<Cell>(CellSize * CellSize);
+            for (int y = 0; y < CellSize; ++y) {
+                turbulenceRow(trans, n.key.first * CellSize, n.key.second * CellSize + y, CellSize,
+                              cell->data() + y * CellSize);
+            }
+            n.cell = std::move(cell);
+            n.generated = true;
+        }
+
+        {
+            auto lock = std::lock_guard(_mutex);
+            // Don't keep cells generated for a transform or parameters that have since changed.
+            if (generation == _generation && trans == _cellTrans) {
+                for (auto &n : needed) {
+                    if (n.generated && !_cellIndex.contains(n.key)) {
+                        _cells.emplace_front(n.key, n.cell);
+                        _cellIndex.emplace(n.key, _cells.begin());
+                    }
+                }
+                auto const budget_cells = cache_budget / CacheShare / (CellSize * CellSize * sizeof(guint32));
+                auto const max_cells = std::max(std::min(budget_cells, MaxCells), 2 * needed.size());
+                while (_cells.size() > max_cells) {
+                    _cellIndex.erase(_cells.back().first);
+                    _cells.pop_back();
+                }
+            }
+        }
+
+        for (auto const &n : needed) {
+            int const left = n.key.first * CellSize, top = n.key.second * CellSize;
+            int const xa = std::max(left, x0), xb = std::min(left + CellSize, x0 + width);
+            int const ya = std::max(top, y0), yb = std::min(top + CellSize, y0 + height);
+            for (int y = ya; y < yb; ++y) {
+                auto src = n.cell->data() + (y - top) * CellSize + (xa - left);
+                auto dst = reinterpret_cast<guint32 *>(data + (y - y0) * stride) + (xa - x0);
+                std::copy(src, src + (xb - xa), dst);
+            }
+        }
+        cairo_surface_mark_dirty(surface);
+    }
+
     bool ready() const { return _inited; }
-    void dirty() { _inited = false; }
+    void dirty()
+    {
+        auto lock = std::lock_guard(_mutex);
+        _inited = false;
+        _dropCells();
+    }
 
 private:
+    // The number of pixels computed together. The lattice coordinates and the arithmetic for each
+    // channel of these pixels run in loops over the lanes, which the compiler can vectorise.
+    static int constexpr Lanes = 8;
+
+    void _turbulenceLanes(double const *px, double const *py, int count, guint32 *out) const
+    {
+        int wrapx = _wrapx, wrapy = _wrapy, wrapw = _wrapw, wraph = _wraph;
+
+        double x[Lanes], y[Lanes];
+        for (int l = 0; l < Lanes; ++l) {
+            x[l] = px[l] * _baseFreq[Geom::X];
+            y[l] = py[l] * _baseFreq[Geom::Y];
+        }
+        // A power of two, so multiplying by its inverse is exact.
+        double inverse_ratio = 1.0;
+
+        // channel numbering: R=0, G=1, B=2, A=3
+        double pixel[4][Lanes] = {};
+
+        for (int octave = 0; octave < _octaves; ++octave)
+        {
+            double rx0[Lanes], rx1[Lanes], ry0[Lanes], ry1[Lanes], sx[Lanes], sy[Lanes];
+            int b00[Lanes], b01[Lanes], b10[Lanes], b11[Lanes];
+
+            for (int l = 0; l < Lanes; ++l) {
+                double tx = x[l] + PerlinOffset;
+                double bx = _floor(tx);
+                rx0[l] = tx - bx;
+                rx1[l] = rx0[l] - 1.0;
+                sx[l] = _scurve(rx0[l]);
+
+                double ty = y[l] + PerlinOffset;
+                double by = _floor(ty);
+                ry0[l] = ty - by;
+                ry1[l] = ry0[l] - 1.0;
+                sy[l] = _scurve(ry0[l]);
+
+                int bx0 = bx, bx1 = bx0 + 1;
+                int by0 = by, by1 = by0 + 1;
+                if (_stitchTiles) {
+                    if (bx0 >= wrapx) bx0 -= wrapw;
+                    if (bx1 >= wrapx) bx1 -= wrapw;
+                    if (by0 >= wrapy) by0 -= wraph;
+                    if (by1 >= wrapy) by1 -= wraph;
+                }
+                bx0 &= BMask;
+                bx1 &= BMask;
+                by0 &= BMask;
+                by1 &= BMask;
+
+                int i = _latticeSelector[bx0];
+                int j = _latticeSelector[bx1];
+                b00[l] = _latticeSelector[i + by0];
+                b01[l] = _latticeSelector[i + by1];
+                b10[l] = _latticeSelector[j + by0];
+                b11[l] = _latticeSelector[j + by1];
+            }
+
+            for (int k = 0; k < 4; ++k) {
+                double result[Lanes];
+                for (int l = 0; l < Lanes; ++l) {
+                    double const *qxa = _gradient[b00[l]][k];
+                    double const *qxb = _gradient[b10[l]][k];
+                    double a = _lerp(sx[l], rx0[l] * qxa[0] + ry0[l] * qxa[1],
+                                            rx1[l] * qxb[0] + ry0[l] * qxb[1]);
+                    double const *qya = _gradient[b01[l]][k];
+                    double const *qyb = _gradient[b11[l]][k];
+                    double b = _lerp(sx[l], rx0[l] * qya[0] + ry1[l] * qya[1],
+                                            rx1[l] * qyb[0] + ry1[l] * qyb[1]);
+                    result[l] = _lerp(sy[l], a, b);
+                }
+                if (_fractalnoise) {
+                    for (int l = 0; l < Lanes; ++l) {
+                        pixel[k][l] += result[l] * inverse_ratio;
+                    }
+                } else {
+                    for (int l = 0; l < Lanes; ++l) {
+                        pixel[k][l] += std::fabs(result[l]) * inverse_ratio;
+                    }
+                }
+            }
+
+            for (int l = 0; l < Lanes; ++l) {
+                x[l] *= 2;
+                y[l] *= 2;
+            }
+            inverse_ratio /= 2;
+
+            if(_stitchTiles)
+            {
+                // Update stitch values. Subtracting PerlinOffset before the multiplication and
+                // adding it afterward simplifies to subtracting it once.
+                wrapw *= 2;
+                wraph *= 2;
+                wrapx = wrapx*2 - PerlinOffset;
+                wrapy = wrapy*2 - PerlinOffset;
+            }
+        }
+
+        for (int l = 0; l < count; ++l) {
+            guint32 channel[4];
+            for (int k = 0; k < 4; ++k) {
+                channel[k] = _fractalnoise ? CLAMP_D_TO_U8((pixel[k][l]*255.0 + 255.0) / 2)
+                                           : CLAMP_D_TO_U8(pixel[k][l]*255.0);
+            }
+            guint32 a = channel[3];
+            guint32 r = premul_alpha(channel[0], a);
+            guint32 g = premul_alpha(channel[1], a);
+            guint32 b = premul_alpha(channel[2], a);
+            ASSEMBLE_ARGB32(pxout, a,r,g,b);
+            out[l] = pxout;
+        }
+    }
+
     void _setupSeed(long seed)
     {
         _seed = seed;
@@ -271,6 +419,21 @@ private:
         return _seed;
     }
 
+    void _dropCells()
+    {
+        _cells.clear();
+        _cellIndex.clear();
+        ++_generation;
+    }
+
+    // Equal to std::floor() for values that fit in an int, as lattice coordinates must,
+    // but simple enough to be inlined and vectorised.
+    static inline double _floor(double t)
+    {
+        double i = static_cast<int>(t);
+        return i > t ? i - 1.0 : i;
+    }
+
     static inline double _scurve(double t)
     {
         return t * t * (3.0 - 2.0 * t);
@@ -294,6 +457,14 @@ private:
 
     static double constexpr PerlinOffset = 4096.0;
 
+    // The width and height of a cell of cached noise, in pixels.
+    static int constexpr CellSize = 64;
+    // Each generator keeps at most this fraction of the drawing's cache budget in cells: 16 MiB, or
+    // 4 Mpx, of the default 64 MiB. Cells are dropped whenever the transform or the parameters change.
+    static std::size_t constexpr CacheShare = 4;
+    // The most cells kept however large the budget is, unless a single render needs more: 16 MiB.
+    static std::size_t constexpr MaxCells = 1024;
+
     Geom::Rect _tile;
     Geom::Point _baseFreq;
     int _latticeSelector[2 * BSize + 2];
@@ -305,8 +476,16 @@ private:
     int _wrapy;
     int _wrapw;
     int _wraph;
-    bool _inited;
+    std::atomic<bool> _inited;
     bool _fractalnoise;
+
+    using CellKey = std::pair<int, int>;
+    using Cell = std::vector<guint32>;
+    std::mutex _mutex;
+    std::list<std::pair<CellKey, std::shared_ptr<Cell const>>> _cells; ///< Most recently used first.
+    std::map<CellKey, decltype(_cells)::iterator> _cellIndex;
+    Geom::Affine _cellTrans;
+    unsigned _generation = 0;
 };
 
 FilterTurbulence::FilterTurbulence()
@@ -360,26 +539,6 @@ void FilterTurbulence::set_updated(bool /*u*/)
 {
 }
 
-struct Turbulence
-{
-    Turbulence(TurbulenceGenerator const &gen, Geom::Affine const &trans, int x0, int y0)
-        : _gen(gen)
-        , _trans(trans)
-        , _x0(x0), _y0(y0) {}
-
-    guint32 operator()(int x, int y)
-    {
-        Geom::Point point(x + _x0, y + _y0);
-        point *= _trans;
-        return _gen.turbulencePixel(point);
-    }
-
-private:
-    TurbulenceGenerator const &_gen;
-    Geom::Affine _trans;
-    int _x0, _y0;
-};
-
 void FilterTurbulence::render_cairo(FilterSlot &slot) const
 {
     cairo_surface_t *input = slot.getcairo(_input);
@@ -411,9 +570,9 @@ void FilterTurbulence::render_cairo(FilterSlot &slot) const
 
     Geom::Affine unit_trans = slot.get_units().get_matrix_primitiveunits2pb().inverse();
     Geom::Rect slot_area = slot.get_slot_area();
-    double x0 = slot_area.min()[Geom::X];
-    double y0 = slot_area.min()[Geom::Y];
-    ink_cairo_surface_synthesize(temp, Turbulence(*gen, unit_trans, x0, y0));
+    int x0 = slot_area.min()[Geom::X];
+    int y0 = slot_area.min()[Geom::Y];
+    gen->render(temp, unit_trans, x0, y0, slot.get_cache_budget());
 
     // cairo_surface_write_to_png( temp, "turbulence0.png" );
 
@@ -11,8 +11,10 @@
  */
 
 #include <glib.h>
+#include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <map>
 #include <string>
 #include <cairo.h>
 
@@ -149,10 +151,35 @@ int Filter::render(Inkscape::DrawingItem const *item, DrawingContext &graphic, D
         }
     }
 
-    auto slot = FilterSlot(bgdc, graphic, units, rc, blurquality);
+    auto slot = FilterSlot(bgdc, graphic, units, rc, blurquality, item->drawing().cacheBudget());
 
-    for (auto &i : primitives) {
-        i->render_cairo(slot);
+    // Find the last primitive to read each result by name, so that its surface can be freed as
+    // soon as it is no longer needed instead of when the whole filter is done. Results that are
+    // never read are freed right after being rendered.
+    std::map<int, std::size_t> last_read;
+    for (std::size_t i = 0; i < primitives.size(); ++i) {
+        for (int input : primitives[i]->get_inputs()) {
+            last_read[input] = i;
+        }
+        last_read.try_emplace(primitives[i]->get_output(), i);
+    }
+    // SourceAlpha and BackgroundAlpha are extracted from the colour images on first use.
+    for (auto [colour, alpha] : {std::pair{NR_FILTER_SOURCEGRAPHIC, NR_FILTER_SOURCEALPHA},
+                                 std::pair{NR_FILTER_BACKGROUNDIMAGE, NR_FILTER_BACKGROUNDALPHA}}) {
+        if (auto it = last_read.find(alpha); it != last_read.end()) {
+            auto &colour_read = last_read[colour];
+            colour_read = std::max(colour_read, it->second);
+        }
+    }
+    last_read.erase(_output_slot);
+
+    for (std::size_t i = 0; i < primitives.size(); ++i) {
+        primitives[i]->render_cairo(slot);
+        for (auto [slot_nr, read] : last_read) {
+            if (read <= i) {
+                slot.release(slot_nr);
+            }
+        }
     }
 
     Geom::Point origin = graphic.targetLogicalBounds().min();
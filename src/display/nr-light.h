@@ -101,6 +101,11 @@ class PointLight {
          */
         void light_components(NR::Fvector &lc);
 
+        /**
+         * Returns the position of the light in render coordinates
+         */
+        NR::Fvector position() const { return NR::Fvector(l_x, l_y, l_z); }
+
     private:
         guint32 color;
         //light position coordinates in render setting
@@ -145,6 +150,26 @@ class SpotLight {
          */
         void light_components(NR::Fvector &lc, const NR::Fvector &L);
 
+        /**
+         * Returns the position of the light in render coordinates
+         */
+        NR::Fvector position() const { return NR::Fvector(l_x, l_y, l_z); }
+
+        /**
+         * Returns the unit vector in the direction the light points at
+         */
+        NR::Fvector const &direction() const { return S; }
+
+        /**
+         * Returns the cosine of the limiting cone angle
+         */
+        double cos_limiting_cone_angle() const { return cos_lca; }
+
+        /**
+         * Returns the exponent of the falloff away from the direction
+         */
+        double specular_exponent() const { return speExp; }
+
     private:
         guint32 color;
         //light position coordinates in render setting
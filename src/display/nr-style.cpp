@@ -315,8 +315,9 @@ auto NRStyle::preparePaint(Inkscape::DrawingContext &dc, Inkscape::RenderContext
         switch (paint.type) {
             case NRStyleData::PaintType::SERVER:
                 if (paint.server) {
-                    cp.pattern = CairoPatternUniqPtr(paint.server->create_pattern(dc.raw(), paintbox, paint.opacity));
-                    ink_cairo_pattern_set_dither(cp.pattern.get(), rc.dithering && paint.server->ditherable());
+                    auto const dither = rc.dithering && paint.server->ditherable();
+                    cp.pattern = CairoPatternUniqPtr(paint.server->create_pattern(dc.raw(), paintbox, paint.opacity, dither));
+                    ink_cairo_pattern_set_dither(cp.pattern.get(), dither);
                 } else {
                     std::cerr << "Null pattern detected" << std::endl;
                     cp.pattern = CairoPatternUniqPtr(cairo_pattern_create_rgba(0, 0, 0, 0));
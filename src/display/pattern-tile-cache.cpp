@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Cache of rendered pattern tiles, shared by all the patterns in a drawing.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "pattern-tile-cache.h"
+
+#include <iterator>
+#include <cairo.h>
+
+namespace Inkscape {
+
+PatternTileCache::Surface::Surface(Geom::IntRect const &rect, int device_scale)
+    : rect(rect)
+    , surface(Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, rect.width() * device_scale, rect.height() * device_scale))
+{
+    cairo_surface_set_device_scale(surface->cobj(), device_scale, device_scale);
+}
+
+std::size_t PatternTileCache::Tiles::size() const
+{
+    std::size_t result = 0;
+    for (auto const &s : surfaces) {
+        result += static_cast<std::size_t>(s.surface->get_stride()) * s.surface->get_height();
+    }
+    return result;
+}
+
+void PatternTileCache::setBudget(std::size_t bytes)
+{
+    auto lock = std::lock_guard(_mutex);
+    _budget = bytes;
+    _evict();
+}
+
+std::shared_ptr<PatternTileCache::Tiles> PatternTileCache::get(Key const &key)
+{
+    auto lock = std::lock_guard(_mutex);
+
+    if (auto it = _index.find(key); it != _index.end()) {
+        _entries.splice(_entries.begin(), _entries, it->second);
+        return it->second->tiles;
+    }
+
+    _entries.push_front({ key, std::make_shared<Tiles>() });
+    _index.emplace(key, _entries.begin());
+    _counts[key.content]++;
+    return _entries.front().tiles;
+}
+
+void PatternTileCache::resize(Key const &key, std::size_t bytes)
+{
+    auto lock = std::lock_guard(_mutex);
+
+    auto it = _index.find(key);
+    if (it == _index.end()) {
+        // Evicted or dropped while being rendered into.
+        return;
+    }
+
+    _size = _size - it->second->size + bytes;
+    it->second->size = bytes;
+    _evict();
+}
+
+void PatternTileCache::acquire(void const *content)
+{
+    auto lock = std::lock_guard(_mutex);
+    _users[content]++;
+}
+
+void PatternTileCache::release(void const *content)
+{
+    auto lock = std::lock_guard(_mutex);
+    auto it = _users.find(content);
+    if (it == _users.end() || --it->second > 0) {
+        return;
+    }
+    _users.erase(it);
+    // A later pattern may reuse the key, for instance the address of a deleted pattern, so it must not find these tiles.
+    _drop(content);
+}
+
+void PatternTileCache::drop(void const *content)
+{
+    auto lock = std::lock_guard(_mutex);
+    _drop(content);
+}
+
+void PatternTileCache::_drop(void const *content)
+{
+    // Content is dropped for every item that changes inside a pattern, so return quickly if there is nothing to do.
+    if (!_counts.contains(content)) {
+        return;
+    }
+
+    for (auto it = _entries.begin(); it != _entries.end(); ) {
+        auto next = std::next(it);
+        if (it->key.content == content) {
+            _erase(it);
+        }
+        it = next;
+    }
+}
+
+void PatternTileCache::clear()
+{
+    auto lock = std::lock_guard(_mutex);
+    _entries.clear();
+    _index.clear();
+    _counts.clear();
+    _size = 0;
+}
+
+void PatternTileCache::_erase(std::list<Entry>::iterator it)
+{
+    _size -= it->size;
+    _index.erase(it->key);
+    if (auto c = _counts.find(it->key.content); --c->second == 0) {
+        _counts.erase(c);
+    }
+    _entries.erase(it);
+}
+
+void PatternTileCache::_evict()
+{
+    // Always keep the most recently used entry, so that a single tile larger than the budget still gets reused.
+    while (_size > _budget && _entries.size() > 1) {
+        _erase(std::prev(_entries.end()));
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
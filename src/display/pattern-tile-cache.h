@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Cache of rendered pattern tiles, shared by all the patterns in a drawing.
+ *//*
+ * Copyright (C) 2024 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_DISPLAY_PATTERN_TILE_CACHE_H
+#define INKSCAPE_DISPLAY_PATTERN_TILE_CACHE_H
+
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cairomm/surface.h>
+#include <2geom/int-rect.h>
+
+namespace Inkscape {
+
+/**
+ * The pattern tiles rendered for a Drawing.
+ *
+ * Every DrawingPattern that would render the same tile at the same resolution looks up the
+ * same entry, so a pattern used by thousands of shapes is rendered once rather than once per
+ * shape. Entries are kept in least-recently-used order and evicted once their total size
+ * exceeds the budget. Entries for a content key are dropped when its content changes, and when
+ * the last pattern using the key goes away.
+ *
+ * All methods are thread-safe. The surfaces of an entry are protected by its own mutex.
+ */
+class PatternTileCache
+{
+public:
+    /// The parameters that determine the pixels of a pattern tile.
+    struct Key
+    {
+        void const *content;                  ///< Identifies the content rendered into the tile.
+        std::array<double, 4> tile_rect;
+        std::array<double, 6> child_transform;
+        std::array<double, 6> overflow_initial;
+        std::array<double, 6> overflow_step;
+        int overflow_steps;
+        std::array<int, 2> resolution;
+        float opacity;
+        int device_scale;
+        int antialiasing;                     ///< The antialiasing override, or -1 for none.
+        std::uint32_t outline_color;
+        bool dithering;
+
+        auto operator<=>(Key const &) const = default;
+    };
+
+    /// A rendered part of a pattern tile, in tile rasterisation space.
+    struct Surface
+    {
+        Surface(Geom::IntRect const &rect, int device_scale);
+        Geom::IntRect rect;
+        Cairo::RefPtr<Cairo::ImageSurface> surface;
+    };
+
+    /// The parts of a pattern tile that have been rendered so far.
+    struct Tiles
+    {
+        std::mutex mutex;
+        std::vector<Surface> surfaces;
+
+        /// The memory used by the surfaces. Call with the mutex held.
+        std::size_t size() const;
+    };
+
+    /// Set the total size of entries above which the least recently used ones are evicted.
+    void setBudget(std::size_t bytes);
+
+    /// Return the entry for a key, creating it if it does not exist, and mark it as most recently used.
+    std::shared_ptr<Tiles> get(Key const &key);
+
+    /// Record the new size of the entry for a key after rendering into it, and evict entries if over budget.
+    void resize(Key const &key, std::size_t bytes);
+
+    /// Record that a pattern renders the content of a key.
+    void acquire(void const *content);
+
+    /// Record that a pattern no longer renders the content of a key, dropping its entries if it was the last one.
+    void release(void const *content);
+
+    /// Drop all entries for a content key.
+    void drop(void const *content);
+
+    /// Drop all entries.
+    void clear();
+
+private:
+    struct Entry
+    {
+        Key key;
+        std::shared_ptr<Tiles> tiles;
+        std::size_t size = 0;
+    };
+
+    std::mutex _mutex;
+    std::list<Entry> _entries; ///< Most recently used first.
+    std::map<Key, std::list<Entry>::iterator> _index;
+    std::unordered_map<void const *, unsigned> _counts; ///< The number of entries for each content key.
+    std::unordered_map<void const *, unsigned> _users;  ///< The number of patterns using each content key.
+    std::size_t _size = 0;
+    std::size_t _budget = 0;
+
+    void _drop(void const *content);
+    void _erase(std::list<Entry>::iterator it);
+    void _evict();
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_DISPLAY_PATTERN_TILE_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -48,11 +48,13 @@
 #include "document-undo.h"
 
 #include <glibmm/ustring.h>                 // for ustring, operator==
+#include <unordered_set>                    // for unordered_set
 #include <vector>                           // for vector
 
 #include "document.h"                       // for SPDocument
 #include "event.h"                          // for Event
 #include "inkscape.h"                       // for Application, INKSCAPE
+#include "preferences.h"                    // for Preferences
 #include "composite-undo-stack-observer.h"  // for CompositeUndoStackObserver
 
 #include "debug/event-tracker.h"            // for EventTracker
@@ -178,6 +180,7 @@ void Inkscape::DocumentUndo::maybeDone(SPDocument *doc,
 	if (key && !doc->actionkey.empty() && (doc->actionkey == key) && !doc->undo.empty()) {
                 (doc->undo.back())->event =
                     sp_repr_coalesce_log ((doc->undo.back())->event, log);
+                (doc->undo.back())->logChanged();
 	} else {
         Inkscape::Event *event = new Inkscape::Event(log, event_description, icon_name);
         doc->undo.push_back(event);
@@ -185,6 +188,8 @@ void Inkscape::DocumentUndo::maybeDone(SPDocument *doc,
 		doc->undoStackObservers.notifyUndoCommitEvent(event);
 	}
 
+    limit_undo_memory(*doc);
+
     if ( key ) {
         doc->actionkey = key;
     } else {
@@ -220,6 +225,7 @@ void Inkscape::DocumentUndo::finish_incomplete_transaction(SPDocument &doc) {
         if (!doc.undo.empty()) {
             Inkscape::Event* undo_stack_top = doc.undo.back();
             undo_stack_top->event = sp_repr_coalesce_log(undo_stack_top->event, doc.partial);
+            undo_stack_top->logChanged();
         } else {
             sp_repr_free_log(doc.partial);
         }
@@ -243,12 +249,85 @@ void Inkscape::DocumentUndo::perform_document_update(SPDocument &doc) {
         if (!doc.undo.empty()) {
             Inkscape::Event* undo_stack_top = doc.undo.back();
             undo_stack_top->event = sp_repr_coalesce_log(undo_stack_top->event, update_log);
+            undo_stack_top->logChanged();
         } else {
             sp_repr_free_log(update_log);
         }
     }
 }
 
+namespace {
+
+/// Sums the memory of undo events, counting each value kept by several of them once.
+class UndoMemoryCounter
+{
+public:
+    void add(Inkscape::Event const *e)
+    {
+        auto const &memory = e->memory();
+        bytes += memory.events;
+        for (auto const &[value, size] : memory.values) {
+            if (_values.insert(value).second) {
+                bytes += size;
+            }
+        }
+    }
+
+    std::size_t bytes = 0;
+
+private:
+    std::unordered_set<char const *> _values;
+};
+
+} // namespace
+
+// Member function for friend access to SPDocument privates.
+void Inkscape::DocumentUndo::limit_undo_memory(SPDocument &doc)
+{
+    // Limit in MiB, zero for none.
+    auto const limit = Inkscape::Preferences::get()->getIntLimited("/options/undo/memorylimit", 0, 0, 1 << 20);
+    if (!limit) {
+        return;
+    }
+
+    // Keep the newest events that fit, but always the latest one so it can still be undone. Values
+    // shared with an older event are counted with the newer one, as they stay in memory with it.
+    auto const budget = static_cast<std::size_t>(limit) << 20;
+    UndoMemoryCounter counter;
+    for (auto e : doc.redo) {
+        counter.add(e);
+    }
+    std::size_t kept = 0;
+    for (auto it = doc.undo.rbegin(); it != doc.undo.rend(); ++it) {
+        counter.add(*it);
+        if (counter.bytes > budget && kept > 0) {
+            break;
+        }
+        kept++;
+    }
+
+    auto const expired = doc.undo.size() - kept;
+    for (std::size_t i = 0; i < expired; i++) {
+        Inkscape::Event *e = doc.undo[i];
+        doc.undoStackObservers.notifyUndoExpiredEvent(e);
+        delete e;
+        doc.history_size--;
+    }
+    doc.undo.erase(doc.undo.begin(), doc.undo.begin() + expired);
+}
+
+std::size_t Inkscape::DocumentUndo::getUndoMemory(SPDocument const *doc)
+{
+    UndoMemoryCounter counter;
+    for (auto e : doc->redo) {
+        counter.add(e);
+    }
+    for (auto e : doc->undo) {
+        counter.add(e);
+    }
+    return counter.bytes;
+}
+
 gboolean Inkscape::DocumentUndo::undo(SPDocument *doc)
 {
     using Inkscape::Debug::EventTracker;
@@ -10,6 +10,7 @@
 #ifndef SEEN_SP_DOCUMENT_UNDO_H
 #define SEEN_SP_DOCUMENT_UNDO_H
 
+#include <cstddef>  // size_t
 #include <glib.h>   // gboolean, gchar
 
 namespace Glib {
@@ -47,6 +48,8 @@ private:
 
     static void perform_document_update(SPDocument &document);
 
+    static void limit_undo_memory(SPDocument &document);
+
 public:
     static void resetKey(SPDocument *document);
 
@@ -56,6 +59,11 @@ public:
 
     static gboolean redo(SPDocument *document);
 
+    /**
+     * Approximate memory held by the undo and redo logs of a document, in bytes.
+     */
+    static std::size_t getUndoMemory(SPDocument const *document);
+
     /**
      * RAII-style mechanism for creating a temporary undo-insensitive context.
      *
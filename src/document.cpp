@@ -38,9 +38,13 @@
 
 #include "document.h"
 
+#include <algorithm>
+#include <cassert>
+#include <optional>
 #include <vector>
 #include <string>
 #include <cstring>
+#include <thread>
 
 #include <boost/range/adaptor/reversed.hpp>
 #include <glibmm/main.h>
@@ -55,11 +59,13 @@
 #include "id-clash.h"
 #include "inkscape-window.h"
 #include "inkscape.h"
+#include "item-index.h"
 #include "layer-manager.h"
 #include "page-manager.h"
 #include "profile-manager.h"
 #include "rdf.h"
 #include "selection.h"
+#include "style-sheet-index.h"
 
 #include "3rdparty/adaptagrams/libavoid/router.h"
 #include "3rdparty/libcroco/src/cr-sel-eng.h"
@@ -68,6 +74,9 @@
 #include "actions/actions-pages.h"
 #include "actions/actions-svg-processing.h"
 #include "actions/actions-undo-document.h"
+#include "debug/event-tracker.h"
+#include "debug/logger.h"
+#include "debug/simple-event.h"
 #include "display/control/canvas-item-drawing.h"
 #include "display/drawing.h"
 #include "io/dir-util.h"
@@ -83,6 +92,7 @@
 #include "object/sp-symbol.h"
 #include "ui/widget/canvas.h"
 #include "ui/widget/desktop-widget.h"
+#include "util/spatial-index.h"
 #include "util/units.h"
 #include "xml/croco-node-iface.h"
 #include "xml/rebase-hrefs.h"
@@ -198,6 +208,7 @@ SPDocument::~SPDocument() {
     resources.clear();
 
     // This also destroys all attached stylesheets
+    _style_sheet_index.reset();
     cr_cascade_unref(style_cascade);
     style_cascade = nullptr;
 
@@ -1203,9 +1214,8 @@ SPObject *SPDocument::getObjectById(char const *id) const
 
 SPObject *SPDocument::getObjectByHref(std::string const &href) const
 {
-    if (iddef.empty()) return nullptr;
-    auto id = href.substr(1);
-    return getObjectById(id);
+    if (href.empty() || iddef.empty()) return nullptr;
+    return getObjectById(href.c_str() + 1);
 }
 
 SPObject *SPDocument::getObjectByHref(char const *href) const
@@ -1282,7 +1292,9 @@ static void _getObjectsBySelectorRecursive(SPObject *parent,
 {
     if (parent) {
         gboolean result = false;
-        cr_sel_eng_matches_node(sel_eng, simple_sel, parent->getRepr(), &result);
+        if (Inkscape::StyleSheetIndex::mayMatch(simple_sel, parent->getRepr())) {
+            cr_sel_eng_matches_node(sel_eng, simple_sel, parent->getRepr(), &result);
+        }
         if (result) {
             objects.push_back(parent);
         }
@@ -1346,6 +1358,9 @@ void SPDocument::bindObjectToRepr(Inkscape::XML::Node *repr, SPObject *object)
     }
 
     _node_cache_valid = false;
+    if (_item_index) {
+        _item_index->invalidate();
+    }
 }
 
 SPObject *SPDocument::getObjectByRepr(Inkscape::XML::Node *repr) const
@@ -1433,6 +1448,23 @@ void SPDocument::setupViewport(SPItemCtx *ctx)
     ctx->i2vp = Geom::identity();
 }
 
+namespace {
+
+class UpdateEvent : public Inkscape::Debug::SimpleEvent<Inkscape::Debug::Event::DOCUMENT>
+{
+public:
+    UpdateEvent(SPDocument const *doc, gint64 duration, int threads, unsigned concurrent_subtrees)
+        : SimpleEvent("update")
+    {
+        _addProperty("document", doc->serial());
+        _addProperty("duration-us", duration);
+        _addProperty("threads", threads);
+        _addProperty("concurrent-subtrees", (long)concurrent_subtrees);
+    }
+};
+
+} // namespace
+
 /**
  * Tries to update the document state based on the modified and
  * "update required" flags, and return true if the document has
@@ -1449,7 +1481,17 @@ SPDocument::_updateDocument(int update_flags)
 
             DocumentUndo::ScopedInsensitive _no_undo(this);
 
+            // Independent subtrees may be updated on several threads; see SPGroup::update.
+            auto const prefs = Inkscape::Preferences::get();
+            int const default_threads = std::max(std::thread::hardware_concurrency(), 1u);
+            update_threads = prefs->getIntLimited("/options/threading/numthreads", default_threads, 1, 256);
+            update_concurrent_subtrees = 0;
+            auto const start = g_get_monotonic_time();
+
             this->root->updateDisplay((SPCtx *)&ctx, update_flags);
+
+            Inkscape::Debug::Logger::write<UpdateEvent>(this, g_get_monotonic_time() - start, update_threads,
+                                                        update_concurrent_subtrees);
         }
         this->_emitModified();
     }
@@ -1541,57 +1583,46 @@ static bool overlaps(Geom::Rect const &area, Geom::Rect const &box)
 }
 
 /**
- * Return a vector list of items in a given area.
+ * Whether an item is to be found by an area search, apart from its bounding box. This holds if
+ * the item passes the filters, and every group above it is entered.
  *
- * @param s The returned list
- * @param group The starting group
+ * @param item The item, which the index found from the root through groups
+ * @param root The root of the search
  * @param dkey The display control group to traverse
- * @param area Area in document coordinates
- * @param test A function called for each item's bbox
  * @param take_hidden (false) picks hidden items
  * @param take_insensitive (false) picks insensitive items
  * @param take_groups (true) doesn't tranverse into groups
  * @param enter_groups (false) traverse into regular groups
  * @param enter_layers (true) traverse into layer groups
  */
-static std::vector<SPItem*> &find_items_in_area(std::vector<SPItem*> &s,
-                                                SPGroup *group, unsigned int dkey,
-                                                Geom::Rect const &area,
-                                                bool (*test)(Geom::Rect const &, Geom::Rect const &),
-                                                bool take_hidden = false,
-                                                bool take_insensitive = false,
-                                                bool take_groups = true,
-                                                bool enter_groups = false,
-                                                bool enter_layers = true)
-{
-    g_return_val_if_fail(group, s);
-
-    for (auto& o: group->children) {
-        if (auto item = cast<SPItem>(&o)) {
-            if (!take_insensitive && item->isLocked()) {
-                continue;
-            }
+static bool is_found_in_area(SPItem *item, SPGroup *root, unsigned dkey,
+                             bool take_hidden, bool take_insensitive, bool take_groups, bool enter_groups, bool enter_layers)
+{
+    auto passes = [&] (SPItem *i) {
+        return (take_insensitive || !i->isLocked()) && (take_hidden || !i->isHidden());
+    };
 
-            if (!take_hidden && item->isHidden()) {
-                continue;
-            }
+    if (!passes(item)) {
+        return false;
+    }
+    if (auto group = cast<SPGroup>(item)) {
+        bool is_layer = group->effectiveLayerMode(dkey) == SPGroup::LAYER;
+        if (!take_groups || (enter_layers && is_layer)) {
+            return false;
+        }
+    }
 
-            if (auto childgroup = cast<SPGroup>(item)) {
-                bool is_layer = childgroup->effectiveLayerMode(dkey) == SPGroup::LAYER;
-                if ((enter_layers && is_layer) || (enter_groups)) {
-                    s = find_items_in_area(s, childgroup, dkey, area, test, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers);
-                }
-                if (!take_groups || (enter_layers && is_layer)) {
-                    continue;
-                }
-            }
-            Geom::OptRect box = item->documentVisualBounds();
-            if (box && test(area, *box)) {
-                s.push_back(item);
-            }
+    for (auto parent = item->parent; parent != root; parent = parent->parent) {
+        auto group = parent ? cast<SPGroup>(parent) : nullptr;
+        if (!group || !passes(group)) {
+            return false;
+        }
+        bool is_layer = group->effectiveLayerMode(dkey) == SPGroup::LAYER;
+        if (!((enter_layers && is_layer) || enter_groups)) {
+            return false;
         }
     }
-    return s;
+    return true;
 }
 
 SPItem *SPDocument::getItemFromListAtPointBottom(unsigned dkey, SPGroup *group, std::vector<SPItem*> const &list, Geom::Point const &p, bool take_insensitive)
@@ -1661,23 +1692,17 @@ If upto != NULL, then if item upto is encountered (at any level), stops searchin
 upwards in z-order and returns what it has found so far (i.e. the found items are
 guaranteed to be lower than upto). Requires a list of nodes built by build_flat_item_list.
 If items_count > 0, it'll return the topmost (in z-order) items_count items.
+If index != NULL, it is used to only look at the nodes near p; see index_items_at_point.
+It cannot be combined with upto.
  */
 static std::vector<SPItem*> find_items_at_point(std::deque<SPItem*> const &nodes, unsigned dkey,
-                                                Geom::Point const &p, int items_count = 0, SPItem *upto = nullptr)
+                                                Geom::Point const &p, int items_count = 0, SPItem *upto = nullptr,
+                                                Inkscape::Util::SpatialIndex<double> const *index = nullptr)
 {
     double const delta = Inkscape::Preferences::get()->getDouble("/options/cursortolerance/value", 1.0);
     std::optional<bool> outline;
 
-    std::vector<SPItem*> result;
-
-    bool seen_upto = !upto;
-    for (auto node : nodes) {
-        if (!seen_upto) {
-            if (node == upto) {
-                seen_upto = true;
-            }
-            continue;
-        }
+    auto pick = [&] (SPItem *node) {
         if (auto di = node->get_arenaitem(dkey)) {
             if (!outline) {
                 if (auto cid = di->drawing().getCanvasItemDrawing()) {
@@ -1685,18 +1710,70 @@ static std::vector<SPItem*> find_items_at_point(std::deque<SPItem*> const &nodes
                     outline = canvas->canvas_point_in_outline_zone(p - canvas->get_pos());
                 }
             }
-            if (di->pick(p, delta, Inkscape::DrawingItem::PICK_STICKY | outline.value_or(false) * Inkscape::DrawingItem::PICK_OUTLINE)) {
-                result.emplace_back(node);
+            return di->pick(p, delta, Inkscape::DrawingItem::PICK_STICKY | outline.value_or(false) * Inkscape::DrawingItem::PICK_OUTLINE) != nullptr;
+        }
+        return false;
+    };
+
+    std::vector<SPItem*> result;
+
+    if (index) {
+        assert(!upto);
+        auto area = Geom::Rect(p, p);
+        area.expandBy(delta);
+        for (auto i : index->query(area)) {
+            if (pick(nodes[i])) {
+                result.emplace_back(nodes[i]);
                 if (--items_count == 0) {
                     break;
                 }
             }
         }
+        return result;
+    }
+
+    bool seen_upto = !upto;
+    for (auto node : nodes) {
+        if (!seen_upto) {
+            if (node == upto) {
+                seen_upto = true;
+            }
+            continue;
+        }
+        if (pick(node)) {
+            result.emplace_back(node);
+            if (--items_count == 0) {
+                break;
+            }
+        }
     }
 
     return result;
 }
 
+/**
+ * Index the drawing bounds of a list of nodes built by build_flat_item_list, for picking at
+ * many points. A node's drawing item can only be picked within its bounds, enlarged by the
+ * cursor tolerance.
+ */
+static Inkscape::Util::SpatialIndex<double> index_items_at_point(std::deque<SPItem*> const &nodes, unsigned dkey)
+{
+    std::vector<Geom::OptRect> boxes;
+    boxes.reserve(nodes.size());
+    for (auto node : nodes) {
+        Geom::OptRect box;
+        if (auto di = node->get_arenaitem(dkey)) {
+            box.unionWith(di->bbox());
+            box.unionWith(di->drawbox());
+        }
+        boxes.emplace_back(box);
+    }
+
+    Inkscape::Util::SpatialIndex<double> index;
+    index.build(std::move(boxes));
+    return index;
+}
+
 static SPItem *find_item_at_point(std::deque<SPItem*> const &nodes, unsigned dkey, Geom::Point const &p, SPItem *upto = nullptr)
 {
     auto items = find_items_at_point(nodes, dkey, p, 1, upto);
@@ -1746,8 +1823,14 @@ static SPItem *find_group_at_point(unsigned dkey, SPGroup *group, Geom::Point co
 
 std::vector<SPItem*> SPDocument::getItemsInBox(unsigned int dkey, Geom::Rect const &box, bool take_hidden, bool take_insensitive, bool take_groups, bool enter_groups, bool enter_layers) const
 {
+    // Only the items near the box are looked at, in the order of the document.
     std::vector<SPItem*> x;
-    return find_items_in_area(x, this->root, dkey, box, is_within, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers);
+    _itemIndex().query(box, [&] (SPItem *item, Geom::Rect const &bounds) {
+        if (is_within(box, bounds) && is_found_in_area(item, root, dkey, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers)) {
+            x.push_back(item);
+        }
+    });
+    return x;
 }
 
 /**
@@ -1763,8 +1846,50 @@ std::vector<SPItem*> SPDocument::getItemsInBox(unsigned int dkey, Geom::Rect con
 
 std::vector<SPItem*> SPDocument::getItemsPartiallyInBox(unsigned int dkey, Geom::Rect const &box, bool take_hidden, bool take_insensitive, bool take_groups, bool enter_groups, bool enter_layers) const
 {
+    // Only the items near the box are looked at, in the order of the document.
     std::vector<SPItem*> x;
-    return find_items_in_area(x, this->root, dkey, box, overlaps, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers);
+    _itemIndex().query(box, [&] (SPItem *item, Geom::Rect const &bounds) {
+        if (overlaps(box, bounds) && is_found_in_area(item, root, dkey, take_hidden, take_insensitive, take_groups, enter_groups, enter_layers)) {
+            x.push_back(item);
+        }
+    });
+    return x;
+}
+
+Inkscape::StyleSheetIndex &SPDocument::getStyleSheetIndex()
+{
+    if (!_style_sheet_index) {
+        _style_sheet_index = std::make_unique<Inkscape::StyleSheetIndex>(style_cascade);
+    }
+    return *_style_sheet_index;
+}
+
+void SPDocument::styleSheetsChanged()
+{
+    _style_sheet_index.reset();
+}
+
+Inkscape::ItemIndex &SPDocument::_itemIndex() const
+{
+    if (!_item_index) {
+        _item_index = std::make_unique<Inkscape::ItemIndex>(root);
+    }
+    return *_item_index;
+}
+
+void SPDocument::_itemChanged(SPItem const *item)
+{
+    if (_item_index) {
+        _item_index->itemChanged(item);
+    }
+}
+
+void SPDocument::_itemsReordered()
+{
+    _node_cache_valid = false;
+    if (_item_index) {
+        _item_index->invalidate();
+    }
 }
 
 std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vector<Geom::Point> points, bool all_layers, bool topmost_only, size_t limit) const
@@ -1789,9 +1914,14 @@ std::vector<SPItem*> SPDocument::getItemsAtPoints(unsigned const key, std::vecto
     if(desktop){
         current_layer = desktop->layerManager().currentLayer();
     }
+    // Searching many points is quicker with an index of where each item can be picked.
+    std::optional<Inkscape::Util::SpatialIndex<double>> index;
+    if (points.size() > 1) {
+        index = index_items_at_point(_node_cache, key);
+    }
     size_t item_counter = 0;
     for(auto point : points) {
-        std::vector<SPItem*> items = find_items_at_point(_node_cache, key, point, topmost_only);
+        std::vector<SPItem*> items = find_items_at_point(_node_cache, key, point, topmost_only, nullptr, index ? &*index : nullptr);
         for (SPItem *item : items) {
             if (item && result.end()==find(result.begin(), result.end(), item))
                 if(all_layers || (desktop && desktop->layerManager().layerForObject(item) == current_layer)){
@@ -1850,9 +1980,9 @@ bool SPDocument::addResource(gchar const *key, SPObject *object)
     bool result = false;
 
     if ( !object->cloned ) {
-        std::vector<SPObject *> rlist = resources[key];
+        auto &rlist = resources[key];
         g_return_val_if_fail(std::find(rlist.begin(),rlist.end(),object) == rlist.end(), false);
-        resources[key].insert(resources[key].begin(),object);
+        rlist.insert(rlist.begin(),object);
 
         GQuark q = g_quark_from_string(key);
 
@@ -1883,11 +2013,12 @@ bool SPDocument::removeResource(gchar const *key, SPObject *object)
     bool result = false;
 
     if ( !object->cloned ) {
-        std::vector<SPObject *> rlist = resources[key];
-        g_return_val_if_fail(!rlist.empty(), false);
-        std::vector<SPObject*>::iterator it = std::find(resources[key].begin(),resources[key].end(),object);
+        auto found = resources.find(key);
+        g_return_val_if_fail(found != resources.end(), false);
+        auto &rlist = found->second;
+        auto it = std::find(rlist.begin(),rlist.end(),object);
         g_return_val_if_fail(it != rlist.end(), false);
-        resources[key].erase(it);
+        rlist.erase(it);
 
         GQuark q = g_quark_from_string(key);
         resources_changed_signals[q].emit();
@@ -1904,7 +2035,8 @@ std::vector<SPObject *> const SPDocument::getResourceList(gchar const *key)
     g_return_val_if_fail(key != nullptr, emptyset);
     g_return_val_if_fail(*key != '\0', emptyset);
 
-    return resources[key];
+    auto found = resources.find(key);
+    return found != resources.end() ? found->second : emptyset;
 }
 
 void SPDocument::process_pending_resource_changes()
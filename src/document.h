@@ -18,12 +18,14 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <atomic>                              // for atomic
 #include <cstddef>                             // for size_t
 #include <deque>                               // for deque
 #include <map>                                 // for map
 #include <memory>                              // for unique_ptr, default_de...
 #include <queue>                               // for queue
 #include <string>                              // for string
+#include <unordered_map>                       // for unordered_map
 #include <vector>                              // for vector
 
 #include <boost/ptr_container/ptr_list.hpp>    // for ptr_list
@@ -45,6 +47,7 @@
 #include "gc-finalized.h"
 
 #include "inkgc/gc-managed.h"
+#include "util/string-hash.h"
 
 #include "composite-undo-stack-observer.h"
 // XXX only for testing!
@@ -84,9 +87,11 @@ namespace Inkscape {
     class DocumentUndo;
     class Event;
     class EventLog;
+    class ItemIndex;
     class PageManager;
     class ProfileManager;
     class Selection;
+    class StyleSheetIndex;
     class UndoStackObserver;
     namespace XML {
         struct Document;
@@ -107,7 +112,11 @@ class SPDocument : public Inkscape::GC::Managed<>,
 
 public:
     /// For sanity check in SPObject::requestDisplayUpdate
-    unsigned update_in_progress = 0;
+    std::atomic<unsigned> update_in_progress = 0;
+    /// The number of threads SPGroup::update may spread independent children over; set per update.
+    int update_threads = 1;
+    /// The number of children updated concurrently in the current update, for the debug log.
+    unsigned update_concurrent_subtrees = 0;
 
     /************ Functions *****************/
 
@@ -222,6 +231,8 @@ public:
 
     // Styling
     CRCascade    *getStyleCascade() { return style_cascade; }
+    Inkscape::StyleSheetIndex &getStyleSheetIndex();
+    void styleSheetsChanged(); // Call before and after changing the style cascade.
 
     // File information --------------------
 
@@ -402,6 +413,7 @@ private:
 
     // Styling
     CRCascade *style_cascade;
+    std::unique_ptr<Inkscape::StyleSheetIndex> _style_sheet_index; // Used to speed up style matching.
 
     // Desktop geometry
     mutable Geom::Affine _doc2dt;
@@ -412,12 +424,14 @@ private:
     char *document_name;  ///< basename or other human-readable label for the document.
 
     // Find items ----------------------------
-    std::map<std::string, SPObject *> iddef;
-    std::map<Inkscape::XML::Node *, SPObject *> reprdef;
+    Inkscape::Util::StringMap<SPObject *> iddef;
+    std::unordered_map<Inkscape::XML::Node *, SPObject *> reprdef;
 
     // Find items by geometry --------------------
     mutable std::deque<SPItem*> _node_cache; // Used to speed up search.
     mutable bool _node_cache_valid;
+    mutable std::unique_ptr<Inkscape::ItemIndex> _item_index; // Used to speed up search by area.
+    Inkscape::ItemIndex &_itemIndex() const;
 
     // Box tool ----------------------------
     Persp3D *current_persp3d; /**< Currently 'active' perspective (to which, e.g., newly created boxes are attached) */
@@ -463,8 +477,8 @@ private:
     typedef sigc::signal<void ()> CommitSignal;
     typedef sigc::signal<void ()> BeforeCommitSignal; // allow to add actions berfore commit to include in undo
 
-    typedef std::map<GQuark, SPDocument::IDChangedSignal> IDChangedSignalMap;
-    typedef std::map<GQuark, SPDocument::ResourcesChangedSignal> ResourcesChangedSignalMap;
+    typedef std::unordered_map<GQuark, SPDocument::IDChangedSignal> IDChangedSignalMap;
+    typedef std::unordered_map<GQuark, SPDocument::ResourcesChangedSignal> ResourcesChangedSignalMap;
 
     /** Dictionary of signals for id changes */
     IDChangedSignalMap id_changed_signals;
@@ -500,10 +514,12 @@ public:
     sigc::connection connectReconstructionFinish(ReconstructionFinish::slot_type slot);
 
     /* Resources */
-    std::map<std::string, std::vector<SPObject *> > resources;
+    Inkscape::Util::StringMap<std::vector<SPObject *>> resources;
     ResourcesChangedSignalMap resources_changed_signals; // Used by Extension::Internal::Filter
 
     void _emitModified();  // Used by SPItem
+    void _itemChanged(SPItem const *item); // Used by SPObject
+    void _itemsReordered();                // Used by SPObject
     void emitReconstructionStart();
     void emitReconstructionFinish();
 };
@@ -161,6 +161,18 @@ public:
         }
     }
 
+    Gtk::TreeModel::iterator eraseRow(Glib::RefPtr<Gtk::TreeStore> eventListStore, Gtk::TreeModel::iterator row)
+    {
+        std::vector<std::unique_ptr<SignalBlocker> > blockers;
+        for (auto & _connection : _connections)
+        {
+            addBlocker(blockers, &(*_connection._callback_connections)[Inkscape::EventLog::CALLB_SELECTION_CHANGE]);
+            addBlocker(blockers, &(*_connection._callback_connections)[Inkscape::EventLog::CALLB_EXPAND]);
+        }
+
+        return eventListStore->erase(row);
+    }
+
     std::vector<DialogConnection> _connections;
 };
 
@@ -353,6 +365,24 @@ EventLog::notifyClearRedoEvent()
     updateUndoVerbs();
 }
 
+void
+EventLog::notifyUndoExpiredEvent(Event* log)
+{
+    auto &_columns = getColumns();
+    auto oldest = _event_list_store->children().begin();
+    ++oldest;
+    g_return_if_fail(oldest != _event_list_store->children().end());
+    g_return_if_fail((Event *)(*oldest)[_columns.event] == log);
+
+    _expireOldest();
+
+    // update the view
+    if (_priv->isConnected()) {
+        Gtk::TreePath curr_path = _event_list_store->get_path(_curr_event);
+        _priv->selectRow(curr_path);
+    }
+}
+
 void  EventLog::addDialogConnection(Gtk::TreeView *event_list_view, CallbackMap *callback_connections)
 {
     _priv->addDialogConnection(event_list_view, callback_connections, _event_list_store, _curr_event);
@@ -449,6 +479,50 @@ EventLog::_clearRedo()
     }
 }
 
+void
+EventLog::_expireOldest()
+{
+    auto &_columns = getColumns();
+
+    // Undoing now stops at the root row, which takes the place of the state after the oldest event.
+    // If the document was saved before that event, the saved state can no longer be reached.
+    auto const root = _event_list_store->children().begin();
+    auto oldest = root;
+    ++oldest;
+    if (_last_saved == root) {
+        _last_saved = _event_list_store->children().end();
+    } else if (_last_saved == oldest) {
+        _last_saved = root;
+    }
+
+    if (oldest->children().empty()) {
+        _priv->eraseRow(_event_list_store, oldest);
+        return;
+    }
+
+    // The oldest event heads a branch: its first child takes its place.
+    auto first_child = oldest->children().begin();
+    (*oldest)[_columns.event] = (Event *)(*first_child)[_columns.event];
+    (*oldest)[_columns.description] = (Glib::ustring)(*first_child)[_columns.description];
+
+    if (_curr_event == first_child) {
+        _curr_event = oldest;
+    }
+    if (_last_event == first_child) {
+        _last_event = oldest;
+    }
+    if (_last_saved == first_child) {
+        _last_saved = oldest;
+    }
+
+    _priv->eraseRow(_event_list_store, first_child);
+    (*oldest)[_columns.child_count] = oldest->children().size() + 1;
+
+    if (_curr_event_parent == oldest && oldest->children().empty()) {
+        _curr_event_parent = (iterator)(nullptr);
+    }
+}
+
 /* mark document as untouched if we reach a state where the document was previously saved */
 void
 EventLog::checkForVirginity() {
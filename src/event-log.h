@@ -76,6 +76,7 @@ public:
     void notifyUndoCommitEvent(Event *log) override;
     void notifyClearUndoEvent() override;
     void notifyClearRedoEvent() override;
+    void notifyUndoExpiredEvent(Event *log) override;
 
     // Accessor functions
 
@@ -137,6 +138,7 @@ private:
 
     void _clearUndo();  //< erase all previously committed events
     void _clearRedo();  //< erase all previously undone events
+    void _expireOldest(); //< erase the oldest committed event
 
     void checkForVirginity(); //< marks the document as untouched if undo/redo reaches a previously saved state
 
@@ -17,6 +17,8 @@
 
 #include <glibmm/ustring.h>
 
+#include <cstddef>
+#include <optional>
 #include <utility>
 
 #include "xml/event-fns.h"
@@ -38,10 +40,25 @@ public:
 
     virtual ~Event() { sp_repr_free_log (event); }
 
+    /// Approximate memory held by the event log. Only computed when asked for.
+    XML::LogMemory const &memory() const
+    {
+        if (!_memory) {
+            _memory = sp_repr_log_memory(event);
+        }
+        return *_memory;
+    }
+
+    /// Forget the computed memory, after the event log was replaced.
+    void logChanged() { _memory.reset(); }
+
     XML::Event *event;
     unsigned int type = 0;
     Glib::ustring description; // The description to use in the Undo dialog.
     Glib::ustring icon_name;   // The icon to use in the Undo dialog.
+
+private:
+    mutable std::optional<XML::LogMemory> _memory;
 };
 
 } // namespace Inkscape
@@ -1378,7 +1378,7 @@ CairoRenderContext::_createPatternForPaintServer(SPPaintServer const *const pain
             cairo_pattern_add_color_stop_rgba(pattern, rg->vector.stops[i].offset, rgb[0], rgb[1], rgb[2], rg->vector.stops[i].opacity * alpha);
         }
     } else if (auto mg = cast<SPMeshGradient>(paintserver_mutable)) {
-        pattern = mg->create_drawing_paintserver()->create_pattern(_cr, pbox, 1.0);
+        pattern = mg->create_drawing_paintserver()->create_pattern(_cr, pbox, 1.0, false);
     } else if (is<SPPattern>(paintserver)) {
         pattern = _createPatternPainter(paintserver, pbox);
     } else if (is<SPHatch>(paintserver) ) {
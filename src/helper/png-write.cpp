@@ -15,6 +15,15 @@
  */
 
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <2geom/rect.h>
 #include <2geom/transforms.h>
 
@@ -22,6 +31,7 @@
 
 #include "document.h"
 #include "png-write.h"
+#include "preferences.h"
 #include "rdf.h"
 
 #include "display/cairo-utils.h"
@@ -48,11 +58,159 @@
  * working PNG reader/writer, see pngtest.c, included in this distribution.
  */
 
+namespace {
+
+/**
+ * Renders an export in horizontal strips on a pool of worker threads, and hands the finished
+ * strips out in order to the thread writing the PNG file.
+ *
+ * Each strip is rendered and converted to the PNG pixel format independently, so the output is
+ * identical to rendering the strips one after another. Compression stays on the writing thread,
+ * where it overlaps with the rendering of the following strips. At most max_in_flight strips are
+ * held in memory at once.
+ *
+ * The drawing must be fully updated and snapshotted for the lifetime of the renderer.
+ */
+class StripRenderer
+{
+public:
+    struct Strip
+    {
+        int row;
+        int num_rows;
+        guchar const *data = nullptr; ///< Converted pixels, allocated with malloc().
+        std::vector<guchar const *> rows; ///< Pointers to the start of each row in data.
+        bool ready = false;
+    };
+
+    StripRenderer(Inkscape::Drawing const &drawing, unsigned long width, unsigned long height, int strip_height,
+                  guint32 background, int color_type, int bit_depth, int numthreads)
+        : _drawing(drawing)
+        , _width(width)
+        , _height(height)
+        , _strip_height(strip_height)
+        , _background(background)
+        , _color_type(color_type)
+        , _bit_depth(bit_depth)
+        , _max_in_flight(2 * numthreads)
+        , _pool(numthreads)
+    {}
+
+    ~StripRenderer()
+    {
+        _reset();
+        _pool.join();
+    }
+
+    /**
+     * Return the strip starting at the given row, waiting for it to be rendered if necessary.
+     * Rows are normally requested in increasing order; requesting any other row restarts the
+     * pipeline from there, which happens at the start of each interlacing pass.
+     */
+    std::unique_ptr<Strip> take(int row)
+    {
+        if (_queue.empty() || _queue.front()->row != row) {
+            _reset();
+            _next_row = row;
+        }
+        _fill();
+
+        auto strip = std::move(_queue.front());
+        _queue.pop_front();
+        {
+            auto lock = std::unique_lock(_mutex);
+            _cond.wait(lock, [&] { return strip->ready; });
+        }
+        _fill();
+
+        return strip;
+    }
+
+private:
+    Inkscape::Drawing const &_drawing;
+    unsigned long const _width;
+    unsigned long const _height;
+    int const _strip_height;
+    guint32 const _background;
+    int const _color_type;
+    int const _bit_depth;
+    std::size_t const _max_in_flight;
+
+    boost::asio::thread_pool _pool;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<std::unique_ptr<Strip>> _queue; ///< Strips in flight, in row order.
+    int _next_row = 0; ///< First row not yet in the queue.
+
+    /// Start rendering strips until the queue is full or the image is exhausted.
+    void _fill()
+    {
+        while (_queue.size() < _max_in_flight && _next_row < static_cast<int>(_height)) {
+            auto strip = std::make_unique<Strip>();
+            strip->row = _next_row;
+            strip->num_rows = std::min<int>(_strip_height, _height - _next_row);
+            _next_row += strip->num_rows;
+            boost::asio::post(_pool, [this, strip = strip.get()] {
+                _render(*strip);
+                auto lock = std::unique_lock(_mutex);
+                strip->ready = true;
+                _cond.notify_all();
+            });
+            _queue.emplace_back(std::move(strip));
+        }
+    }
+
+    /// Wait for all strips in flight and discard them.
+    void _reset()
+    {
+        auto lock = std::unique_lock(_mutex);
+        for (auto &strip : _queue) {
+            _cond.wait(lock, [&] { return strip->ready; });
+            free(const_cast<guchar *>(strip->data));
+        }
+        _queue.clear();
+    }
+
+    /// Render a strip and convert it to the PNG pixel format. Runs on a worker thread.
+    void _render(Strip &strip) const
+    {
+        // bbox is now set to the entire image to prevent discontinuities
+        // in the image when blur is used (the borders may still be a bit
+        // off, but that's less noticeable).
+        Geom::IntRect bbox = Geom::IntRect::from_xywh(0, strip.row, _width, strip.num_rows);
+
+        int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, _width);
+        unsigned char *px = g_new(guchar, strip.num_rows * stride);
+
+        cairo_surface_t *s = cairo_image_surface_create_for_data(
+            px, CAIRO_FORMAT_ARGB32, _width, strip.num_rows, stride);
+        Inkscape::DrawingContext dc(s, bbox.min());
+        dc.setSource(_background);
+        dc.setOperator(CAIRO_OPERATOR_SOURCE);
+        dc.paint();
+        dc.setOperator(CAIRO_OPERATOR_OVER);
+
+        /* Render */
+        _drawing.render(dc, bbox, 0);
+        cairo_surface_destroy(s);
+
+        // PNG stores data as unpremultiplied big-endian RGBA, which means
+        // it's identical to the GdkPixbuf format.
+        convert_pixels_argb32_to_pixbuf(px, _width, strip.num_rows, stride,
+                                        /* RGBA to ARGB with A=0 */ _background >> 8);
+
+        // If a custom bit depth or color type is asked, then convert rgb to grayscale, etc.
+        strip.rows.resize(strip.num_rows);
+        strip.data = pixbuf_to_png(strip.rows.data(), px, strip.num_rows, _width, stride, _color_type, _bit_depth);
+        g_free(px);
+    }
+};
+
+} // namespace
+
 struct SPEBP {
     unsigned long int width, height, sheight;
-    guint32 background;
-    Inkscape::Drawing *drawing; // it is assumed that all unneeded items are hidden
-    guchar *px;
+    StripRenderer *renderer;
     unsigned (*status)(float, void *);
     void *data;
 };
@@ -317,7 +475,7 @@ sp_png_write_rgba_striped(SPDocument *doc,
 
 
 /**
- *
+ * Hand the next strip of rendered rows to libpng.
  */
 static int
 sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, void *data, int color_type, int bit_depth)
@@ -328,44 +486,11 @@ sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, v
         if (!ebp->status((float) row / ebp->height, ebp->data)) return 0;
     }
 
-    num_rows = MIN(num_rows, static_cast<int>(ebp->sheight));
-    num_rows = MIN(num_rows, static_cast<int>(ebp->height - row));
-
-    /* Set area of interest */
-    // bbox is now set to the entire image to prevent discontinuities
-    // in the image when blur is used (the borders may still be a bit
-    // off, but that's less noticeable).
-    Geom::IntRect bbox = Geom::IntRect::from_xywh(0, row, ebp->width, num_rows);
+    auto strip = ebp->renderer->take(row);
+    std::copy(strip->rows.begin(), strip->rows.end(), rows);
+    *to_free = (void*) strip->data;
 
-    /* Update to renderable state */
-    ebp->drawing->update(bbox);
-
-    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp->width);
-    unsigned char *px = g_new(guchar, num_rows * stride);
-
-    cairo_surface_t *s = cairo_image_surface_create_for_data(
-        px, CAIRO_FORMAT_ARGB32, ebp->width, num_rows, stride);
-    Inkscape::DrawingContext dc(s, bbox.min());
-    dc.setSource(ebp->background);
-    dc.setOperator(CAIRO_OPERATOR_SOURCE);
-    dc.paint();
-    dc.setOperator(CAIRO_OPERATOR_OVER);
-
-    /* Render */
-    ebp->drawing->render(dc, bbox, 0);
-    cairo_surface_destroy(s);
-
-    // PNG stores data as unpremultiplied big-endian RGBA, which means
-    // it's identical to the GdkPixbuf format.
-    convert_pixels_argb32_to_pixbuf(px, ebp->width, num_rows, stride,
-                                    /* RGBA to ARGB with A=0 */ ebp->background >> 8);
-    
-    // If a custom bit depth or color type is asked, then convert rgb to grayscale, etc.
-    const guchar* new_data = pixbuf_to_png(rows, px, num_rows, ebp->width, stride, color_type, bit_depth);
-    *to_free = (void*) new_data;
-    free(px);
-
-    return num_rows;
+    return strip->num_rows;
 }
 
 ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
@@ -432,7 +557,6 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
     struct SPEBP ebp;
     ebp.width  = width;
     ebp.height = height;
-    ebp.background = bgcolor;
 
     /* Create new drawing */
     Inkscape::Drawing drawing;
@@ -442,8 +566,6 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
     drawing.setExact(); // export with maximum blur rendering quality
     drawing.setAntialiasingOverride(static_cast<Inkscape::Antialiasing>(antialiasing));
 
-    ebp.drawing = &drawing;
-
     // We show all and then hide all items we don't want, instead of showing only requested items,
     // because that would not work if the shown item references something in defs
     if (!items_only.empty()) {
@@ -453,16 +575,26 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
     ebp.status = status;
     ebp.data   = data;
 
-    bool write_status = false;;
-
     ebp.sheight = 64;
-    ebp.px = g_try_new(guchar, 4 * ebp.sheight * width);
 
-    if (ebp.px) {
+    /* Update to renderable state */
+    drawing.update(Geom::IntRect::from_xywh(0, 0, width, height));
+
+    // Changes made to the document while exporting (e.g. from the status callback) are deferred
+    // until all strips have been rendered.
+    drawing.snapshot();
+
+    bool write_status = false;
+    {
+        int const default_numthreads = std::max(std::thread::hardware_concurrency(), 1u);
+        int const numthreads = Inkscape::Preferences::get()->getIntLimited("/options/threading/numthreads", default_numthreads, 1, 256);
+        StripRenderer renderer(drawing, width, height, ebp.sheight, bgcolor, color_type, bit_depth, numthreads);
+        ebp.renderer = &renderer;
         write_status = sp_png_write_rgba_striped(doc, filename, width, height, xdpi, ydpi, sp_export_get_rows, &ebp, interlace, color_type, bit_depth, zlib);
-        g_free(ebp.px);
     }
 
+    drawing.unsnapshot();
+
     // Hide items, this releases arenaitem
     doc->getRoot()->invoke_hide(dkey);
 
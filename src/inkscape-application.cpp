@@ -794,6 +794,7 @@ InkscapeApplication::InkscapeApplication()
     gapp->add_main_option_entry(T::OPTION_TYPE_BOOL,     "batch-process",         '\0', N_("Close GUI after executing all actions"),                                    "");
     _start_main_option_section();
     gapp->add_main_option_entry(T::OPTION_TYPE_BOOL,     "shell",                 '\0', N_("Start Inkscape in interactive shell mode"),                                 "");
+    gapp->add_main_option_entry(T::OPTION_TYPE_BOOL,     "batch-export",          '\0', N_("Read export jobs (lists of actions) from standard input, one per line"),    "");
     gapp->add_main_option_entry(T::OPTION_TYPE_BOOL,     "active-window",          'q', N_("Use active window from commandline"),                                       "");
     // clang-format on
 
@@ -1065,6 +1066,12 @@ InkscapeApplication::on_activate()
 {
     std::string output;
 
+    if (_use_batch_export) {
+        // Jobs open their own documents.
+        batch_export();
+        return;
+    }
+
     // Create new document, either from pipe or from template.
     SPDocument *document = nullptr;
     auto prefs = Inkscape::Preferences::get();
@@ -1389,6 +1396,60 @@ InkscapeApplication::shell(bool active_window)
     }
 }
 
+/**
+ * Run export jobs read from standard input, one per line, in this instance of Inkscape.
+ *
+ * Unlike starting Inkscape once per file, preferences, extensions and fonts are only loaded once.
+ * Each job is a list of actions in the same syntax as --actions, e.g.
+ *
+ *     file-open:in.svg; export-type:png; export-dpi:300; export-filename:out.png; export-do
+ *
+ * Every job starts from the default export settings and any document it opens is closed when it
+ * finishes, so jobs do not influence each other. Empty lines and lines whose first non-blank
+ * character is '#' are ignored. After each job, "done N" is written to standard error so that a
+ * controlling process can wait for its completion, without mixing it into an export written to
+ * standard output; a summary of the throughput follows at the end.
+ */
+void InkscapeApplication::batch_export()
+{
+    auto const start = std::chrono::steady_clock::now();
+    int jobs = 0;
+
+    std::string input;
+    while (std::getline(std::cin, input)) {
+        auto const first = input.find_first_not_of(" \t\r");
+        if (first == std::string::npos || input[first] == '#') {
+            continue;
+        }
+        jobs++;
+
+        _file_export = InkFileExportCmd();
+
+        action_vector_t action_vector;
+        parse_actions(input, action_vector);
+        for (auto const &action : action_vector) {
+            _gio_application->activate_action(action.first, action.second);
+        }
+
+        for (auto document : get_documents()) {
+            INKSCAPE.remove_document(document);
+            document_close(document);
+        }
+        _active_document = nullptr;
+        _active_selection = nullptr;
+        _active_desktop = nullptr;
+
+        std::cerr << "done " << jobs << std::endl;
+    }
+
+    auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << "Batch export: " << jobs << " jobs in " << elapsed << " s";
+    if (elapsed > 0) {
+        std::cerr << " (" << jobs / elapsed << " jobs/s)";
+    }
+    std::cerr << std::endl;
+}
+
 // Todo: Code can be improved by using proper IPC rather than temporary file polling.
 void InkscapeApplication::redirect_output()
 {
@@ -1561,7 +1622,8 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
         options->contains("action-list")           ||
         options->contains("actions")               ||
         options->contains("actions-file")          ||
-        options->contains("shell")
+        options->contains("shell")                 ||
+        options->contains("batch-export")
         ) {
         _with_gui = false;
     }
@@ -1577,6 +1639,7 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
     if (options->contains("batch-process"))  _batch_process = true;
     if (options->contains("shell"))          _use_shell = true;
     if (options->contains("pipe"))           _use_pipe  = true;
+    if (options->contains("batch-export"))   _use_batch_export = true;
 
     // Enable auto-export
     if (options->contains("export-filename")  ||
@@ -139,6 +139,7 @@ protected:
     bool _batch_process = false; // Temp
     bool _use_shell   = false;
     bool _use_pipe    = false;
+    bool _use_batch_export = false;
     bool _auto_export = false;
     int _pdf_poppler  = false;
     FontStrategy _pdf_font_strategy = FontStrategy::RENDER_MISSING;
@@ -180,6 +181,7 @@ protected:
     void on_about();
     void redirect_output();
     void shell(bool active_window = false);
+    void batch_export();
 
     void _start_main_option_section(const Glib::ustring& section_name = "");
     
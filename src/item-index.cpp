@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Spatial index of the items of a document, for finding items by area.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "item-index.h"
+
+#include "object/sp-item.h"
+#include "object/sp-item-group.h"
+
+namespace Inkscape {
+
+void ItemIndex::invalidate()
+{
+    _valid = false;
+    _changed.clear();
+    _dirty.clear();
+}
+
+void ItemIndex::itemChanged(SPItem const *item)
+{
+    if (!_valid) {
+        return;
+    }
+    if (auto it = _slots.find(item); it != _slots.end() && !_dirty[it->second]) {
+        _dirty[it->second] = true;
+        _changed.emplace_back(it->second);
+    }
+}
+
+void ItemIndex::query(Geom::Rect const &area, std::function<void (SPItem *, Geom::Rect const &)> const &f)
+{
+    if (!_valid) {
+        _build();
+    } else if (!_changed.empty()) {
+        _refresh();
+    }
+
+    for (auto i : _index.query(area)) {
+        f(_items[i], *_boxes[i]);
+    }
+}
+
+void ItemIndex::_collect(SPGroup *group)
+{
+    for (auto &child : group->children) {
+        if (auto item = cast<SPItem>(&child)) {
+            if (auto childgroup = cast<SPGroup>(item)) {
+                _collect(childgroup);
+            }
+            _slots.emplace(item, _items.size());
+            _items.emplace_back(item);
+        }
+    }
+}
+
+void ItemIndex::_build()
+{
+    _items.clear();
+    _slots.clear();
+    _changed.clear();
+    _collect(_root);
+    _dirty.assign(_items.size(), false);
+
+    _boxes.clear();
+    _boxes.reserve(_items.size());
+    for (auto item : _items) {
+        _boxes.emplace_back(item->documentVisualBounds());
+    }
+
+    _index.build(_boxes);
+    _refitted = 0;
+    _valid = true;
+}
+
+void ItemIndex::_refresh()
+{
+    // Refitting loosens the tree, so rebuild once about as many boxes have changed as there are.
+    _refitted += _changed.size();
+    if (_refitted > _items.size() / 2) {
+        _build();
+        return;
+    }
+
+    bool rebuild = false;
+    for (auto i : _changed) {
+        _boxes[i] = _items[i]->documentVisualBounds();
+        rebuild |= !_index.update(i, _boxes[i]);
+        _dirty[i] = false;
+    }
+    _changed.clear();
+
+    if (rebuild) {
+        _index.build(_boxes);
+        _refitted = 0;
+    } else {
+        _index.refit();
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Spatial index of the items of a document, for finding items by area.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef INKSCAPE_ITEM_INDEX_H
+#define INKSCAPE_ITEM_INDEX_H
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include <2geom/rect.h>
+
+#include "util/spatial-index.h"
+
+class SPGroup;
+class SPItem;
+
+namespace Inkscape {
+
+/**
+ * The visual bounds in document coordinates of the items reachable from the root through groups,
+ * which are the items that SPDocument::getItemsInBox() and similar consider.
+ *
+ * The index is built on the first query. Afterwards, only the bounds of the items reported by
+ * itemChanged() are recomputed, and the tree is refitted to them. Adding, removing or reordering
+ * items requires a rebuild, which invalidate() schedules.
+ */
+class ItemIndex
+{
+public:
+    explicit ItemIndex(SPGroup *root) : _root(root) {}
+
+    /// Schedule a rebuild, because items were added, removed or reordered.
+    void invalidate();
+
+    /// Note that the bounds of an item may have changed.
+    void itemChanged(SPItem const *item);
+
+    /**
+     * Call f(item, bounds) for the items whose visual bounds intersect an area, given in document
+     * coordinates. The items are visited in the order the document is traversed, with the
+     * children of each group before the group itself.
+     */
+    void query(Geom::Rect const &area, std::function<void (SPItem *, Geom::Rect const &)> const &f);
+
+private:
+    SPGroup *_root;
+    std::vector<SPItem *> _items;
+    std::vector<Geom::OptRect> _boxes;
+    std::unordered_map<SPItem const *, unsigned> _slots;
+    std::vector<unsigned> _changed; ///< The slots to recompute, each listed once.
+    std::vector<bool> _dirty;       ///< Whether each slot is listed in _changed.
+    Util::SpatialIndex<double> _index;
+    unsigned _refitted = 0; ///< The number of boxes changed by refitting since the last build.
+    bool _valid = false;
+
+    void _collect(SPGroup *group);
+    void _build();
+    void _refresh();
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_ITEM_INDEX_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
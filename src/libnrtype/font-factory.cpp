@@ -169,8 +169,8 @@ PangoFontDescription *ink_font_description_from_style(SPStyle const *style)
     }
 
     // Check if not empty as Pango will add @ to string even if empty (bug in Pango?).
-    if (!style->font_variation_settings.axes.empty()) {
-        pango_font_description_set_variations(descr, style->font_variation_settings.toString().c_str());
+    if (auto const &settings = style->fontVariants().font_variation_settings; !settings.axes.empty()) {
+        pango_font_description_set_variations(descr, settings.toString().c_str());
     }
 
     return descr;
@@ -10,9 +10,12 @@
 #ifndef SEEN_SP_GRADIENT_VECTOR_H
 #define SEEN_SP_GRADIENT_VECTOR_H
 
+#include <memory>
 #include <vector>
 #include "color.h"
 
+namespace Inkscape { class GradientLut; }
+
 /**
  * Differs from SPStop in that SPStop mirrors the \<stop\> element in the document, whereas
  * SPGradientStop shows more the effective stop color.
@@ -33,6 +36,7 @@ struct SPGradientStop {
 struct SPGradientVector {
     bool built;
     std::vector<SPGradientStop> stops;
+    std::shared_ptr<Inkscape::GradientLut> lut; ///< Colour table of the stops, made when first painted.
 };
 
 #endif /* !SEEN_SP_GRADIENT_VECTOR_H */
@@ -954,6 +954,7 @@ bool SPGradient::invalidateVector()
     if (vector.built) {
         vector.built = false;
         vector.stops.clear();
+        vector.lut.reset();
         ret = true;
     }
 
@@ -987,6 +988,7 @@ void SPGradient::rebuildVector()
     has_stops = (len != 0);
 
     vector.stops.clear();
+    vector.lut.reset();
 
     SPGradient *reffed = ref ? ref->getObject() : nullptr;
     if ( !hasStops() && reffed ) {
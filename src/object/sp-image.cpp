@@ -18,7 +18,14 @@
 
 #include <cstring>
 #include <algorithm>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 #include <giomm/error.h>
 #include <glib/gstdio.h>
@@ -39,6 +46,7 @@
 #include "display/drawing-image.h"
 #include "display/cairo-utils.h"
 #include "display/curve.h"
+#include "inkgc/gc-managed.h"
 #include "xml/quote.h"
 #include "xml/href-attribute-helper.h"
 
@@ -131,6 +139,11 @@ void SPImage::build(SPDocument *document, Inkscape::XML::Node *repr) {
     this->readAttr(SPAttr::PRESERVEASPECTRATIO);
     this->readAttr(SPAttr::COLOR_PROFILE);
 
+    // Start decoding embedded data now, so that it overlaps with building the rest of the document.
+    if (!color_profile) {
+        decoded = decodeEmbedded(Inkscape::getHrefAttribute(*repr).second, true);
+    }
+
     /* Register */
     document->addResource("image", this);
 }
@@ -147,6 +160,7 @@ void SPImage::release() {
     }
 
     pixbuf.reset();
+    decoded.reset();
 
     if (this->color_profile) {
         g_free (this->color_profile);
@@ -163,6 +177,7 @@ void SPImage::set(SPAttr key, const gchar* value) {
         case SPAttr::XLINK_HREF:
             g_free (this->href);
             this->href = (value) ? g_strdup (value) : nullptr;
+            decoded.reset();
             this->requestDisplayUpdate(SP_OBJECT_MODIFIED_FLAG | SP_IMAGE_HREF_MODIFIED_FLAG);
             break;
 
@@ -318,10 +333,28 @@ void SPImage::update(SPCtx *ctx, unsigned int flags) {
                 svgdpi = g_ascii_strtod(getRepr()->attribute("inkscape:svg-dpi"), nullptr);
             }
             dpi = svgdpi;
-            pb = readImage(Inkscape::getHrefAttribute(*getRepr()).second,
-                           getRepr()->attribute("sodipodi:absref"),
-                           document->getDocumentBase(), svgdpi);
-            if (!pb) {
+
+            // Embedded raster data is shared with other images, and has already been converted for rendering.
+            // (Images with a colour profile apply it to their own copy, so they are excluded.)
+            auto const href_attr = Inkscape::getHrefAttribute(*getRepr()).second;
+            if (!color_profile) {
+                if (!decoded) {
+                    decoded = decodeEmbedded(href_attr, false);
+                }
+                if (decoded) {
+                    pixbuf = decoded->get();
+                }
+            }
+
+            if (!pixbuf) {
+                // A data URI that failed to decode above would fail again, so only try the absolute path.
+                pb = readImage(decoded ? nullptr : href_attr,
+                               getRepr()->attribute("sodipodi:absref"),
+                               document->getDocumentBase(), svgdpi);
+            }
+            if (pixbuf) {
+                missing = false;
+            } else if (!pb) {
                 missing = true;
                 // Passing in our previous size allows us to preserve the image's expected size.
                 auto broken_width = width._set ? width.computed : 640;
@@ -566,6 +599,90 @@ Inkscape::DrawingItem* SPImage::show(Inkscape::Drawing &drawing, unsigned int /*
 }
 
 
+namespace {
+
+/**
+ * A data URI held by the XML tree, kept alive without copying it for as long as it is being decoded
+ * or may be compared with. Attribute values are garbage collected, and this is scanned by the collector
+ * without being collected itself.
+ */
+struct EmbeddedData : Inkscape::GC::Managed<Inkscape::GC::SCANNED, Inkscape::GC::MANUAL>
+{
+    EmbeddedData(char const *href, std::string_view uri) : href(href), uri(uri) {}
+    char const *href;
+    std::string_view uri; ///< The data after "data:", which lies within href.
+};
+
+struct EmbeddedDecoding
+{
+    std::shared_ptr<EmbeddedData const> data;
+    std::weak_ptr<std::shared_future<std::shared_ptr<Inkscape::Pixbuf const>> const> result;
+};
+
+} // namespace
+
+/**
+ * Start decoding an embedded raster image, or join a decoding of identical data that is already
+ * in progress or still in use by another image. If background is set, the work is done on a
+ * thread pool, otherwise it is done before returning. The href must be an attribute value from the
+ * XML tree, which the decoding keeps alive rather than copying it.
+ *
+ * Returns null if the href is not a data URI with raster data. (SVG data is rendered through an
+ * SPDocument, which may only be done on the main thread, so it is loaded by readImage() instead.)
+ */
+std::shared_ptr<SPImage::PixbufFuture const> SPImage::decodeEmbedded(char const *href, bool background)
+{
+    if (!href || g_ascii_strncasecmp(href, "data:", 5) != 0) {
+        return {};
+    }
+    auto const uri = std::string_view(href + 5);
+    if (uri.substr(0, uri.find(',')).find("image/svg+xml") != std::string_view::npos) {
+        return {};
+    }
+
+    static std::mutex mutex;
+    static std::unordered_multimap<std::string, EmbeddedDecoding> cache;
+    static boost::asio::thread_pool pool(std::max(std::thread::hardware_concurrency(), 1u));
+
+    // A key that is cheap to make however large the data is: its length and both of its ends. Data sharing
+    // a key is then compared in full, which only takes long when it is in fact a duplicate.
+    auto const ends = std::min<std::size_t>(uri.size(), 64);
+    auto key = std::to_string(uri.size());
+    key += uri.substr(0, ends);
+    key += uri.substr(uri.size() - ends);
+
+    auto lock = std::unique_lock(mutex);
+    auto const [first, last] = cache.equal_range(key);
+    for (auto it = first; it != last; ++it) {
+        if (auto existing = it->second.result.lock(); existing && it->second.data->uri == uri) {
+            return existing;
+        }
+    }
+
+    auto data = std::shared_ptr<EmbeddedData const>(new EmbeddedData(href, uri));
+    auto task = std::make_shared<std::packaged_task<std::shared_ptr<Inkscape::Pixbuf const>()>>([data] {
+        auto pb = Inkscape::Pixbuf::create_from_data_uri(data->uri.data());
+        if (!pb) {
+            return std::shared_ptr<Inkscape::Pixbuf const>();
+        }
+        pb->ensurePixelFormat(Inkscape::Pixbuf::PF_CAIRO); // Expected by rendering code, so convert now before making immutable.
+        return std::shared_ptr<Inkscape::Pixbuf const>(pb);
+    });
+    auto result = std::make_shared<PixbufFuture const>(task->get_future().share());
+
+    std::erase_if(cache, [] (auto const &entry) { return entry.second.result.expired(); });
+    cache.emplace(std::move(key), EmbeddedDecoding{ std::move(data), result });
+    lock.unlock();
+
+    if (background) {
+        boost::asio::post(pool, [task] { (*task)(); });
+    } else {
+        (*task)();
+    }
+
+    return result;
+}
+
 Inkscape::Pixbuf *SPImage::readImage(gchar const *href, gchar const *absref, gchar const *base, double svgdpi)
 {
     Inkscape::Pixbuf *inkpb = nullptr;
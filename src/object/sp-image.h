@@ -17,6 +17,7 @@
 
 #include "sp-item.h"
 
+#include <future>
 #include <memory>
 
 #include <glibmm/ustring.h>
@@ -73,6 +74,12 @@ public:
     bool cropToArea(Geom::Rect area);
     bool cropToArea(const Geom::IntRect &area);
 private:
+    using PixbufFuture = std::shared_future<std::shared_ptr<Inkscape::Pixbuf const>>;
+
+    // The decoding of embedded image data, shared with any other images holding identical data.
+    std::shared_ptr<PixbufFuture const> decoded;
+
+    static std::shared_ptr<PixbufFuture const> decodeEmbedded(char const *href, bool background);
     static Inkscape::Pixbuf *readImage(gchar const *href, gchar const *absref, gchar const *base, double svgdpi = 0);
     static Inkscape::Pixbuf *getBrokenImage(double width, double height);
 };
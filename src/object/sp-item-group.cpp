@@ -15,9 +15,14 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#ifdef HAVE_CONFIG_H
+# include "config.h"  // only include where actually required!
+#endif
+
 #include <cstring>
 #include <glibmm/i18n.h>
 #include <string>
+#include <vector>
 
 #include "attributes.h"
 #include "document-undo.h"
@@ -28,15 +33,20 @@
 #include "style.h"
 
 #include "box3d.h"
+#include "conn-avoid-ref.h"
 #include "object-set.h"
 #include "sp-clippath.h"
 #include "sp-defs.h"
 #include "sp-desc.h"
+#include "sp-ellipse.h"
 #include "sp-flowtext.h"
 #include "sp-item-transform.h"
+#include "sp-line.h"
 #include "sp-mask.h"
 #include "sp-offset.h"
 #include "sp-path.h"
+#include "sp-polygon.h"
+#include "sp-polyline.h"
 #include "sp-rect.h"
 #include "sp-root.h"
 #include "sp-switch.h"
@@ -46,6 +56,7 @@
 
 #include "display/curve.h"
 #include "display/drawing-group.h"
+#include "display/drawing.h"
 #include "live_effects/effect.h"
 #include "live_effects/lpe-clone-original.h"
 #include "live_effects/lpeobject-reference.h"
@@ -141,6 +152,95 @@ void SPGroup::order_changed (Inkscape::XML::Node *child, Inkscape::XML::Node *ol
     this->requestModified(SP_OBJECT_MODIFIED_FLAG);
 }
 
+namespace {
+
+/// Set on a thread while it updates a subtree concurrently with its siblings.
+thread_local bool in_concurrent_update = false;
+
+/// The least number of objects in the independent children of a group worth spreading over threads.
+unsigned constexpr CONCURRENT_UPDATE_THRESHOLD = 64;
+
+/**
+ * Whether the update of an object and its descendants touches nothing outside them, so it can run
+ * on a worker thread. This holds for plain groups and basic shapes that refer to no other object:
+ * no paint servers, filters, clips, masks, markers, path effects or connectors, and that nothing
+ * refers to. The caller checks that no ancestor has a path effect, since updating a shape under one
+ * reruns the effect over all of that ancestor's children. Adds the number of objects in the subtree
+ * to count.
+ */
+bool is_independent(SPObject *object, unsigned &count)
+{
+    if (object->uflags & SP_OBJECT_STYLESHEET_MODIFIED_FLAG) {
+        return false; // Restyling reads the document's stylesheets.
+    }
+
+    auto const tag = object->tag();
+    if (tag == tag_of<SPTitle> || tag == tag_of<SPDesc>) {
+        count++;
+        return true;
+    }
+    if (tag != tag_of<SPGroup> && tag != tag_of<SPRect> && tag != tag_of<SPPath> && tag != tag_of<SPGenericEllipse> &&
+        tag != tag_of<SPLine> && tag != tag_of<SPPolyLine> && tag != tag_of<SPPolygon>)
+    {
+        return false;
+    }
+
+    auto const item = static_cast<SPLPEItem *>(object);
+    auto const style = item->style;
+    if (item->isReferenced() || item->hasPathEffect() || item->getClipObject() || item->getMaskObject() || item->avoidRef->settingChanged() ||
+        style->fill.isPaintserver() || style->stroke.isPaintserver() || style->filter.set)
+    {
+        return false;
+    }
+    for (auto marker : style->marker_ptrs) {
+        if (marker->value()) {
+            return false;
+        }
+    }
+    if (auto path = cast<SPPath>(item); path && path->connEndPair.isAutoRoutingConn()) {
+        return false;
+    }
+
+    count++;
+    for (auto &child : object->children) {
+        if (!is_independent(&child, count)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Update independent children of a group on a worker pool. Their changes to the drawings showing
+ * them are recorded per child, and applied on this thread afterwards, in document order.
+ */
+void update_concurrently(std::vector<SPItem *> const &items, SPItemCtx const &ictx, unsigned flags, int threads)
+{
+    std::vector<Inkscape::Util::FuncLog> changes(items.size());
+
+#if HAVE_OPENMP
+    #pragma omp parallel for schedule(dynamic) num_threads(threads)
+#endif
+    for (int i = 0; i < (int)items.size(); i++) {
+        auto const item = items[i];
+        SPItemCtx cctx = ictx;
+        cctx.i2doc = item->transform * ictx.i2doc;
+        cctx.i2vp = item->transform * ictx.i2vp;
+
+        in_concurrent_update = true;
+        Inkscape::Drawing::redirectChanges(&changes[i]);
+        item->updateDisplay((SPCtx *)&cctx, flags);
+        Inkscape::Drawing::redirectChanges(nullptr);
+        in_concurrent_update = false;
+    }
+
+    for (auto &log : changes) {
+        log();
+    }
+}
+
+} // namespace
+
 void SPGroup::update(SPCtx *ctx, unsigned int flags) {
     // std::cout << "SPGroup::update(): " << (getId()?getId():"null") << std::endl;
     SPItemCtx *ictx, cctx;
@@ -155,8 +255,38 @@ void SPGroup::update(SPCtx *ctx, unsigned int flags) {
     }
     childflags &= SP_OBJECT_MODIFIED_CASCADE;
     std::vector<SPObject*> l=this->childList(true, SPObject::ActionUpdate);
+
+    auto const needs_update = [&] (SPObject *child) {
+        return childflags || (child->uflags & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_CHILD_MODIFIED_FLAG));
+    };
+
+    // Update the children that nothing refers to, and that refer to nothing, concurrently.
+    std::vector<SPItem *> concurrent;
+#if HAVE_OPENMP
+    if (document->update_threads > 1 && !in_concurrent_update && !(childflags & SP_OBJECT_STYLESHEET_MODIFIED_FLAG) &&
+        !style->fill.isPaintserver() && !style->stroke.isPaintserver() && !hasPathEffectRecursive())
+    {
+        unsigned count = 0;
+        for (auto child : l) {
+            auto item = cast<SPItem>(child);
+            if (item && needs_update(item) && is_independent(item, count)) {
+                concurrent.emplace_back(item);
+            }
+        }
+        if (concurrent.size() < 2 || count < CONCURRENT_UPDATE_THRESHOLD) {
+            concurrent.clear();
+        } else {
+            update_concurrently(concurrent, *ictx, childflags, document->update_threads);
+            document->update_concurrent_subtrees += concurrent.size();
+        }
+    }
+#endif
+
+    auto done = concurrent.begin(); // In the order of l.
     for(auto child : l){
-        if (childflags || (child->uflags & (SP_OBJECT_MODIFIED_FLAG | SP_OBJECT_CHILD_MODIFIED_FLAG))) {
+        if (done != concurrent.end() && *done == child) {
+            ++done;
+        } else if (needs_update(child)) {
             auto item = cast<SPItem>(child);
             if (item) {
                 cctx.i2doc = item->transform * ictx->i2doc;
@@ -132,8 +132,17 @@ Inkscape::XML::Node* SPLinearGradient::write(Inkscape::XML::Document *xml_doc, I
 std::unique_ptr<Inkscape::DrawingPaintServer> SPLinearGradient::create_drawing_paintserver()
 {
     ensureVector();
+
+    // Share the colour table with every gradient whose stops are copied from the same one.
+    auto src = getVector();
+    src->ensureVector();
+    if (!src->vector.lut) {
+        src->vector.lut = std::make_shared<Inkscape::GradientLut>(src->vector.stops);
+    }
+
     return std::make_unique<Inkscape::DrawingLinearGradient>(getSpread(), getUnits(), gradientTransform,
-                                                             x1.computed, y1.computed, x2.computed, y2.computed, vector.stops);
+                                                             x1.computed, y1.computed, x2.computed, y2.computed, vector.stops,
+                                                             src->vector.lut);
 }
 
 /*
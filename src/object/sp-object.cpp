@@ -752,6 +752,10 @@ void SPObject::order_changed(Inkscape::XML::Node *child, Inkscape::XML::Node * /
     g_return_if_fail(ochild != nullptr);
     SPObject *prev = get_closest_child_by_repr(*object, new_ref);
     object->reorder(ochild, prev);
+    if (is<SPItem>(ochild)) {
+        // The z-order of the items found by area follows the order of the children.
+        document->_itemsReordered();
+    }
     ochild->_position_changed_signal.emit(ochild);
 }
 
@@ -1394,7 +1398,7 @@ void SPObject::requestDisplayUpdate(unsigned int flags)
     // expect no nested update calls
     if (document->update_in_progress) {
         // observed with LPE on <rect>
-        g_warning("WARNING: Requested update while update in progress, counter = %d", document->update_in_progress);
+        g_warning("WARNING: Requested update while update in progress, counter = %u", document->update_in_progress.load());
     }
 #endif
 
@@ -1542,6 +1546,11 @@ void SPObject::emitModified(unsigned int flags)
      * themselves. */
     this->mflags = 0;
 
+    // Any modification of an item might change its bounds.
+    if (auto item = cast<SPItem>(this)) {
+        document->_itemChanged(item);
+    }
+
     sp_object_ref(this);
 
     this->modified(flags);
@@ -688,6 +688,9 @@ Inkscape::DrawingPattern *SPPattern::show(Inkscape::Drawing &drawing, unsigned k
     auto &v = views.back();
     auto root = v.drawingitem.get();
 
+    // All views of this pattern in a drawing render the same content, so they can share their tiles.
+    root->setContentKey(this);
+
     if (shown) {
         shown->attach_view(root, key);
     }
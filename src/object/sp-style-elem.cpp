@@ -441,6 +441,8 @@ static void clear_style_sheet(SPStyleElem &self)
         return;
     }
 
+    self.document->styleSheetsChanged();
+
     auto *next = self.style_sheet->next;
     auto *cascade = self.document->getStyleCascade();
     auto *topsheet = cr_cascade_get_sheet(cascade, ORIGIN_AUTHOR);
@@ -492,6 +494,7 @@ void SPStyleElem::read_content() {
             // If not the first, then chain up this style_sheet
             cr_stylesheet_append_stylesheet(topsheet, style_sheet);
         }
+        document->styleSheetsChanged();
     } else {
         cr_stylesheet_destroy (style_sheet);
         style_sheet = nullptr;
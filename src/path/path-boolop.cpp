@@ -13,8 +13,17 @@
 
 #include "path-boolop.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <thread>
 #include <vector>
 
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <glibmm/i18n.h>
 
 #include <2geom/intersection-graph.h>
@@ -26,6 +35,7 @@
 #include "message-stack.h"
 #include "path-chemistry.h"     // copy_object_properties()
 #include "path-util.h"
+#include "preferences.h"
 
 #include "display/curve.h"
 #include "helper/geom.h"        // pathv_to_linear_and_cubic_beziers()
@@ -36,6 +46,7 @@
 #include "object/sp-shape.h"
 #include "object/sp-text.h"
 #include "ui/icon-names.h"
+#include "util/spatial-index.h"
 #include "xml/repr-sorting.h"
 
 using Inkscape::DocumentUndo;
@@ -138,6 +149,223 @@ static bool is_line(Path const &path)
     return path.pts.size() == 2 && path.pts[0].isMoveTo && !path.pts[1].isMoveTo;
 }
 
+/*
+ * N-ary operations
+ */
+
+/**
+ * Apply a boolean operation to a sequence of paths from left to right, and return the resulting polygon.
+ *
+ * Each path is flattened with its own threshold and fill rule, and its edges are tagged with its index
+ * in the paths array, so that the result can be turned back into a path by ConvertToForme().
+ */
+static std::unique_ptr<Shape> fold_shapes(BooleanOp bop, std::vector<int> const &order, std::vector<Path *> const &paths,
+                                          std::vector<FillRule> const &fill_rules, std::vector<double> const &thresholds)
+{
+    auto shapea = std::make_unique<Shape>();
+    auto shapeb = std::make_unique<Shape>();
+    auto tmp = std::make_unique<Shape>();
+
+    auto convert = [&] (int i, Shape &dest) {
+        paths[i]->ConvertWithBackData(thresholds[i]);
+        paths[i]->Fill(tmp.get(), i);
+        dest.ConvertToShape(tmp.get(), fill_rules[i]);
+    };
+
+    convert(order.front(), *shapea);
+
+    for (auto it = order.begin() + 1; it != order.end(); ++it) {
+        convert(*it, *shapeb);
+
+        /* Due to quantization of the input shape coordinates, we may end up with A or B being empty.
+         * If this is a union or symdiff operation, we just use the non-empty shape as the result:
+         *   A=0  =>  (0 or B) == B
+         *   B=0  =>  (A or 0) == A
+         *   A=0  =>  (0 xor B) == B
+         *   B=0  =>  (A xor 0) == A
+         * If this is an intersection operation, we just use the empty shape as the result:
+         *   A=0  =>  (0 and B) == 0 == A
+         *   B=0  =>  (A and 0) == 0 == B
+         * If this a difference operation, and the upper shape (A) is empty, we keep B.
+         * If the lower shape (B) is empty, we still keep B, as it's empty:
+         *   A=0  =>  (B - 0) == B
+         *   B=0  =>  (0 - A) == 0 == B
+         *
+         * In any case, the output from this operation is stored in shape A, so we may apply
+         * the above rules simply by judicious use of swapping A and B where necessary.
+         */
+        bool zeroA = shapea->numberOfEdges() == 0;
+        bool zeroB = shapeb->numberOfEdges() == 0;
+        if (zeroA || zeroB) {
+            // We might need to do a swap. Apply the above rules depending on operation type.
+            bool resultIsB =   ((bop == bool_op_union || bop == bool_op_symdiff) && zeroA)
+                               || ((bop == bool_op_inters) && zeroB)
+                               ||  (bop == bool_op_diff);
+            if (resultIsB) {
+                std::swap(shapea, shapeb);
+            }
+        } else {
+            // Just do the Boolean operation as usual
+            // les elements arrivent en ordre inverse dans la liste
+            tmp->Booleen(shapeb.get(), shapea.get(), bop);
+            std::swap(tmp, shapea);
+        }
+    }
+
+    return shapea;
+}
+
+/**
+ * Partition a set of boxes into clusters connected by overlaps. Paths in different clusters cannot
+ * interact in a union, so the clusters can be processed independently.
+ *
+ * Each cluster is in increasing order, and clusters are ordered by their first element.
+ */
+static std::vector<std::vector<int>> overlap_clusters(std::vector<Geom::OptRect> const &bounds)
+{
+    int const n = bounds.size();
+
+    std::vector<int> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&] (int i) {
+        while (parent[i] != i) {
+            i = parent[i] = parent[parent[i]];
+        }
+        return i;
+    };
+
+    Inkscape::Util::SpatialIndex<Geom::Coord> index;
+    index.build(bounds);
+    for (int i = 0; i < n; i++) {
+        if (!bounds[i]) {
+            continue;
+        }
+        index.query(*bounds[i], [&] (unsigned j) {
+            auto const ri = find(i);
+            auto const rj = find(j);
+            if (ri != rj) {
+                parent[std::max(ri, rj)] = std::min(ri, rj);
+            }
+        });
+    }
+
+    std::vector<std::vector<int>> result;
+    std::vector<int> cluster_of(n);
+    for (int i = 0; i < n; i++) {
+        auto const root = find(i);
+        if (root == i) {
+            cluster_of[i] = result.size();
+            result.emplace_back();
+        }
+        result[cluster_of[root]].emplace_back(i);
+    }
+
+    return result;
+}
+
+/**
+ * Call f(i) for each i in [0, n), on the pool if there is one, and wait for all the calls to finish.
+ */
+template <typename F>
+static void run_all(boost::asio::thread_pool *pool, int n, F const &f)
+{
+    if (!pool) {
+        for (int i = 0; i < n; i++) {
+            f(i);
+        }
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    int remaining = n;
+
+    for (int i = 0; i < n; i++) {
+        boost::asio::post(*pool, [&, i] {
+            f(i);
+            auto lock = std::unique_lock(mutex);
+            if (--remaining == 0) {
+                cond.notify_all();
+            }
+        });
+    }
+
+    auto lock = std::unique_lock(mutex);
+    cond.wait(lock, [&] { return remaining == 0; });
+}
+
+/**
+ * Compute the union of a set of paths, with the result tagged as in fold_shapes().
+ *
+ * The paths are split into clusters of overlapping bounding boxes, which are unioned concurrently on
+ * up to numthreads threads. The cluster results are then merged pairwise in a balanced tree, so each
+ * edge takes part in a logarithmic number of sweeps rather than one per remaining input.
+ */
+static std::unique_ptr<Shape> union_shapes(std::vector<Path *> const &paths, std::vector<FillRule> const &fill_rules,
+                                           std::vector<double> const &thresholds, std::vector<Geom::OptRect> const &bounds,
+                                           int numthreads)
+{
+    auto const clusters = overlap_clusters(bounds);
+    int const n = clusters.size();
+
+    std::optional<boost::asio::thread_pool> pool;
+    if (numthreads > 1 && n > 1) {
+        pool.emplace(std::min(numthreads, n));
+    }
+    auto const pool_ptr = pool ? &*pool : nullptr;
+
+    std::vector<std::unique_ptr<Shape>> shapes(n);
+    run_all(pool_ptr, n, [&] (int i) {
+        shapes[i] = fold_shapes(bool_op_union, clusters[i], paths, fill_rules, thresholds);
+    });
+
+    for (int step = 1; step < n; step *= 2) {
+        run_all(pool_ptr, (n + step - 1) / (2 * step), [&] (int k) {
+            auto &a = shapes[2 * step * k];
+            auto &b = shapes[2 * step * k + step];
+            if (a->numberOfEdges() == 0) {
+                std::swap(a, b);
+            } else if (b->numberOfEdges() != 0) {
+                auto merged = std::make_unique<Shape>();
+                merged->Booleen(b.get(), a.get(), bool_op_union);
+                a = std::move(merged);
+            }
+            b.reset();
+        });
+    }
+
+    return std::move(shapes.front());
+}
+
+Geom::PathVector sp_pathvector_union(std::vector<Geom::PathVector> const &pathvs, std::vector<FillRule> const &fill_rules,
+                                     int numthreads)
+{
+    assert(pathvs.size() == fill_rules.size());
+    if (pathvs.empty()) {
+        return {};
+    }
+
+    std::vector<std::unique_ptr<Path>> owned;
+    std::vector<Path *> paths;
+    std::vector<double> thresholds;
+    std::vector<Geom::OptRect> bounds;
+    for (auto const &pathv : pathvs) {
+        // Livarot's outline of arcs is broken, see sp_pathvector_boolop().
+        auto const converted = pathv_to_linear_and_cubic_beziers(pathv);
+        owned.emplace_back(Path_for_pathvector(converted));
+        paths.emplace_back(owned.back().get());
+        thresholds.emplace_back(get_threshold(converted));
+        bounds.emplace_back(converted.boundsFast());
+    }
+
+    auto shape = union_shapes(paths, fill_rules, thresholds, bounds, numthreads);
+
+    Path result;
+    shape->ConvertToForme(&result, paths.size(), paths.data());
+
+    return result.MakePathVector();
+}
+
 /*
  * Flattening
  */
@@ -489,6 +717,7 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(BooleanOp bop, const bool skip_undo
     std::vector<Path *> originaux(nbOriginaux);
     std::vector<FillRule> origWind(nbOriginaux);
     std::vector<double> origThresh(nbOriginaux);
+    std::vector<Geom::OptRect> origBounds(nbOriginaux);
     int curOrig;
     {
         curOrig = 0;
@@ -522,6 +751,7 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(BooleanOp bop, const bool skip_undo
                 auto pathv = curve->get_pathvector() * item->i2doc_affine();
                 originaux[curOrig] = Path_for_pathvector(pathv).release();
                 origThresh[curOrig] = get_threshold(pathv);
+                origBounds[curOrig] = pathv.boundsFast();
             } else {
                 originaux[curOrig] = nullptr;
             }
@@ -540,6 +770,7 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(BooleanOp bop, const bool skip_undo
         std::swap(originaux[0], originaux[1]);
         std::swap(origWind[0], origWind[1]);
         std::swap(origThresh[0], origThresh[1]);
+        std::swap(origBounds[0], origBounds[1]);
     }
 
     // and work
@@ -552,70 +783,21 @@ BoolOpErrors Inkscape::ObjectSet::pathBoolOp(BooleanOp bop, const bool skip_undo
     Path::cut_position  *toCut=nullptr;
     int                  nbToCut=0;
 
-    if ( bop == bool_op_inters || bop == bool_op_union || bop == bool_op_diff || bop == bool_op_symdiff ) {
+    if ( bop == bool_op_union ) {
+        // inputs in separate clusters of overlapping bounding boxes are unioned concurrently
+        // The default is not clamped to the limits, and hardware_concurrency() may report zero.
+        auto const numthreads = Inkscape::Preferences::get()->getIntLimited("/options/threading/numthreads",
+                                                                             std::max(std::thread::hardware_concurrency(), 1u), 1, 256);
+        delete theShape;
+        theShape = union_shapes(originaux, origWind, origThresh, origBounds, numthreads).release();
+
+    } else if ( bop == bool_op_inters || bop == bool_op_diff || bop == bool_op_symdiff ) {
         // true boolean op
         // get the polygons of each path, with the winding rule specified, and apply the operation iteratively
-        originaux[0]->ConvertWithBackData(origThresh[0]);
-
-        originaux[0]->Fill(theShape, 0);
-
-        theShapeA->ConvertToShape(theShape, origWind[0]);
-
-        curOrig = 1;
-        for (auto item : il){
-            if(item==il[0])continue;
-            originaux[curOrig]->ConvertWithBackData(origThresh[curOrig]);
-
-            originaux[curOrig]->Fill(theShape, curOrig);
-
-            theShapeB->ConvertToShape(theShape, origWind[curOrig]);
-
-            /* Due to quantization of the input shape coordinates, we may end up with A or B being empty.
-             * If this is a union or symdiff operation, we just use the non-empty shape as the result:
-             *   A=0  =>  (0 or B) == B
-             *   B=0  =>  (A or 0) == A
-             *   A=0  =>  (0 xor B) == B
-             *   B=0  =>  (A xor 0) == A
-             * If this is an intersection operation, we just use the empty shape as the result:
-             *   A=0  =>  (0 and B) == 0 == A
-             *   B=0  =>  (A and 0) == 0 == B
-             * If this a difference operation, and the upper shape (A) is empty, we keep B.
-             * If the lower shape (B) is empty, we still keep B, as it's empty:
-             *   A=0  =>  (B - 0) == B
-             *   B=0  =>  (0 - A) == 0 == B
-             *
-             * In any case, the output from this operation is stored in shape A, so we may apply
-             * the above rules simply by judicious use of swapping A and B where necessary.
-             */
-            bool zeroA = theShapeA->numberOfEdges() == 0;
-            bool zeroB = theShapeB->numberOfEdges() == 0;
-            if (zeroA || zeroB) {
-                // We might need to do a swap. Apply the above rules depending on operation type.
-                bool resultIsB =   ((bop == bool_op_union || bop == bool_op_symdiff) && zeroA)
-                                   || ((bop == bool_op_inters) && zeroB)
-                                   ||  (bop == bool_op_diff);
-                if (resultIsB) {
-                    // Swap A and B to use B as the result
-                    Shape *swap = theShapeB;
-                    theShapeB = theShapeA;
-                    theShapeA = swap;
-                }
-            } else {
-                // Just do the Boolean operation as usual
-                // les elements arrivent en ordre inverse dans la liste
-                theShape->Booleen(theShapeB, theShapeA, bop);
-                Shape *swap = theShape;
-                theShape = theShapeA;
-                theShapeA = swap;
-            }
-            curOrig++;
-        }
-
-        {
-            Shape *swap = theShape;
-            theShape = theShapeA;
-            theShapeA = swap;
-        }
+        std::vector<int> order(nbOriginaux);
+        std::iota(order.begin(), order.end(), 0);
+        delete theShape;
+        theShape = fold_shapes(bop, order, originaux, origWind, origThresh).release();
 
     } else if ( bop == bool_op_cut ) {
         // cuts= sort of a bastard boolean operation, thus not the axact same modus operandi
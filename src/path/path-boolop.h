@@ -29,6 +29,11 @@ Geom::PathVector sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::Path
 Geom::PathVector sp_pathvector_boolop(Geom::PathVector const &pathva, Geom::PathVector const &pathvb, BooleanOp bop,
                                       FillRule fra, FillRule frb, bool livarotonly = false, bool flattenbefore = true);
 
+/// Compute the union of many pathvectors, each filled with its own fill rule. Inputs whose
+/// bounding boxes are not connected by overlaps are processed concurrently on up to numthreads threads.
+Geom::PathVector sp_pathvector_union(std::vector<Geom::PathVector> const &pathvs, std::vector<FillRule> const &fill_rules,
+                                     int numthreads = 1);
+
 #endif // PATH_BOOLOP_H
 
 /*
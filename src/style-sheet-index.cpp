@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Index of the rules of a style cascade, for matching them against many nodes.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "style-sheet-index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <glib.h>
+
+#include "xml/node.h"
+
+namespace Inkscape {
+namespace {
+
+char const *str(CRString const *s)
+{
+    return s && s->stryng ? s->stryng->str : nullptr;
+}
+
+/// The local part of an element or type selector name, in lower case to be safe from case folding.
+std::string local_name(char const *name)
+{
+    for (auto sep : { ':', '|' }) {
+        if (auto p = std::strrchr(name, sep)) {
+            name = p + 1;
+        }
+    }
+    std::string result = name;
+    std::transform(result.begin(), result.end(), result.begin(), g_ascii_tolower);
+    return result;
+}
+
+/// The distinct class names of a node, sorted.
+std::vector<std::string_view> classes(XML::Node const *node)
+{
+    std::vector<std::string_view> result;
+    auto const attr = node->attribute("class");
+    if (!attr) {
+        return result;
+    }
+
+    std::string_view rest = attr;
+    while (true) {
+        auto const start = rest.find_first_not_of(" \t\r\n\f");
+        if (start == std::string_view::npos) {
+            break;
+        }
+        rest.remove_prefix(start);
+        auto const end = std::min(rest.find_first_of(" \t\r\n\f"), rest.size());
+        result.emplace_back(rest.substr(0, end));
+        rest.remove_prefix(end);
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+CRSimpleSel const *rightmost(CRSimpleSel const *sel)
+{
+    while (sel->next) {
+        sel = sel->next;
+    }
+    return sel;
+}
+
+} // namespace
+
+StyleSheetIndex::StyleSheetIndex(CRCascade *cascade)
+    : _cascade(cascade)
+{
+    for (int origin = ORIGIN_UA; origin < NB_ORIGINS; origin++) {
+        for (auto sheet = cr_cascade_get_sheet(cascade, static_cast<CRStyleOrigin>(origin)); sheet; sheet = sheet->next) {
+            _addSheet(sheet);
+        }
+    }
+}
+
+void StyleSheetIndex::_addSheet(CRStyleSheet const *sheet)
+{
+    for (auto stmt = sheet->statements; stmt; stmt = stmt->next) {
+        switch (stmt->type) {
+            case RULESET_STMT:
+                for (auto sel = stmt->kind.ruleset->sel_list; sel; sel = sel->next) {
+                    if (sel->simple_sel) {
+                        _addSelector(sel->simple_sel);
+                    }
+                }
+                break;
+            case AT_IMPORT_RULE_STMT:
+                if (stmt->kind.import_rule->sheet) {
+                    _addSheet(stmt->kind.import_rule->sheet);
+                }
+                break;
+            case AT_FONT_FACE_RULE_STMT:
+            case AT_CHARSET_RULE_STMT:
+                break; // Not matched against nodes.
+            default:
+                // Rules nested in other at-rules are not indexed, so any node may match them.
+                _universal.rules++;
+                _universal.simple = false;
+                break;
+        }
+    }
+}
+
+void StyleSheetIndex::_addSelector(CRSimpleSel const *sel)
+{
+    auto const last = rightmost(sel);
+    bool simple = last == sel; // No combinators.
+
+    char const *id = nullptr;
+    char const *class_name = nullptr;
+    for (auto add = last->add_sel; add; add = add->next) {
+        if (add->type == ID_ADD_SELECTOR) {
+            id = str(add->content.id_name);
+            simple = false;
+        } else if (add->type == CLASS_ADD_SELECTOR) {
+            if (!class_name) {
+                class_name = str(add->content.class_name);
+            }
+        } else {
+            simple = false; // Attribute selectors and pseudo-classes.
+        }
+    }
+
+    auto const name = (last->type_mask & TYPE_SELECTOR) ? str(last->name) : nullptr;
+
+    Bucket *bucket;
+    if (id) {
+        bucket = &_by_id[id];
+    } else if (class_name) {
+        bucket = &_by_class[class_name];
+    } else if (name && local_name(name) != "*") {
+        bucket = &_by_name[local_name(name)];
+    } else {
+        bucket = &_universal;
+    }
+    bucket->rules++;
+    bucket->simple = bucket->simple && simple;
+}
+
+StyleSheetIndex::PropList StyleSheetIndex::matchedProperties(CRSelEng *sel_eng, XML::Node const *node)
+{
+    auto const match = [&] {
+        CRPropList *props = nullptr;
+        auto const status = cr_sel_eng_get_matched_properties_from_cascade(sel_eng, _cascade, node, &props);
+        g_return_val_if_fail(status == CR_OK, PropList());
+        return props ? PropList(props, cr_prop_list_destroy) : PropList();
+    };
+
+    if (node->type() != XML::NodeType::ELEMENT_NODE) {
+        return match();
+    }
+
+    // Gather the buckets holding rules the node may match.
+    Bucket candidates = _universal;
+    auto const add = [&] (Util::StringMap<Bucket> const &map, std::string_view key) {
+        if (auto it = map.find(key); it != map.end()) {
+            candidates.rules += it->second.rules;
+            candidates.simple = candidates.simple && it->second.simple;
+        }
+    };
+    if (auto id = node->attribute("id")) {
+        add(_by_id, id);
+    }
+    auto const node_classes = classes(node);
+    for (auto class_name : node_classes) {
+        add(_by_class, class_name);
+    }
+    add(_by_name, local_name(node->name()));
+
+    if (!candidates.rules) {
+        return {};
+    }
+    if (!candidates.simple) {
+        return match();
+    }
+
+    // The result depends only on the element name and classes.
+    std::string signature = node->name();
+    for (auto class_name : node_classes) {
+        signature += ' ';
+        signature += class_name;
+    }
+    if (auto it = _cache.find(signature); it != _cache.end()) {
+        return it->second;
+    }
+    auto props = match();
+    _cache.emplace(std::move(signature), props);
+    return props;
+}
+
+bool StyleSheetIndex::mayMatch(CRSimpleSel const *sel, XML::Node const *node)
+{
+    if (node->type() != XML::NodeType::ELEMENT_NODE) {
+        return true; // Left to the selector engine.
+    }
+
+    auto const last = rightmost(sel);
+    std::vector<std::string_view> node_classes;
+    bool have_classes = false;
+    for (auto add = last->add_sel; add; add = add->next) {
+        if (add->type == ID_ADD_SELECTOR) {
+            auto const id = str(add->content.id_name);
+            auto const node_id = node->attribute("id");
+            if (id && (!node_id || std::strcmp(id, node_id) != 0)) {
+                return false;
+            }
+        } else if (add->type == CLASS_ADD_SELECTOR) {
+            auto const class_name = str(add->content.class_name);
+            if (!class_name) {
+                continue;
+            }
+            if (!have_classes) {
+                node_classes = classes(node);
+                have_classes = true;
+            }
+            if (!std::binary_search(node_classes.begin(), node_classes.end(), std::string_view(class_name))) {
+                return false;
+            }
+        }
+    }
+
+    if (last->type_mask & TYPE_SELECTOR) {
+        if (auto const name = str(last->name)) {
+            auto const sel_name = local_name(name);
+            if (sel_name != "*" && sel_name != local_name(node->name())) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Index of the rules of a style cascade, for matching them against many nodes.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef INKSCAPE_STYLE_SHEET_INDEX_H
+#define INKSCAPE_STYLE_SHEET_INDEX_H
+
+#include <memory>
+
+#include "3rdparty/libcroco/src/cr-sel-eng.h"
+#include "util/string-hash.h"
+
+namespace Inkscape {
+namespace XML { class Node; }
+
+/**
+ * The rules of a style cascade, bucketed by the id, class or element name that the rightmost
+ * compound of each selector requires, with a cache of matched properties.
+ *
+ * The properties matched for a node are those of cr_sel_eng_get_matched_properties_from_cascade(),
+ * which is only called when a bucket holds a rule the node could match. If all such rules depend
+ * only on the element name and classes, the result is cached by element name and class set, so
+ * nodes with the same ones share it.
+ *
+ * The index must be discarded when the cascade changes.
+ */
+class StyleSheetIndex
+{
+public:
+    using PropList = std::shared_ptr<CRPropList>;
+
+    explicit StyleSheetIndex(CRCascade *cascade);
+
+    /// The properties of the rules matching a node, in the order of the cascade, or null if none.
+    PropList matchedProperties(CRSelEng *sel_eng, XML::Node const *node);
+
+    /**
+     * Whether a node can match a selector, judging by the id, classes and element name that its
+     * rightmost compound requires. A quick test to make before cr_sel_eng_matches_node().
+     */
+    static bool mayMatch(CRSimpleSel const *sel, XML::Node const *node);
+
+private:
+    struct Bucket
+    {
+        unsigned rules = 0;
+        bool simple = true; ///< Whether all rules depend only on the element name and classes.
+    };
+
+    CRCascade *_cascade;
+    Util::StringMap<Bucket> _by_id;
+    Util::StringMap<Bucket> _by_class;
+    Util::StringMap<Bucket> _by_name;
+    Bucket _universal;
+    Util::StringMap<PropList> _cache;
+
+    void _addSheet(CRStyleSheet const *sheet);
+    void _addSelector(CRSimpleSel const *sel);
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_STYLE_SHEET_INDEX_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
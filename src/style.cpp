@@ -23,7 +23,9 @@
 #include "style.h"
 
 #include <cstring>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -33,6 +35,7 @@
 #include "bad-uri-exception.h"
 #include "document.h"
 #include "preferences.h"
+#include "style-sheet-index.h"
 
 #include "3rdparty/libcroco/src/cr-sel-eng.h"
 
@@ -74,7 +77,13 @@ class SPStylePropHelper {
     SPStylePropHelper() {
 #define REGISTER_PROPERTY(id, member, name) \
         g_assert(decltype(SPStyle::member)::static_id() == id); \
-        _register(reinterpret_cast<SPIBasePtr>(&SPStyle::member), id) /* name unused */
+        _register({[] (SPStyle &style) -> SPIBase & { return style.member; }, \
+                   [] (SPStyle const &style) -> SPIBase const & { return style.member; }, false}, id) /* name unused */
+
+#define REGISTER_FONT_VARIANT(id, member, name) \
+        g_assert(decltype(SPStyle::FontVariants::member)::static_id() == id); \
+        _register({[] (SPStyle &style) -> SPIBase & { return style.writableFontVariants().member; }, \
+                   [] (SPStyle const &style) -> SPIBase const & { return style.fontVariants().member; }, true}, id)
 
         // SVG 2: Attributes promoted to properties
         REGISTER_PROPERTY(SPAttr::D, d, "d");
@@ -95,16 +104,16 @@ class SPStylePropHelper {
         REGISTER_PROPERTY(SPAttr::INKSCAPE_FONT_SPEC, font_specification, "-inkscape-font-specification");
 
         // Font variants
-        REGISTER_PROPERTY(SPAttr::FONT_VARIANT_LIGATURES, font_variant_ligatures, "font-variant-ligatures");
-        REGISTER_PROPERTY(SPAttr::FONT_VARIANT_POSITION, font_variant_position, "font-variant-position");
-        REGISTER_PROPERTY(SPAttr::FONT_VARIANT_CAPS, font_variant_caps, "font-variant-caps");
-        REGISTER_PROPERTY(SPAttr::FONT_VARIANT_NUMERIC, font_variant_numeric, "font-variant-numeric");
-        REGISTER_PROPERTY(SPAttr::FONT_VARIANT_ALTERNATES, font_variant_alternates, "font-variant-alternates");
-        REGISTER_PROPERTY(SPAttr::FONT_VARIANT_EAST_ASIAN, font_variant_east_asian, "font-variant-east-asian");
-        REGISTER_PROPERTY(SPAttr::FONT_FEATURE_SETTINGS, font_feature_settings, "font-feature-settings");
+        REGISTER_FONT_VARIANT(SPAttr::FONT_VARIANT_LIGATURES, font_variant_ligatures, "font-variant-ligatures");
+        REGISTER_FONT_VARIANT(SPAttr::FONT_VARIANT_POSITION, font_variant_position, "font-variant-position");
+        REGISTER_FONT_VARIANT(SPAttr::FONT_VARIANT_CAPS, font_variant_caps, "font-variant-caps");
+        REGISTER_FONT_VARIANT(SPAttr::FONT_VARIANT_NUMERIC, font_variant_numeric, "font-variant-numeric");
+        REGISTER_FONT_VARIANT(SPAttr::FONT_VARIANT_ALTERNATES, font_variant_alternates, "font-variant-alternates");
+        REGISTER_FONT_VARIANT(SPAttr::FONT_VARIANT_EAST_ASIAN, font_variant_east_asian, "font-variant-east-asian");
+        REGISTER_FONT_VARIANT(SPAttr::FONT_FEATURE_SETTINGS, font_feature_settings, "font-feature-settings");
 
         // Variable Fonts
-        REGISTER_PROPERTY(SPAttr::FONT_VARIATION_SETTINGS, font_variation_settings, "font-variation-settings");
+        REGISTER_FONT_VARIANT(SPAttr::FONT_VARIATION_SETTINGS, font_variation_settings, "font-variation-settings");
 
         REGISTER_PROPERTY(SPAttr::TEXT_INDENT, text_indent, "text-indent");
         REGISTER_PROPERTY(SPAttr::TEXT_ALIGN, text_align, "text-align");
@@ -197,13 +206,37 @@ public:
         return _instance;
     }
 
+    /**
+     * A property member of styles
+     */
+    struct Member
+    {
+        /// Get it for changing. Shared members are first copied.
+        SPIBase &(*get)(SPStyle &style);
+        /// Get it for reading.
+        SPIBase const &(*get_const)(SPStyle const &style);
+        /// Whether it is in a block shared between styles.
+        bool shared;
+    };
+
     /**
      * Get property pointer by enum
      */
     SPIBase *get(SPStyle *style, SPAttr id) {
         auto it = m_id_map.find(id);
         if (it != m_id_map.end()) {
-            return _get(style, it->second);
+            return &it->second.get(*style);
+        }
+        return nullptr;
+    }
+
+    /**
+     * Get property pointer by enum, for reading
+     */
+    SPIBase const *get(SPStyle const *style, SPAttr id) {
+        auto it = m_id_map.find(id);
+        if (it != m_id_map.end()) {
+            return &it->second.get_const(*style);
         }
         return nullptr;
     }
@@ -215,36 +248,186 @@ public:
         return get(style, sp_attribute_lookup(name.c_str()));
     }
 
+    /**
+     * Get the ordered property members, shared by all styles
+     */
+    std::vector<Member> const &members() const { return m_vector; }
+
     /**
      * Get a vector of property pointers
-     * \todo provide iterator instead
      */
     std::vector<SPIBase *> get_vector(SPStyle *style) {
         std::vector<SPIBase *> v;
         v.reserve(m_vector.size());
-        for (auto ptr : m_vector) {
-            v.push_back(_get(style, ptr));
+        for (auto const &member : m_vector) {
+            v.push_back(&member.get(*style));
         }
         return v;
     }
 
 private:
-    SPIBase *_get(SPStyle *style, SPIBasePtr ptr) { return &(style->*ptr); }
-
-    void _register(SPIBasePtr ptr, SPAttr id) {
-        m_vector.push_back(ptr);
+    void _register(Member const &member, SPAttr id) {
+        m_vector.push_back(member);
 
         if (id != SPAttr::INVALID) {
-            m_id_map[id] = ptr;
+            m_id_map[id] = member;
         }
     }
 
-    std::unordered_map<SPAttr, SPIBasePtr> m_id_map;
-    std::vector<SPIBasePtr> m_vector;
+    std::unordered_map<SPAttr, Member> m_id_map;
+    std::vector<Member> m_vector;
 };
 
 auto &_prop_helper = SPStylePropHelper::instance();
 
+namespace {
+
+/// Whether two properties are in the same state, including where they were set.
+bool same_state(SPIBase const &a, SPIBase const &b)
+{
+    return a.set == b.set && a.inherit == b.inherit && a.important == b.important && a.style_src == b.style_src &&
+           a.equals(b);
+}
+
+template <typename T>
+bool same_state(SPIEnum<T> const &a, SPIEnum<T> const &b)
+{
+    return a.value == b.value && same_state(static_cast<SPIBase const &>(a), b);
+}
+
+/**
+ * The font variant blocks in use, so that styles with equal font variants can share one.
+ * Blocks remove themselves when the last style using them lets go.
+ */
+class FontVariantsPool
+{
+public:
+    using Block = SPStyle::FontVariants;
+
+    static FontVariantsPool &get()
+    {
+        static auto const pool = new FontVariantsPool(); // Never freed, as styles may outlive statics.
+        return *pool;
+    }
+
+    /// The block of a style with no font variants set.
+    std::shared_ptr<Block> const &unset() const { return _unset; }
+
+    /// Return the shared block equal to the given one, adding a copy of it if there is none.
+    std::shared_ptr<Block> intern(Block const &block)
+    {
+        auto const hash = block.hash();
+        std::vector<std::shared_ptr<Block>> seen; // Released after the lock, as they may remove themselves.
+        auto lock = std::lock_guard(_mutex);
+
+        auto [it, end] = _blocks.equal_range(hash);
+        for (; it != end; ++it) {
+            if (auto shared = it->second.second.lock()) {
+                if (*shared == block) {
+                    return shared;
+                }
+                seen.emplace_back(std::move(shared));
+            }
+        }
+
+        auto const copy = new Block(block);
+        auto shared = std::shared_ptr<Block>(copy, [this, hash] (Block *b) { _remove(hash, b); });
+        _blocks.emplace(hash, std::make_pair(copy, std::weak_ptr(shared)));
+        return shared;
+    }
+
+private:
+    FontVariantsPool()
+        : _unset(intern(Block()))
+    {}
+
+    void _remove(std::size_t hash, Block *block)
+    {
+        {
+            auto lock = std::lock_guard(_mutex);
+            auto [it, end] = _blocks.equal_range(hash);
+            for (; it != end; ++it) {
+                if (it->second.first == block) {
+                    _blocks.erase(it);
+                    break;
+                }
+            }
+        }
+        delete block;
+    }
+
+    std::mutex _mutex;
+    std::unordered_multimap<std::size_t, std::pair<Block *, std::weak_ptr<Block>>> _blocks;
+    std::shared_ptr<Block> _unset;
+};
+
+} // namespace
+
+std::array<SPIBase *, 8> SPStyle::FontVariants::members()
+{
+    return {&font_variant_ligatures, &font_variant_position, &font_variant_caps, &font_variant_numeric,
+            &font_variant_alternates, &font_variant_east_asian, &font_feature_settings, &font_variation_settings};
+}
+
+std::array<SPIBase const *, 8> SPStyle::FontVariants::members() const
+{
+    return {&font_variant_ligatures, &font_variant_position, &font_variant_caps, &font_variant_numeric,
+            &font_variant_alternates, &font_variant_east_asian, &font_feature_settings, &font_variation_settings};
+}
+
+bool SPStyle::FontVariants::operator==(FontVariants const &rhs) const
+{
+    return same_state(font_variant_ligatures, rhs.font_variant_ligatures) &&
+           same_state(font_variant_position, rhs.font_variant_position) &&
+           same_state(font_variant_caps, rhs.font_variant_caps) &&
+           same_state(font_variant_numeric, rhs.font_variant_numeric) &&
+           same_state(font_variant_alternates, rhs.font_variant_alternates) &&
+           same_state(font_variant_east_asian, rhs.font_variant_east_asian) &&
+           same_state(font_feature_settings, rhs.font_feature_settings) &&
+           same_state(font_variation_settings, rhs.font_variation_settings);
+}
+
+std::size_t SPStyle::FontVariants::hash() const
+{
+    std::size_t result = 0;
+    auto combine = [&] (std::size_t value) { result ^= value + 0x9e3779b9 + (result << 6) + (result >> 2); };
+
+    for (auto p : members()) {
+        combine(p->set | p->inherit << 1);
+    }
+    combine(font_variant_ligatures.computed);
+    combine(font_variant_position.computed);
+    combine(font_variant_caps.computed);
+    combine(font_variant_numeric.computed);
+    combine(font_variant_alternates.computed);
+    combine(font_variant_east_asian.computed);
+    if (auto const settings = font_feature_settings.value()) {
+        combine(std::hash<std::string_view>()(settings));
+    }
+    combine(font_variation_settings.axes.size());
+    return result;
+}
+
+SPStyle::FontVariants &SPStyle::writableFontVariants()
+{
+    if (_font_variants_shared || _font_variants.use_count() > 1) {
+        _font_variants = std::make_shared<FontVariants>(*_font_variants);
+        _font_variants_shared = false;
+    }
+    return *_font_variants;
+}
+
+/**
+ * Replace the font variants by the shared block equal to them.
+ */
+void SPStyle::_shareFontVariants()
+{
+    if (!_font_variants_shared) {
+        _font_variants = FontVariantsPool::get().intern(*_font_variants);
+        _font_variants_shared = true;
+    }
+}
+
 // C++11 allows one constructor to call another... might be useful. The original C code
 // had separate calls to create SPStyle, one with only SPDocument and the other with only
 // SPObject as parameters.
@@ -280,18 +463,6 @@ SPStyle::SPStyle(SPDocument *document_in, SPObject *object_in) :
     font(),                                                      // SPIFont
     font_specification(     ),              // SPIString
 
-    // Font variants (Features)
-    font_variant_ligatures( ),
-    font_variant_position(  SP_CSS_FONT_VARIANT_POSITION_NORMAL),
-    font_variant_caps(      SP_CSS_FONT_VARIANT_CAPS_NORMAL),
-    font_variant_numeric(   ),
-    font_variant_alternates(SP_CSS_FONT_VARIANT_ALTERNATES_NORMAL),
-    font_variant_east_asian(),
-    font_feature_settings(  ),
-
-    // Variable Fonts
-    font_variation_settings(),  // SPIFontVariationSettings
-
     // Text related properties
     text_indent(            ),  // SPILength
     text_align(             SP_CSS_TEXT_ALIGN_START),
@@ -381,7 +552,10 @@ SPStyle::SPStyle(SPDocument *document_in, SPObject *object_in) :
 
     // Stop color and opacity
     stop_color(             false),       // SPIColor, does not inherit
-    stop_opacity(           false)        // Does not inherit
+    stop_opacity(           false),       // Does not inherit
+
+    // Font variants (Features), and variable fonts, shared while unset
+    _font_variants(FontVariantsPool::get().unset())
 {
     // std::cout << "SPStyle::SPStyle( SPDocument ): Entrance" << std::endl;
     // std::cout << "                      Document: " << (document_in?"present":"null") << std::endl;
@@ -458,10 +632,6 @@ SPStyle::SPStyle(SPDocument *document_in, SPObject *object_in) :
     marker_ptrs[SP_MARKER_LOC_START] = &marker_start;
     marker_ptrs[SP_MARKER_LOC_MID]   = &marker_mid;
     marker_ptrs[SP_MARKER_LOC_END]   = &marker_end;
-
-
-    // This might be too resource hungary... but for now it possible to loop over properties
-    _properties = _prop_helper.get_vector(this);
 }
 
 SPStyle::~SPStyle() {
@@ -491,7 +661,7 @@ SPStyle::~SPStyle() {
     // std::cout << "SPStyle::~SPStyle(): Exit\n" << std::endl;
 }
 
-const std::vector<SPIBase *> SPStyle::properties() { return this->_properties; }
+const std::vector<SPIBase *> SPStyle::properties() { return _prop_helper.get_vector(this); }
 
 void
 SPStyle::clear(SPAttr id) {
@@ -505,9 +675,13 @@ SPStyle::clear(SPAttr id) {
 
 void
 SPStyle::clear() {
-    for (auto * p : _properties) {
-        p->clear();
+    for (auto const &member : _prop_helper.members()) {
+        if (!member.shared) {
+            member.get(*this).clear();
+        }
     }
+    _font_variants = FontVariantsPool::get().unset();
+    _font_variants_shared = true;
 
     // Release connection to object, created in constructor.
     release_connection.disconnect();
@@ -572,12 +746,15 @@ SPStyle::read( SPObject *object, Inkscape::XML::Node *repr ) {
     }
 
     /* 3 Presentation attributes */
-    for (auto * p : _properties) {
+    for (auto const &member : _prop_helper.members()) {
+        auto const &p = member.get_const(*this);
         // Shorthands are not allowed as presentation properties. Note: text-decoration and
         // font-variant are converted to shorthands in CSS 3 but can still be read as a
         // non-shorthand for compatibility with older renders, so they should not be in this list.
-        if (p->id() != SPAttr::FONT && p->id() != SPAttr::MARKER) {
-            p->readAttribute( repr );
+        if (p.id() != SPAttr::FONT && p.id() != SPAttr::MARKER &&
+            (!member.shared || repr->attribute(p.name().c_str()))) // Keep sharing if there is nothing to read.
+        {
+            member.get(*this).readAttribute( repr );
         }
     }
 
@@ -593,6 +770,8 @@ SPStyle::read( SPObject *object, Inkscape::XML::Node *repr ) {
         cascade( parent );
         delete parent;
     }
+
+    _shareFontVariants();
 }
 
 /**
@@ -718,7 +897,7 @@ bool SPStyle::isSet(SPAttr id)
             return color_interpolation.set;
     }
 
-    auto p = _prop_helper.get(this, id);
+    auto p = _prop_helper.get(static_cast<SPStyle const *>(this), id);
     if (p) {
         return p->set;
     } else {
@@ -754,12 +933,8 @@ SPStyle::write( guint const flags, SPStyleSrc const style_src_req, SPStyle const
     }
 
     Glib::ustring style_string;
-    for(std::vector<SPIBase*>::size_type i = 0; i != _properties.size(); ++i) {
-        if( base != nullptr ) {
-            style_string += _properties[i]->write( flags, style_src_req, base->_properties[i] );
-        } else {
-            style_string += _properties[i]->write( flags, style_src_req, nullptr );
-        }
+    for (auto const &member : _prop_helper.members()) {
+        style_string += member.get_const(*this).write(flags, style_src_req, base ? &member.get_const(*base) : nullptr);
     }
 
     // Extended properties. Cascading not supported.
@@ -814,8 +989,22 @@ Glib::ustring SPStyle::writeIfDiff(SPStyle const *base) const
 void
 SPStyle::cascade( SPStyle const *const parent ) {
     // std::cout << "SPStyle::cascade: " << (object->getId()?object->getId():"null") << std::endl;
-    for(std::vector<SPIBase*>::size_type i = 0; i != _properties.size(); ++i) {
-        _properties[i]->cascade( parent->_properties[i] );
+    for (auto const &member : _prop_helper.members()) {
+        if (!member.shared) {
+            member.get(*this).cascade(&member.get_const(*parent));
+        }
+    }
+
+    // Without any font variants here or above, the result is the same block. Otherwise, cascade a
+    // copy and share the block equal to it.
+    auto const &unset = FontVariantsPool::get().unset();
+    if (_font_variants != unset || parent->_font_variants != unset) {
+        auto const members = writableFontVariants().members();
+        auto const parent_members = parent->fontVariants().members();
+        for (std::size_t i = 0; i < members.size(); i++) {
+            members[i]->cascade(parent_members[i]);
+        }
+        _shareFontVariants();
     }
 }
 
@@ -840,8 +1029,20 @@ SPStyle::cascade( SPStyle const *const parent ) {
 void
 SPStyle::merge( SPStyle const *const parent ) {
     // std::cout << "SPStyle::merge" << std::endl;
-    for(std::vector<SPIBase*>::size_type i = 0; i != _properties.size(); ++i) {
-        _properties[i]->merge( parent->_properties[i] );
+    for (auto const &member : _prop_helper.members()) {
+        if (!member.shared) {
+            member.get(*this).merge(&member.get_const(*parent));
+        }
+    }
+
+    // Font variants that are not set in the parent leave these unchanged.
+    if (parent->_font_variants != FontVariantsPool::get().unset()) {
+        auto const members = writableFontVariants().members();
+        auto const parent_members = parent->fontVariants().members();
+        for (std::size_t i = 0; i < members.size(); i++) {
+            members[i]->merge(parent_members[i]);
+        }
+        _shareFontVariants();
     }
 }
 
@@ -881,16 +1082,15 @@ bool
 SPStyle::operator==(const SPStyle& rhs) const {
 
     // Uncomment for testing
-    // for(std::vector<SPIBase*>::size_type i = 0; i != _properties.size(); ++i) {
-    //     if( *_properties[i] != *rhs._properties[i])
-    //     std::cout << _properties[i]->name << ": "
-    //               << _properties[i]->write(SP_STYLE_FLAG_ALWAYS,NULL) << " " 
-    //               << rhs._properties[i]->write(SP_STYLE_FLAG_ALWAYS,NULL)
-    //               << (*_properties[i]  == *rhs._properties[i]) << std::endl;
+    // for (auto const &member : _prop_helper.members()) {
+    //     if (member.get_const(*this) != member.get_const(rhs))
+    //     std::cout << member.get_const(*this).name() << ": "
+    //               << member.get_const(*this).write(SP_STYLE_FLAG_ALWAYS) << " "
+    //               << member.get_const(rhs).write(SP_STYLE_FLAG_ALWAYS) << std::endl;
     // }
 
-    for(std::vector<SPIBase*>::size_type i = 0; i != _properties.size(); ++i) {
-        if( *_properties[i] != *rhs._properties[i]) return false;
+    for (auto const &member : _prop_helper.members()) {
+        if (member.get_const(*this) != member.get_const(rhs)) return false;
     }
     return true;
 }
@@ -994,19 +1194,9 @@ SPStyle::_mergeObjectStylesheet( SPObject const *const object, SPDocument *const
         _mergeObjectStylesheet(object, parent);
     }
 
-    CRPropList *props = nullptr;
-
     //XML Tree being directly used here while it shouldn't be.
-    CRStatus status =
-        cr_sel_eng_get_matched_properties_from_cascade(sel_eng,
-                                                       document->getStyleCascade(),
-                                                       object->getRepr(),
-                                                       &props);
-    g_return_if_fail(status == CR_OK);
-    /// \todo Check what errors can occur, and handle them properly.
-    if (props) {
-        _mergeProps(props);
-        cr_prop_list_destroy(props);
+    if (auto props = document->getStyleSheetIndex().matchedProperties(sel_eng, object->getRepr())) {
+        _mergeProps(props.get());
     }
 }
 
@@ -1014,17 +1204,18 @@ SPStyle::_mergeObjectStylesheet( SPObject const *const object, SPDocument *const
 std::string
 SPStyle::getFontFeatureString() {
 
+    auto const &fv = fontVariants();
     std::string feature_string;
-    if ( !(font_variant_ligatures.computed & SP_CSS_FONT_VARIANT_LIGATURES_COMMON) )
+    if ( !(fv.font_variant_ligatures.computed & SP_CSS_FONT_VARIANT_LIGATURES_COMMON) )
         feature_string += "liga 0, clig 0, ";
-    if (   font_variant_ligatures.computed & SP_CSS_FONT_VARIANT_LIGATURES_DISCRETIONARY )
+    if (   fv.font_variant_ligatures.computed & SP_CSS_FONT_VARIANT_LIGATURES_DISCRETIONARY )
         feature_string += "dlig, ";
-    if (   font_variant_ligatures.computed & SP_CSS_FONT_VARIANT_LIGATURES_HISTORICAL )
+    if (   fv.font_variant_ligatures.computed & SP_CSS_FONT_VARIANT_LIGATURES_HISTORICAL )
         feature_string += "hlig, ";
-    if ( !(font_variant_ligatures.computed & SP_CSS_FONT_VARIANT_LIGATURES_CONTEXTUAL) )
+    if ( !(fv.font_variant_ligatures.computed & SP_CSS_FONT_VARIANT_LIGATURES_CONTEXTUAL) )
         feature_string += "calt 0, ";
 
-    switch (font_variant_position.computed) {
+    switch (fv.font_variant_position.computed) {
         case SP_CSS_FONT_VARIANT_POSITION_SUB:
             feature_string += "subs, ";
             break;
@@ -1032,7 +1223,7 @@ SPStyle::getFontFeatureString() {
             feature_string += "sups, ";
     }
 
-    switch (font_variant_caps.computed) {
+    switch (fv.font_variant_caps.computed) {
         case SP_CSS_FONT_VARIANT_CAPS_SMALL:
             feature_string += "smcp, ";
             break;
@@ -1052,43 +1243,43 @@ SPStyle::getFontFeatureString() {
             feature_string += "titl, ";
     }
 
-    if ( font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_LINING_NUMS )
+    if ( fv.font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_LINING_NUMS )
         feature_string += "lnum, ";
-    if ( font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_OLDSTYLE_NUMS )
+    if ( fv.font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_OLDSTYLE_NUMS )
         feature_string += "onum, ";
-    if ( font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_PROPORTIONAL_NUMS )
+    if ( fv.font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_PROPORTIONAL_NUMS )
         feature_string += "pnum, ";
-    if ( font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_TABULAR_NUMS )
+    if ( fv.font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_TABULAR_NUMS )
         feature_string += "tnum, ";
-    if ( font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_DIAGONAL_FRACTIONS )
+    if ( fv.font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_DIAGONAL_FRACTIONS )
         feature_string += "frac, ";
-    if ( font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_STACKED_FRACTIONS )
+    if ( fv.font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_STACKED_FRACTIONS )
         feature_string += "afrc, ";
-    if ( font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_ORDINAL )
+    if ( fv.font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_ORDINAL )
         feature_string += "ordn, ";
-    if ( font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_SLASHED_ZERO )
+    if ( fv.font_variant_numeric.computed & SP_CSS_FONT_VARIANT_NUMERIC_SLASHED_ZERO )
         feature_string += "zero, ";
 
-    if( font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_JIS78 )
+    if( fv.font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_JIS78 )
         feature_string += "jp78, ";
-    if( font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_JIS83 )
+    if( fv.font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_JIS83 )
         feature_string += "jp83, ";
-    if( font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_JIS90 )
+    if( fv.font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_JIS90 )
         feature_string += "jp90, ";
-    if( font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_JIS04 )
+    if( fv.font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_JIS04 )
         feature_string += "jp04, ";
-    if( font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_SIMPLIFIED )
+    if( fv.font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_SIMPLIFIED )
         feature_string += "smpl, ";
-    if( font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_TRADITIONAL )
+    if( fv.font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_TRADITIONAL )
         feature_string += "trad, ";
-    if( font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_FULL_WIDTH )
+    if( fv.font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_FULL_WIDTH )
         feature_string += "fwid, ";
-    if( font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_PROPORTIONAL_WIDTH )
+    if( fv.font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_PROPORTIONAL_WIDTH )
         feature_string += "pwid, ";
-    if( font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_RUBY )
+    if( fv.font_variant_east_asian.computed & SP_CSS_FONT_VARIANT_EAST_ASIAN_RUBY )
         feature_string += "ruby, ";
 
-    char const *val = font_feature_settings.value();
+    char const *val = fv.font_feature_settings.value();
     if (val[0] && strcmp(val, "normal")) {
         // We do no sanity checking...
         feature_string += val;
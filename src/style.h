@@ -22,8 +22,10 @@
 #include "style-internal.h"
 
 #include <sigc++/connection.h>
+#include <array>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "3rdparty/libcroco/src/cr-declaration.h"
@@ -86,9 +88,6 @@ public:
     SPDocument *document;
 
 private:
-    /// Pointers to all the properties (for looping through them)
-    std::vector<SPIBase *> _properties;
-
     // Shorthand for better readability
     template <SPAttr Id, class Base>
     using T = TypedSPI<Id, Base>;
@@ -124,23 +123,44 @@ public:
     T<SPAttr::INKSCAPE_FONT_SPEC, SPIString> font_specification;
 
     /* Font variants -------------------- */
-    /** Font variant ligatures */
-    T<SPAttr::FONT_VARIANT_LIGATURES, SPILigatures> font_variant_ligatures;
-    /** Font variant position (subscript/superscript) */
-    T<SPAttr::FONT_VARIANT_POSITION, SPIEnum<SPCSSFontVariantPosition>> font_variant_position;
-    /** Font variant caps (small caps) */
-    T<SPAttr::FONT_VARIANT_CAPS, SPIEnum<SPCSSFontVariantCaps>> font_variant_caps;
-    /** Font variant numeric (numerical formatting) */
-    T<SPAttr::FONT_VARIANT_NUMERIC, SPINumeric> font_variant_numeric;
-    /** Font variant alternates (alternates/swatches) */
-    T<SPAttr::FONT_VARIANT_ALTERNATES, SPIEnum<SPCSSFontVariantAlternates>> font_variant_alternates;
-    /** Font variant East Asian */
-    T<SPAttr::FONT_VARIANT_EAST_ASIAN, SPIEastAsian> font_variant_east_asian;
-    /** Font feature settings (Low level access to TrueType tables) */
-    T<SPAttr::FONT_FEATURE_SETTINGS, SPIString> font_feature_settings;
-
-    /** Font variation settings (Low level access to OpenType variable font design-coordinate values) */
-    T<SPAttr::FONT_VARIATION_SETTINGS, SPIFontVariationSettings> font_variation_settings;
+
+    /**
+     * The font variant properties. Few objects set any of them, so styles with equal values share
+     * one immutable block. cascade() and merge() look up the shared block for their result.
+     * Other property families, such as fill and stroke, are still plain members.
+     */
+    struct FontVariants
+    {
+        /** Font variant ligatures */
+        T<SPAttr::FONT_VARIANT_LIGATURES, SPILigatures> font_variant_ligatures;
+        /** Font variant position (subscript/superscript) */
+        T<SPAttr::FONT_VARIANT_POSITION, SPIEnum<SPCSSFontVariantPosition>> font_variant_position{SP_CSS_FONT_VARIANT_POSITION_NORMAL};
+        /** Font variant caps (small caps) */
+        T<SPAttr::FONT_VARIANT_CAPS, SPIEnum<SPCSSFontVariantCaps>> font_variant_caps{SP_CSS_FONT_VARIANT_CAPS_NORMAL};
+        /** Font variant numeric (numerical formatting) */
+        T<SPAttr::FONT_VARIANT_NUMERIC, SPINumeric> font_variant_numeric;
+        /** Font variant alternates (alternates/swatches) */
+        T<SPAttr::FONT_VARIANT_ALTERNATES, SPIEnum<SPCSSFontVariantAlternates>> font_variant_alternates{SP_CSS_FONT_VARIANT_ALTERNATES_NORMAL};
+        /** Font variant East Asian */
+        T<SPAttr::FONT_VARIANT_EAST_ASIAN, SPIEastAsian> font_variant_east_asian;
+        /** Font feature settings (Low level access to TrueType tables) */
+        T<SPAttr::FONT_FEATURE_SETTINGS, SPIString> font_feature_settings;
+
+        /** Font variation settings (Low level access to OpenType variable font design-coordinate values) */
+        T<SPAttr::FONT_VARIATION_SETTINGS, SPIFontVariationSettings> font_variation_settings;
+
+        std::array<SPIBase *, 8> members();
+        std::array<SPIBase const *, 8> members() const;
+
+        /// Whether every property is in the same state, including where it was set.
+        bool operator==(FontVariants const &rhs) const;
+        std::size_t hash() const;
+    };
+
+    /// The font variant properties, for reading.
+    FontVariants const &fontVariants() const { return *_font_variants; }
+    /// The font variant properties, for changing. Copies them first if they are shared.
+    FontVariants &writableFontVariants();
 
     /* Text ----------------------------- */
 
@@ -357,6 +377,12 @@ public:
 
     /* ----------------------- EXTENDED PROPERTIES ------------------------- */
     std::map<std::string, std::string> extended_properties;
+
+private:
+    std::shared_ptr<FontVariants> _font_variants;
+    bool _font_variants_shared = true; ///< Whether _font_variants is interned, so must not be changed.
+
+    void _shareFontVariants();
 };
 
 void sp_style_set_to_uri(SPStyle *style, bool isfill, Inkscape::URI const *uri); // ?
@@ -14,6 +14,7 @@
  * is provided by the generosity of Peter Selinger, to whom we are grateful.
  *
  */
+#include <algorithm>
 #include <iomanip>
 #include <thread>
 #include <glibmm/i18n.h>
@@ -38,7 +39,7 @@ DepixelizeTracingEngine::DepixelizeTracingEngine(TraceType traceType, double cur
     params.sparsePixelsRadius = sparsePixels;
     params.sparsePixelsMultiplier = sparseMultiplier;
     params.optimize = optimize;
-    params.nthreads = Inkscape::Preferences::get()->getIntLimited("/options/threading/numthreads", std::thread::hardware_concurrency(), 1, 256);
+    params.nthreads = Inkscape::Preferences::get()->getIntLimited("/options/threading/numthreads", std::max(std::thread::hardware_concurrency(), 1u), 1, 256);
 }
 
 TraceResult DepixelizeTracingEngine::trace(Glib::RefPtr<Gdk::Pixbuf> const &pixbuf, Async::Progress<double> &progress)
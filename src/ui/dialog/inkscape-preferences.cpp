@@ -2500,6 +2500,10 @@ void InkscapePreferences::initPageBehavior()
     _page_behavior.add_line( false, _("_Simplification threshold:"), _misc_simpl, "",
                            _("How strong is the Node tool's Simplify command by default. If you invoke this command several times in quick succession, it will act more and more aggressively; invoking it again after a pause restores the default threshold."), false);
 
+    _misc_undo_memory.init("/options/undo/memorylimit", 0.0, 65536.0, 1.0, 64.0, 0.0, true, false);
+    _page_behavior.add_line( false, _("_Undo history memory limit:"), _misc_undo_memory, C_("mebibyte (2^20 bytes) abbreviation","MiB"),
+                           _("Set the amount of memory per document which the undo history may use; the oldest steps are forgotten when it grows beyond this. Set to zero for no limit."), false);
+
     _markers_color_stock.init ( _("Color stock markers the same color as object"), "/options/markers/colorStockMarkers", true);
     _markers_color_custom.init ( _("Color custom markers the same color as object"), "/options/markers/colorCustomMarkers", false);
     _markers_color_update.init ( _("Update marker color when object color changes"), "/options/markers/colorUpdateMarkers", true);
@@ -2916,6 +2920,9 @@ void InkscapePreferences::initPageRendering()
     _page_rendering.add_line(false, "", _cairo_dithering, "",  _("Makes gradients smoother. This can significantly impact the size of generated PNG files."));
 #endif
 
+    _rendering_level_of_detail.init(_("Simplify tiny objects"), "/options/rendering/levelofdetail", true);
+    _page_rendering.add_line(false, "", _rendering_level_of_detail, "", _("Draws objects smaller than a pixel as a dot of their average color, which speeds up zoomed out display of large drawings (export always draws them exactly)"));
+
     auto const grid = Gtk::make_managed<Gtk::Grid>();
     grid->property_margin().set_value(12);
     grid->set_orientation(Gtk::ORIENTATION_VERTICAL);
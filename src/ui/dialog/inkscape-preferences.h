@@ -355,6 +355,7 @@ protected:
 #if CAIRO_VERSION >= CAIRO_VERSION_ENCODE(1, 18, 0)
     UI::Widget::PrefCheckButton _cairo_dithering;
 #endif
+    UI::Widget::PrefCheckButton _rendering_level_of_detail;
 
     UI::Widget::PrefCheckButton _canvas_developer_mode_enabled;
     UI::Widget::PrefSpinButton  _canvas_tile_size;
@@ -436,6 +437,7 @@ protected:
 
     // System page
     UI::Widget::PrefSpinButton  _misc_simpl;
+    UI::Widget::PrefSpinButton  _misc_undo_memory;
     Gtk::Entry                  _sys_user_prefs;
     Gtk::Entry                  _sys_tmp_files;
     Gtk::Entry                  _sys_extension_dir;
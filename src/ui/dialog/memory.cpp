@@ -23,6 +23,7 @@
 #include <gtkmm/treeview.h>
 
 #include "debug/heap.h"
+#include "document-undo.h"
 #include "inkgc/gc-core.h"
 #include "ui/dialog/memory.h"
 #include "ui/pack.h"
@@ -66,6 +67,8 @@ struct Memory::Private {
     Gtk::TreeView view;
 
     sigc::connection update_task;
+
+    SPDocument *document = nullptr;
 };
 
 void Memory::Private::update() {
@@ -143,6 +146,20 @@ void Memory::Private::update() {
 
     ++row;
 
+    // The undo history is part of the heaps above, so it is not added to the combined total.
+    if (document) {
+        if ( row == model->children().end() ) {
+            row = model->append();
+        }
+
+        row->set_value(columns.name, Glib::ustring(_("Undo history")));
+        row->set_value(columns.used, format_size(DocumentUndo::getUndoMemory(document)));
+        row->set_value(columns.slack, Glib::ustring());
+        row->set_value(columns.total, Glib::ustring());
+
+        ++row;
+    }
+
     while ( row != model->children().end() ) {
         row = model->erase(row);
     }
@@ -191,6 +208,12 @@ Memory::~Memory()
     _private->stop_update_task();
 }
 
+void Memory::documentReplaced()
+{
+    _private->document = getDocument();
+    _private->update();
+}
+
 void Memory::apply()
 {
     GC::Core::gcollect();
@@ -29,6 +29,8 @@ protected:
     void apply();
 
 private:
+    void documentReplaced() override;
+
     struct Private;
     std::unique_ptr<Private> _private;
 };
@@ -16,8 +16,12 @@
 
 #include <algorithm> // Sort
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <deque>
 #include <iostream> // Logging
+#include <memory>
 #include <mutex>
 #include <set> // Coarsener
 #include <stdexcept>
@@ -171,7 +175,7 @@ struct RedrawData
     bool debug_show_redraw;
 
     // State
-    std::mutex mutex;
+    std::mutex mutex; // Guards the updater and everything below except the tile queues.
     gint64 start_time;
     int numactive;
     int phase;
@@ -181,9 +185,18 @@ struct RedrawData
     Cairo::RefPtr<Cairo::Region> clean;
     bool interruptible;
     bool preemptible;
-    std::vector<Geom::IntRect> rects;
     int effective_tile_size;
 
+    // Tiles still to be rendered in the current cycle, one queue per render thread, each ordered by distance from mouse.
+    // A thread that empties its own queue steals from the others, so the shared mutex is only taken once per tile.
+    struct TileQueue
+    {
+        std::mutex mutex;
+        std::deque<Geom::IntRect> rects;
+    };
+    std::unique_ptr<TileQueue[]> queues;
+    std::atomic<int> queued; // Total size of the queues. Only increases under the shared mutex.
+
     // Results
     std::mutex tiles_mutex;
     std::vector<Tile> tiles;
@@ -193,7 +206,7 @@ struct RedrawData
     auto getcmp() const
     {
         return [mouse_loc = mouse_loc] (Geom::IntRect const &a, Geom::IntRect const &b) {
-            return a.distanceSq(mouse_loc) > b.distanceSq(mouse_loc);
+            return a.distanceSq(mouse_loc) < b.distanceSq(mouse_loc);
         };
     }
 };
@@ -289,6 +302,7 @@ public:
     bool end_redraw(); // returns true to indicate further redraw cycles required
     void process_redraw(Geom::IntRect const &bounds, Cairo::RefPtr<Cairo::Region> clean, bool interruptible = true, bool preemptible = true);
     void render_tile(int debug_id);
+    std::optional<Geom::IntRect> take_rect(int debug_id);
     void paint_rect(Geom::IntRect const &rect);
     void paint_single_buffer(const Cairo::RefPtr<Cairo::ImageSurface> &surface, const Geom::IntRect &rect, bool need_background, bool outline_pass);
     void paint_error_buffer(const Cairo::RefPtr<Cairo::ImageSurface> &surface);
@@ -718,7 +732,10 @@ void CanvasPrivate::after_redraw()
         redraw_requested = false;
         launch_redraw();
     } else {
-        if (prefs.debug_logging) std::cout << "Redraw exit" << std::endl;
+        if (prefs.debug_logging) {
+            auto const stats = q->_drawing->takeFilterCacheStats();
+            std::cout << "Redraw exit (filter cache: " << stats.hits << " hits, " << stats.misses << " misses)" << std::endl;
+        }
         redraw_active = false;
     }
 }
@@ -2104,6 +2121,8 @@ void CanvasPrivate::init_tiler()
     rd.start_time = g_get_monotonic_time();
     rd.phase = 0;
     rd.vis_store = (rd.visible & rd.store.rect).regularized();
+    rd.queues = std::make_unique<RedrawData::TileQueue[]>(rd.numthreads);
+    rd.queued = 0;
 
     if (!init_redraw()) {
         sync.signalExit();
@@ -2124,7 +2143,7 @@ void CanvasPrivate::init_tiler()
 
 bool CanvasPrivate::init_redraw()
 {
-    assert(rd.rects.empty());
+    assert(rd.queued == 0);
 
     switch (rd.phase) {
         case 0:
@@ -2194,57 +2213,22 @@ void CanvasPrivate::process_redraw(Geom::IntRect const &bounds, Cairo::RefPtr<Ca
     auto region = Cairo::Region::create(geom_to_cairo(rd.bounds));
     region->subtract(rd.clean);
 
-    // Get the list of rectangles to paint, coarsened to avoid fragmentation.
-    rd.rects = coarsen(region,
-                       std::min<int>(rd.coarsener_min_size, rd.tile_size / 2),
-                       std::min<int>(rd.coarsener_glue_size, rd.tile_size / 2),
-                       rd.coarsener_min_fullness);
-
-    // Put the rectangles into a heap sorted by distance from mouse.
-    std::make_heap(rd.rects.begin(), rd.rects.end(), rd.getcmp());
-
     // Adjust the effective tile size proportional to the painting area.
     double adjust = (double)cairo_to_geom(region->get_extents()).maxExtent() / rd.visible.maxExtent();
     adjust = std::clamp(adjust, 0.3, 1.0);
     rd.effective_tile_size = rd.tile_size * adjust;
-}
-
-// Process rectangles until none left or timed out.
-void CanvasPrivate::render_tile(int debug_id)
-{
-    rd.mutex.lock();
 
-    std::string fc_str;
-    FrameCheck::Event fc;
-    if (rd.debug_framecheck) {
-        fc_str = "render_thread_" + std::to_string(debug_id + 1);
-        fc = FrameCheck::Event(fc_str.c_str());
-    }
-
-    while (true) {
-        // If we've run out of rects, try to start a new redraw cycle.
-        if (rd.rects.empty()) {
-            if (end_redraw()) {
-                // More redraw cycles to do.
-                continue;
-            } else {
-                // All finished.
-                break;
-            }
-        }
-
-        // Check for cancellation.
-        auto const flags = abort_flags.load(std::memory_order_relaxed);
-        bool const soft = flags & (int)AbortFlags::Soft;
-        bool const hard = flags & (int)AbortFlags::Hard;
-        if (hard || (rd.phase == 3 && soft)) {
-            break;
-        }
+    // Get the list of rectangles to paint, coarsened to avoid fragmentation.
+    auto rects = coarsen(region,
+                         std::min<int>(rd.coarsener_min_size, rd.tile_size / 2),
+                         std::min<int>(rd.coarsener_glue_size, rd.tile_size / 2),
+                         rd.coarsener_min_fullness);
 
-        // Extract the closest rectangle to the mouse.
-        std::pop_heap(rd.rects.begin(), rd.rects.end(), rd.getcmp());
-        auto rect = rd.rects.back();
-        rd.rects.pop_back();
+    // Bisect them into tiles.
+    std::vector<Geom::IntRect> tiles;
+    while (!rects.empty()) {
+        auto rect = rects.back();
+        rects.pop_back();
 
         // Cull empty rectangles.
         if (rect.hasZeroArea()) {
@@ -2257,42 +2241,97 @@ void CanvasPrivate::render_tile(int debug_id)
             continue;
         }
 
-        // Lambda to add a rectangle to the heap.
-        auto add_rect = [&] (Geom::IntRect const &rect) {
-            rd.rects.emplace_back(rect);
-            std::push_heap(rd.rects.begin(), rd.rects.end(), rd.getcmp());
-        };
-
-        // If the rectangle needs bisecting, bisect it and put it back on the heap.
         if (auto axis = bisect(rect, rd.effective_tile_size)) {
             int mid = rect[*axis].middle();
-            auto lo = rect; lo[*axis].setMax(mid); add_rect(lo);
-            auto hi = rect; hi[*axis].setMin(mid); add_rect(hi);
+            auto lo = rect; lo[*axis].setMax(mid); rects.emplace_back(lo);
+            auto hi = rect; hi[*axis].setMin(mid); rects.emplace_back(hi);
             continue;
         }
 
+        tiles.emplace_back(rect);
+    }
+
+    // Deal the tiles out to the render threads in equal wedges around the mouse, so that each thread works
+    // through a contiguous part of the canvas, and within each wedge, order them by distance from the mouse.
+    auto const angle = [this] (Geom::IntRect const &rect) {
+        auto const d = rect.midpoint() - rd.mouse_loc;
+        return std::atan2(d.y(), d.x());
+    };
+    std::sort(tiles.begin(), tiles.end(), [&] (Geom::IntRect const &a, Geom::IntRect const &b) { return angle(a) < angle(b); });
+
+    for (int i = 0; i < rd.numthreads; i++) {
+        auto const first = tiles.begin() + tiles.size() * i / rd.numthreads;
+        auto const last = tiles.begin() + tiles.size() * (i + 1) / rd.numthreads;
+        std::sort(first, last, rd.getcmp());
+
         // Extend thin rectangles at the edge of the bounds rect to at least some minimum size, being sure to keep them within the store.
         // (This ensures we don't end up rendering one thin rectangle at the edge every frame while the view is moved continuously.)
         if (rd.preemptible) {
-            if (rect.width() < rd.preempt) {
-                if (rect.left()  == rd.bounds.left() ) rect.setLeft (std::max(rect.right() - rd.preempt, rd.store.rect.left() ));
-                if (rect.right() == rd.bounds.right()) rect.setRight(std::min(rect.left()  + rd.preempt, rd.store.rect.right()));
+            for (auto rect = first; rect != last; ++rect) {
+                if (rect->width() < rd.preempt) {
+                    if (rect->left()  == rd.bounds.left() ) rect->setLeft (std::max(rect->right() - rd.preempt, rd.store.rect.left() ));
+                    if (rect->right() == rd.bounds.right()) rect->setRight(std::min(rect->left()  + rd.preempt, rd.store.rect.right()));
+                }
+                if (rect->height() < rd.preempt) {
+                    if (rect->top()    == rd.bounds.top()   ) rect->setTop   (std::max(rect->bottom() - rd.preempt, rd.store.rect.top()   ));
+                    if (rect->bottom() == rd.bounds.bottom()) rect->setBottom(std::min(rect->top()    + rd.preempt, rd.store.rect.bottom()));
+                }
             }
-            if (rect.height() < rd.preempt) {
-                if (rect.top()    == rd.bounds.top()   ) rect.setTop   (std::max(rect.bottom() - rd.preempt, rd.store.rect.top()   ));
-                if (rect.bottom() == rd.bounds.bottom()) rect.setBottom(std::min(rect.top()    + rd.preempt, rd.store.rect.bottom()));
+        }
+
+        auto &queue = rd.queues[i];
+        auto lock = std::lock_guard(queue.mutex);
+        queue.rects.insert(queue.rects.end(), first, last);
+        rd.queued += last - first;
+    }
+}
+
+// Process rectangles until none left or timed out.
+void CanvasPrivate::render_tile(int debug_id)
+{
+    auto lock = std::unique_lock(rd.mutex);
+
+    std::string fc_str;
+    FrameCheck::Event fc;
+    if (rd.debug_framecheck) {
+        fc_str = "render_thread_" + std::to_string(debug_id + 1);
+        fc = FrameCheck::Event(fc_str.c_str());
+    }
+
+    while (true) {
+        // Check for cancellation.
+        auto const flags = abort_flags.load(std::memory_order_relaxed);
+        bool const soft = flags & (int)AbortFlags::Soft;
+        bool const hard = flags & (int)AbortFlags::Hard;
+        if (hard || (rd.phase == 3 && soft)) {
+            break;
+        }
+
+        // Take the next rectangle, from our own queue if possible.
+        lock.unlock();
+        auto const rect = take_rect(debug_id);
+        lock.lock();
+
+        // If we've run out of rects, try to start a new redraw cycle, unless another thread has just done so.
+        if (!rect) {
+            if (rd.queued > 0 || end_redraw()) {
+                // More redraw cycles to do.
+                continue;
+            } else {
+                // All finished.
+                break;
             }
         }
 
         // Mark the rectangle as clean.
-        updater->mark_clean(rect);
+        updater->mark_clean(*rect);
 
-        rd.mutex.unlock();
+        lock.unlock();
 
         // Paint the rectangle.
-        paint_rect(rect);
+        paint_rect(*rect);
 
-        rd.mutex.lock();
+        lock.lock();
 
         // Check for timeout.
         if (rd.interruptible) {
@@ -2313,14 +2352,68 @@ void CanvasPrivate::render_tile(int debug_id)
     rd.numactive--;
     bool const done = rd.numactive == 0;
 
-    rd.mutex.unlock();
+    lock.unlock();
 
     if (done) {
-        rd.rects.clear();
+        for (int i = 0; i < rd.numthreads; i++) {
+            rd.queues[i].rects.clear();
+        }
+        rd.queued = 0;
         sync.signalExit();
     }
 }
 
+// Pop the closest rectangle to the mouse from a thread's own queue, or failing that, steal one from the queue with the most
+// work left. Returns nothing once all the queues are empty. Called without holding the shared mutex.
+std::optional<Geom::IntRect> CanvasPrivate::take_rect(int debug_id)
+{
+    auto pop = [this] (RedrawData::TileQueue &queue) -> std::optional<Geom::IntRect> {
+        auto lock = std::lock_guard(queue.mutex);
+        if (queue.rects.empty()) {
+            return {};
+        }
+        auto const rect = queue.rects.front();
+        queue.rects.pop_front();
+        rd.queued--;
+        return rect;
+    };
+
+    if (auto rect = pop(rd.queues[debug_id])) {
+        return rect;
+    }
+
+    // Time spent looking for work is logged as stealing (subtype 0) if it finds some, and idling (subtype 1) if not.
+    std::string fc_str;
+    FrameCheck::Event fc;
+    if (rd.debug_framecheck) {
+        fc_str = "render_steal_" + std::to_string(debug_id + 1);
+        fc = FrameCheck::Event(fc_str.c_str(), 1);
+    }
+
+    while (rd.queued > 0) {
+        int victim = -1;
+        std::size_t most = 0;
+        for (int i = 0; i < rd.numthreads; i++) {
+            auto lock = std::lock_guard(rd.queues[i].mutex);
+            if (rd.queues[i].rects.size() > most) {
+                most = rd.queues[i].rects.size();
+                victim = i;
+            }
+        }
+
+        if (victim == -1) {
+            break;
+        }
+
+        if (auto rect = pop(rd.queues[victim])) {
+            fc.subtype = 0;
+            return rect;
+        }
+    }
+
+    return {};
+}
+
 bool CanvasPrivate::end_redraw()
 {
     switch (rd.phase) {
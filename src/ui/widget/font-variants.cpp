@@ -595,8 +595,8 @@ FontVariants::update( SPStyle const *query, bool different_features, Glib::ustri
 
     update_opentype( font_spec );
 
-    _ligatures_all = query->font_variant_ligatures.computed;
-    _ligatures_mix = query->font_variant_ligatures.value;
+    _ligatures_all = query->fontVariants().font_variant_ligatures.computed;
+    _ligatures_mix = query->fontVariants().font_variant_ligatures.value;
 
     _ligatures_common.set_active(       _ligatures_all & SP_CSS_FONT_VARIANT_LIGATURES_COMMON );
     _ligatures_discretionary.set_active(_ligatures_all & SP_CSS_FONT_VARIANT_LIGATURES_DISCRETIONARY );
@@ -608,8 +608,8 @@ FontVariants::update( SPStyle const *query, bool different_features, Glib::ustri
     _ligatures_historical.set_inconsistent(    _ligatures_mix & SP_CSS_FONT_VARIANT_LIGATURES_HISTORICAL );
     _ligatures_contextual.set_inconsistent(    _ligatures_mix & SP_CSS_FONT_VARIANT_LIGATURES_CONTEXTUAL );
 
-    _position_all = query->font_variant_position.computed;
-    _position_mix = query->font_variant_position.value;
+    _position_all = query->fontVariants().font_variant_position.computed;
+    _position_mix = query->fontVariants().font_variant_position.value;
     
     _position_normal.set_active( _position_all & SP_CSS_FONT_VARIANT_POSITION_NORMAL );
     _position_sub.set_active(    _position_all & SP_CSS_FONT_VARIANT_POSITION_SUB );
@@ -619,8 +619,8 @@ FontVariants::update( SPStyle const *query, bool different_features, Glib::ustri
     _position_sub.set_inconsistent(    _position_mix & SP_CSS_FONT_VARIANT_POSITION_SUB );
     _position_super.set_inconsistent(  _position_mix & SP_CSS_FONT_VARIANT_POSITION_SUPER );
 
-    _caps_all = query->font_variant_caps.computed;
-    _caps_mix = query->font_variant_caps.value;
+    _caps_all = query->fontVariants().font_variant_caps.computed;
+    _caps_mix = query->fontVariants().font_variant_caps.value;
 
     _caps_normal.set_active(     _caps_all & SP_CSS_FONT_VARIANT_CAPS_NORMAL );
     _caps_small.set_active(      _caps_all & SP_CSS_FONT_VARIANT_CAPS_SMALL );
@@ -638,8 +638,8 @@ FontVariants::update( SPStyle const *query, bool different_features, Glib::ustri
     _caps_unicase.set_inconsistent(    _caps_mix & SP_CSS_FONT_VARIANT_CAPS_UNICASE );
     _caps_titling.set_inconsistent(    _caps_mix & SP_CSS_FONT_VARIANT_CAPS_TITLING );
 
-    _numeric_all = query->font_variant_numeric.computed;
-    _numeric_mix = query->font_variant_numeric.value;
+    _numeric_all = query->fontVariants().font_variant_numeric.computed;
+    _numeric_mix = query->fontVariants().font_variant_numeric.value;
 
     if (_numeric_all & SP_CSS_FONT_VARIANT_NUMERIC_LINING_NUMS) {
         _numeric_lining.set_active();
@@ -678,8 +678,8 @@ FontVariants::update( SPStyle const *query, bool different_features, Glib::ustri
     _numeric_ordinal.set_inconsistent(      _numeric_mix & SP_CSS_FONT_VARIANT_NUMERIC_ORDINAL );
     _numeric_slashed_zero.set_inconsistent( _numeric_mix & SP_CSS_FONT_VARIANT_NUMERIC_SLASHED_ZERO );
 
-    _asian_all = query->font_variant_east_asian.computed;
-    _asian_mix = query->font_variant_east_asian.value;
+    _asian_all = query->fontVariants().font_variant_east_asian.computed;
+    _asian_mix = query->fontVariants().font_variant_east_asian.value;
 
     if (_asian_all & SP_CSS_FONT_VARIANT_EAST_ASIAN_JIS78) {
         _asian_jis78.set_active();
@@ -724,7 +724,7 @@ FontVariants::update( SPStyle const *query, bool different_features, Glib::ustri
     std::string setting;
 
     // Set feature radiobutton (if it exists) or add to _feature_entry string.
-    if (auto const &val = query->font_feature_settings.value()) {
+    if (auto const &val = query->fontVariants().font_feature_settings.value()) {
         for (auto const &token: Glib::Regex::split_simple("\\s*,\\s*", val)) {
             regex->match(token, matchInfo);
             if (matchInfo.matches()) {
@@ -65,6 +65,14 @@ public:
 	 */
 	virtual void notifyClearRedoEvent() = 0;
 
+	/**
+	 * Triggered when the oldest event of the undo log is dropped to stay within the undo
+	 * memory limit.
+	 *
+	 * \param log Pointer to the Event being dropped.
+	 */
+	virtual void notifyUndoExpiredEvent(Event* log) = 0;
+
 };
 
 }
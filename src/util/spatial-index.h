@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * A static bounding volume hierarchy over a numbered set of rectangles.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef INKSCAPE_UTIL_SPATIAL_INDEX_H
+#define INKSCAPE_UTIL_SPATIAL_INDEX_H
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <vector>
+#include <2geom/rect.h>
+
+namespace Inkscape {
+namespace Util {
+
+/**
+ * A SpatialIndex<C> answers "which rectangles overlap this area?" for a set of rectangles
+ * numbered 0, 1, ..., n - 1 in time roughly proportional to the number of results.
+ *
+ * The index is bulk-loaded from a vector of boxes using median splits along the longest axis,
+ * which gives a balanced tree with LEAF_SIZE entries per leaf. It is cheap to keep up to date:
+ *
+ *  - If some boxes move or change size, call update() for each of them, then refit(). This
+ *    recomputes the bounds of the tree nodes in linear time without reshaping the tree.
+ *  - If the number of boxes changes, or a box becomes empty or non-empty, rebuild with build().
+ *
+ * Refitting gradually degrades the query performance if boxes move far, so callers that refit
+ * repeatedly should rebuild from time to time.
+ *
+ * Empty boxes are accepted, but are never reported by queries.
+ *
+ * Queries are const and do not modify any state, so they may be performed concurrently.
+ */
+template <typename C>
+class SpatialIndex
+{
+public:
+    using Rect = Geom::GenericRect<C>;
+    using OptRect = Geom::GenericOptRect<C>;
+
+    /// Rebuild the index from scratch, with boxes[i] the bounds of entry i.
+    void build(std::vector<OptRect> boxes)
+    {
+        _boxes = std::move(boxes);
+        _nodes.clear();
+        _order.clear();
+        _dirty = false;
+
+        for (unsigned i = 0; i < _boxes.size(); i++) {
+            if (_boxes[i]) {
+                _order.emplace_back(i);
+            }
+        }
+
+        if (!_order.empty()) {
+            _nodes.reserve(2 * _order.size() / LEAF_SIZE + 1);
+            _build(0, _order.size());
+        }
+    }
+
+    /// Drop all entries.
+    void clear()
+    {
+        _boxes.clear();
+        _nodes.clear();
+        _order.clear();
+        _dirty = false;
+    }
+
+    /// The number of entries, including empty ones.
+    auto size() const { return _boxes.size(); }
+
+    /**
+     * Change the bounds of entry i. The change is not visible to queries until refit() is called.
+     *
+     * Returns false if the change cannot be represented without rebuilding the index. This is
+     * the case when the box changes between empty and non-empty.
+     */
+    bool update(unsigned i, OptRect const &box)
+    {
+        assert(i < _boxes.size());
+        auto &old = _boxes[i];
+        if (old == box) {
+            return true;
+        }
+        if (!old || !box) {
+            return false;
+        }
+        old = box;
+        _dirty = true;
+        return true;
+    }
+
+    /**
+     * Recompute the bounds of the tree nodes after calls to update().
+     *
+     * Returns true if any work was done.
+     */
+    bool refit()
+    {
+        if (!_dirty) {
+            return false;
+        }
+        // Children always come after their parent, so a reverse sweep is bottom-up.
+        for (auto i = _nodes.size(); i-- > 0; ) {
+            auto &node = _nodes[i];
+            if (node.count > 0) {
+                node.box = *_boxes[_order[node.first]];
+                for (unsigned j = 1; j < node.count; j++) {
+                    node.box.unionWith(*_boxes[_order[node.first + j]]);
+                }
+            } else {
+                node.box = _nodes[i + 1].box;
+                node.box.unionWith(_nodes[node.right].box);
+            }
+        }
+        _dirty = false;
+        return true;
+    }
+
+    /**
+     * Call f(i) for every entry i whose box intersects the given area.
+     * Entries are visited in no particular order.
+     */
+    template <typename F>
+    void query(Rect const &area, F &&f) const
+    {
+        if (_nodes.empty()) {
+            return;
+        }
+
+        // The tree is balanced, so its depth is bounded by the number of bits in an index.
+        std::array<unsigned, 64> stack;
+        unsigned top = 0;
+        stack[top++] = 0;
+
+        while (top > 0) {
+            auto const &node = _nodes[stack[--top]];
+            if (!node.box.intersects(area)) {
+                continue;
+            }
+            if (node.count > 0) {
+                for (unsigned j = 0; j < node.count; j++) {
+                    auto const i = _order[node.first + j];
+                    if (_boxes[i]->intersects(area)) {
+                        f(i);
+                    }
+                }
+            } else {
+                auto const self = &node - _nodes.data();
+                stack[top++] = node.right;
+                stack[top++] = self + 1;
+            }
+        }
+    }
+
+    /**
+     * Return the entries whose box intersects the given area, in increasing order.
+     */
+    std::vector<unsigned> query(Rect const &area) const
+    {
+        std::vector<unsigned> result;
+        query(area, [&] (unsigned i) { result.emplace_back(i); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+private:
+    static constexpr unsigned LEAF_SIZE = 8;
+
+    struct Node
+    {
+        Rect box;
+        unsigned first; ///< For leaves: the start of the range of _order covered.
+        unsigned count; ///< For leaves: the size of the range; zero for internal nodes.
+        unsigned right; ///< For internal nodes: the index of the right child. The left child is next.
+    };
+
+    std::vector<OptRect> _boxes;
+    std::vector<Node> _nodes;
+    std::vector<unsigned> _order; ///< Indices of non-empty entries, grouped by leaf.
+    bool _dirty = false;
+
+    unsigned _build(unsigned first, unsigned last)
+    {
+        auto const self = _nodes.size();
+        _nodes.emplace_back();
+
+        auto box = *_boxes[_order[first]];
+        auto centres = Geom::Rect(_centre(box), _centre(box));
+        for (auto j = first + 1; j < last; j++) {
+            auto const &b = *_boxes[_order[j]];
+            box.unionWith(b);
+            centres.expandTo(_centre(b));
+        }
+        _nodes[self].box = box;
+
+        if (last - first <= LEAF_SIZE) {
+            _nodes[self].first = first;
+            _nodes[self].count = last - first;
+            return self;
+        }
+
+        // Split at the median along the axis in which the box centres are most spread out.
+        auto const d = centres.width() >= centres.height() ? Geom::X : Geom::Y;
+        auto const mid = first + (last - first) / 2;
+        std::nth_element(_order.begin() + first, _order.begin() + mid, _order.begin() + last, [&, d] (unsigned a, unsigned b) {
+            return _centre(*_boxes[a])[d] < _centre(*_boxes[b])[d];
+        });
+
+        _build(first, mid);
+        auto const right = _build(mid, last);
+        _nodes[self].first = 0;
+        _nodes[self].count = 0;
+        _nodes[self].right = right;
+        return self;
+    }
+
+    static Geom::Point _centre(Rect const &box)
+    {
+        return {((double)box.left() + box.right()) / 2, ((double)box.top() + box.bottom()) / 2};
+    }
+};
+
+} // namespace Util
+} // namespace Inkscape
+
+#endif // INKSCAPE_UTIL_SPATIAL_INDEX_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Hashed containers keyed by strings that can be searched without building a std::string.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef INKSCAPE_UTIL_STRING_HASH_H
+#define INKSCAPE_UTIL_STRING_HASH_H
+
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Inkscape {
+namespace Util {
+
+/**
+ * Hash function for std::string keys that also accepts std::string_view and char const *,
+ * allowing heterogeneous lookup when combined with std::equal_to<>.
+ */
+struct StringHash
+{
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view s) const noexcept { return std::hash<std::string_view>{}(s); }
+};
+
+/**
+ * An unordered map from strings to T, whose find(), count() and contains() take a
+ * std::string, std::string_view or char const * key without allocating.
+ */
+template <typename T>
+using StringMap = std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+
+} // namespace Util
+} // namespace Inkscape
+
+#endif // INKSCAPE_UTIL_STRING_HASH_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
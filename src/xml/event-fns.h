@@ -10,6 +10,10 @@
 #ifndef SEEN_INKSCAPE_XML_SP_REPR_ACTION_FNS_H
 #define SEEN_INKSCAPE_XML_SP_REPR_ACTION_FNS_H
 
+#include <cstddef>
+#include <utility>
+#include <vector>
+
 namespace Inkscape {
 namespace XML {
 
@@ -20,6 +24,15 @@ class NodeObserver;
 void replay_log_to_observer(Event const *log, NodeObserver &observer);
 void undo_log_to_observer(Event const *log, NodeObserver &observer);
 
+/// The memory held by an event log, as measured by sp_repr_log_memory().
+struct LogMemory
+{
+    std::size_t events = 0; ///< The bytes of the events themselves.
+    /// The attribute and content values kept, each listed once with its size in bytes. Values are
+    /// often shared between logs, so whoever sums several logs should count each one once.
+    std::vector<std::pair<char const *, std::size_t>> values;
+};
+
 }
 }
 
@@ -33,5 +46,6 @@ void sp_repr_replay_log (Inkscape::XML::Event *log);
 Inkscape::XML::Event *sp_repr_coalesce_log (Inkscape::XML::Event *a, Inkscape::XML::Event *b);
 void sp_repr_free_log (Inkscape::XML::Event *log);
 void sp_repr_debug_print_log(Inkscape::XML::Event const *log);
+Inkscape::XML::LogMemory sp_repr_log_memory(Inkscape::XML::Event const *log);
 
 #endif
@@ -16,6 +16,8 @@
 
 #include <glib.h> // g_assert()
 #include <cstdio>
+#include <cstring>
+#include <unordered_set>
 
 #include "event.h"
 #include "event-fns.h"
@@ -527,3 +529,72 @@ void sp_repr_debug_print_log(Inkscape::XML::Event const *log) {
     Inkscape::XML::replay_log_to_observer(log, LogPrinter::instance());
 }
 
+namespace {
+
+class LogMeasurer : public Inkscape::XML::NodeObserver {
+public:
+    typedef Inkscape::XML::Node Node;
+
+    Inkscape::XML::LogMemory memory;
+
+    void notifyChildAdded(Node &/*parent*/, Node &/*child*/, Node */*ref*/) override {
+        memory.events += sizeof(Inkscape::XML::EventAdd);
+    }
+
+    void notifyChildRemoved(Node &/*parent*/, Node &/*child*/, Node */*ref*/) override {
+        memory.events += sizeof(Inkscape::XML::EventDel);
+    }
+
+    void notifyChildOrderChanged(Node &/*parent*/, Node &/*child*/,
+                                 Node */*old_ref*/, Node */*new_ref*/) override
+    {
+        memory.events += sizeof(Inkscape::XML::EventChgOrder);
+    }
+
+    void notifyAttributeChanged(Node &/*node*/, GQuark /*name*/,
+                                Inkscape::Util::ptr_shared old_value,
+                                Inkscape::Util::ptr_shared new_value) override
+    {
+        memory.events += sizeof(Inkscape::XML::EventChgAttr);
+        _addString(old_value);
+        _addString(new_value);
+    }
+
+    void notifyContentChanged(Node &/*node*/,
+                              Inkscape::Util::ptr_shared old_value,
+                              Inkscape::Util::ptr_shared new_value) override
+    {
+        memory.events += sizeof(Inkscape::XML::EventChgContent);
+        _addString(old_value);
+        _addString(new_value);
+    }
+
+    void notifyElementNameChanged(Node &/*node*/, GQuark /*old_value*/, GQuark /*new_value*/) override
+    {
+        memory.events += sizeof(Inkscape::XML::EventChgElementName);
+    }
+
+private:
+    // Values are shared between events (the new value of one change is the old value of the
+    // next), so each one is listed once.
+    std::unordered_set<char const *> _strings;
+
+    void _addString(Inkscape::Util::ptr_shared value) {
+        if (value && _strings.insert(value.pointer()).second) {
+            memory.values.emplace_back(value.pointer(), std::strlen(value.pointer()) + 1);
+        }
+    }
+};
+
+}
+
+/**
+ * Approximate the memory held by a log: its events and the attribute and content values they
+ * keep. Subtrees held by added or removed nodes are not counted.
+ */
+Inkscape::XML::LogMemory sp_repr_log_memory(Inkscape::XML::Event const *log) {
+    LogMeasurer measurer;
+    Inkscape::XML::replay_log_to_observer(log, measurer);
+    return std::move(measurer.memory);
+}
+
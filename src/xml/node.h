@@ -15,6 +15,7 @@
 
 #include <vector>
 
+#include <boost/container/small_vector.hpp>
 #include <2geom/point.h>
 
 #include "gc-anchored.h"
@@ -31,7 +32,11 @@ class AttributeRecord;
 struct Document;
 class NodeObserver;
 
-using AttributeVector = std::vector<AttributeRecord, Inkscape::GC::Alloc<AttributeRecord>>;
+/**
+ * The attributes of a node. Most elements have only a few attributes, which are stored inside
+ * the node itself, saving an allocation per node and a pointer chase per lookup.
+ */
+using AttributeVector = boost::container::small_vector<AttributeRecord, 4, Inkscape::GC::Alloc<AttributeRecord>>;
 
 /**
  * @brief Enumeration containing all supported node types.
@@ -14,8 +14,11 @@
 #include <cstring>
 #include <string>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <libxml/parser.h>
+#include <libxml/SAX2.h>
 #include <libxml/xinclude.h>
 
 #include "xml/repr.h"
@@ -48,6 +51,8 @@ using Inkscape::XML::AttributeVector;
 using Inkscape::XML::rebase_href_attrs;
 
 Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns);
+static void sp_repr_fixup_root (Node *root, const gchar *default_ns);
+static Document *sp_repr_sax_read (xmlParserCtxtPtr ctxt, xmlDocPtr (*parse)(xmlParserCtxtPtr, void *), void *data, const gchar *default_ns, bool &needs_tree);
 static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
 static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
@@ -93,6 +98,7 @@ public:
     int setFile( char const * filename );
 
     xmlDocPtr readXml();
+    Document *readDocument(const gchar *default_ns, bool &needs_tree);
 
     static int readCb( void * context, char * buffer, int len );
     static int closeCb( void * context );
@@ -101,6 +107,8 @@ public:
     int read( char * buffer, int len );
     int close();
 private:
+    int parseOptions() const;
+
     const char* filename;
     char* encoding;
     FILE* fp;
@@ -170,7 +178,7 @@ int XmlSource::setFile(char const *filename)
     return retVal;
 }
 
-xmlDocPtr XmlSource::readXml()
+int XmlSource::parseOptions() const
 {
     int parse_options = XML_PARSE_HUGE | XML_PARSE_RECOVER;
 
@@ -178,7 +186,26 @@ xmlDocPtr XmlSource::readXml()
     bool allowNetAccess = prefs->getBool("/options/externalresources/xml/allow_net_access", false);
     if (!allowNetAccess) parse_options |= XML_PARSE_NONET;
 
-    return xmlReadIO(readCb, closeCb, this, filename, getEncoding(), parse_options);
+    return parse_options;
+}
+
+xmlDocPtr XmlSource::readXml()
+{
+    return xmlReadIO(readCb, closeCb, this, filename, getEncoding(), parseOptions());
+}
+
+/**
+ * Reads the file straight into a Document, without building a libxml2 tree first.
+ * See sp_repr_sax_read().
+ */
+Document *XmlSource::readDocument(const gchar *default_ns, bool &needs_tree)
+{
+    auto parse = [] (xmlParserCtxtPtr ctxt, void *data) {
+        auto self = static_cast<XmlSource *>(data);
+        return xmlCtxtReadIO(ctxt, readCb, closeCb, self, self->filename, self->getEncoding(),
+                             self->parseOptions() | XML_PARSE_NOENT);
+    };
+    return sp_repr_sax_read(xmlNewParserCtxt(), parse, this, default_ns, needs_tree);
 }
 
 int XmlSource::readCb( void * context, char * buffer, int len )
@@ -297,14 +324,25 @@ Document *sp_repr_read_file (const gchar * filename, const gchar *default_ns, bo
 
     Inkscape::IO::dump_fopen_call(filename, "N");
 
-    XmlSource src;
+    // XInclude processing works on the libxml2 tree, so it needs the slower tree reader.
+    bool needs_tree = xinclude;
+
+    if (!needs_tree) {
+        XmlSource src;
+        if (src.setFile(filename) == 0) {
+            rdoc = src.readDocument(default_ns, needs_tree);
+        }
+    }
 
-    if (src.setFile(filename) == 0) {
-        doc = src.readXml();
-        if (xinclude && doc && doc->properties && xmlXIncludeProcessFlags(doc, XML_PARSE_NOXINCNODE) < 0) {
-            g_warning("XInclude processing failed for %s", filename);
+    if (needs_tree) {
+        XmlSource src;
+        if (src.setFile(filename) == 0) {
+            doc = src.readXml();
+            if (xinclude && doc && doc->properties && xmlXIncludeProcessFlags(doc, XML_PARSE_NOXINCNODE) < 0) {
+                g_warning("XInclude processing failed for %s", filename);
+            }
+            rdoc = sp_repr_do_read(doc, default_ns);
         }
-        rdoc = sp_repr_do_read(doc, default_ns);
     }
 
     if (doc) {
@@ -335,6 +373,23 @@ Document *sp_repr_read_mem (const gchar * buffer, gint length, const gchar *defa
                                        // proper solution would be to check the preference "/options/externalresources/xml/allow_net_access"
                                        // as done in XmlSource::readXml which gets called by the analogous sp_repr_read_file()
                                        // but sp_repr_read_mem() seems to be called in locations where Inkscape::Preferences::get() fails badly
+
+    struct MemorySource
+    {
+        const gchar *buffer;
+        gint length;
+        int options;
+    } source{buffer, length, parser_options | XML_PARSE_NOENT};
+    auto parse = [] (xmlParserCtxtPtr ctxt, void *data) {
+        auto src = static_cast<MemorySource *>(data);
+        return xmlCtxtReadMemory(ctxt, src->buffer, src->length, nullptr, nullptr, src->options);
+    };
+    bool needs_tree = false;
+    rdoc = sp_repr_sax_read(xmlNewParserCtxt(), parse, &source, default_ns, needs_tree);
+    if (!needs_tree) {
+        return rdoc;
+    }
+
     doc = xmlReadMemory (const_cast<gchar *>(buffer), length, nullptr, nullptr, parser_options);
 
     rdoc = sp_repr_do_read (doc, default_ns);
@@ -468,34 +523,42 @@ Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns)
     }
 
     if (root != nullptr) {
-        /* promote elements of some XML documents that don't use namespaces
-         * into their default namespace */
-        if (!strcmp(root->name(), "ns:svg") || !strcmp(root->name(), "svg0:svg")) {
-            g_warning("Detected broken namespace \"%s\" in the SVG file, attempting to work around it", root->name());
-            repair_namespace(root, "svg");
-        } else if ( default_ns && !strchr(root->name(), ':') ) {
-            if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
-                promote_to_namespace(root, "svg");
-            }
-            if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
-                promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
-            }
-        }
+        sp_repr_fixup_root(root, default_ns);
+    }
 
+    return rdoc;
+}
 
-        // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
-        // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
-        // icons.svg). How can one tell if a file is internal?
-        if ( !strcmp(root->name(), "svg:svg" ) ) {
-            Inkscape::Preferences *prefs = Inkscape::Preferences::get();
-            bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
-            if( clean ) {
-                sp_attribute_clean_tree( root );
-            }
+/**
+ * Repairs or completes the namespaces of a freshly read document, and cleans it if requested.
+ */
+static void sp_repr_fixup_root(Node *root, const gchar *default_ns)
+{
+    /* promote elements of some XML documents that don't use namespaces
+     * into their default namespace */
+    if (!strcmp(root->name(), "ns:svg") || !strcmp(root->name(), "svg0:svg")) {
+        g_warning("Detected broken namespace \"%s\" in the SVG file, attempting to work around it", root->name());
+        repair_namespace(root, "svg");
+    } else if ( default_ns && !strchr(root->name(), ':') ) {
+        if ( !strcmp(default_ns, SP_SVG_NS_URI) ) {
+            promote_to_namespace(root, "svg");
+        }
+        if ( !strcmp(default_ns, INKSCAPE_EXTENSION_URI) ) {
+            promote_to_namespace(root, INKSCAPE_EXTENSION_NS_NC);
         }
     }
 
-    return rdoc;
+
+    // Clean unnecessary attributes and style properties from SVG documents. (Controlled by
+    // preferences.)  Note: internal Inkscape svg files will also be cleaned (filters.svg,
+    // icons.svg). How can one tell if a file is internal?
+    if ( !strcmp(root->name(), "svg:svg" ) ) {
+        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+        bool clean = prefs->getBool("/options/svgoutput/check_on_reading");
+        if( clean ) {
+            sp_attribute_clean_tree( root );
+        }
+    }
 }
 
 gint sp_repr_qualified_name (gchar *p, gint len, xmlNsPtr ns, const xmlChar *name, const gchar */*default_ns*/, std::map<std::string, std::string> &prefix_map)
@@ -593,6 +656,264 @@ static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gc
 }
 
 
+namespace {
+
+/**
+ * Builds a Document straight from the SAX2 callbacks of libxml2, without the libxml2 tree that
+ * sp_repr_do_read() works from. Apart from using less memory and time, the result is the same:
+ * names get the same prefixes, empty and white space text is dropped following xml:space,
+ * adjacent text is merged, and only comments and processing instructions are kept next to the
+ * root element.
+ *
+ * The tree reader has peculiar handling for references to user-defined entities, which some old
+ * files rely on. To keep that, parsing stops at the first entity declaration or reference and
+ * needsTree() is set, asking the caller to read the document through the tree instead. No entity
+ * is ever declared to the parser here, so none is substituted, and external ones are never loaded.
+ */
+class SaxReader
+{
+public:
+    SaxReader(xmlParserCtxtPtr ctxt)
+        : _doc(new SimpleDocument())
+    {
+        ctxt->_private = this;
+        auto sax = ctxt->sax;
+        sax->startElementNs = _startElement;
+        sax->endElementNs = _endElement;
+        sax->characters = _characters;
+        sax->ignorableWhitespace = _characters;
+        sax->cdataBlock = _cdataBlock;
+        sax->comment = _comment;
+        sax->processingInstruction = _processingInstruction;
+        sax->entityDecl = _entityDecl;
+        sax->getEntity = _getEntity;
+        sax->getParameterEntity = _getEntity;
+    }
+
+    ~SaxReader()
+    {
+        if (_doc) {
+            Inkscape::GC::release(_doc);
+        }
+    }
+
+    SaxReader(SaxReader const &) = delete;
+    SaxReader &operator=(SaxReader const &) = delete;
+
+    /// Whether parsing was stopped because the document must be read through the libxml2 tree.
+    bool needsTree() const { return _needs_tree; }
+
+    /// The root element, if one was read.
+    Node *root() const { return _root; }
+
+    /// Hand over ownership of the document.
+    Document *release() { return std::exchange(_doc, nullptr); }
+
+private:
+    Document *_doc;
+    Node *_root = nullptr;
+    bool _needs_tree = false;
+
+    struct OpenElement
+    {
+        Node *node;
+        bool preserve_space; ///< The xml:space mode in effect for the children.
+    };
+    std::vector<OpenElement> _open;
+
+    std::string _text; ///< Character data not yet turned into a node.
+    xmlElementType _text_type = XML_TEXT_NODE;
+
+    std::string _name; ///< Scratch buffers, kept to avoid allocating for every name and value.
+    std::string _value;
+
+    static SaxReader &_get(void *ctx) { return *static_cast<SaxReader *>(static_cast<xmlParserCtxtPtr>(ctx)->_private); }
+
+    void _append(Node *repr)
+    {
+        if (_open.empty()) {
+            _doc->appendChild(repr);
+        } else {
+            _open.back().node->appendChild(repr);
+        }
+        Inkscape::GC::release(repr);
+    }
+
+    void _qualifyName(const xmlChar *localname, const xmlChar *prefix, const xmlChar *uri)
+    {
+        if (uri) {
+            prefix = reinterpret_cast<const xmlChar *>(sp_xml_ns_uri_prefix(reinterpret_cast<const gchar *>(uri),
+                                                                             reinterpret_cast<const char *>(prefix)));
+        }
+        _name.clear();
+        if (prefix) {
+            _name += reinterpret_cast<const char *>(prefix);
+            _name += ':';
+        }
+        _name += reinterpret_cast<const char *>(localname);
+    }
+
+    void _addCharacters(const xmlChar *ch, int len, xmlElementType type)
+    {
+        if (_text_type != type) {
+            _flushText();
+            _text_type = type;
+        }
+        _text.append(reinterpret_cast<const char *>(ch), len);
+    }
+
+    void _flushText()
+    {
+        if (_text.empty()) {
+            return;
+        }
+        if (!_open.empty()) {
+            bool preserve = _open.back().preserve_space;
+            auto it = _text.begin();
+            while (it != _text.end() && g_ascii_isspace(*it) && !preserve) {
+                ++it;
+            }
+            if (it != _text.end()) {
+                _append(_doc->createTextNode(_text.c_str(), _text_type == XML_CDATA_SECTION_NODE));
+            }
+        }
+        _text.clear();
+    }
+
+    static void _startElement(void *ctx, const xmlChar *localname, const xmlChar *prefix, const xmlChar *uri,
+                              int /*nb_namespaces*/, const xmlChar ** /*namespaces*/,
+                              int nb_attributes, int /*nb_defaulted*/, const xmlChar **attributes)
+    {
+        auto &self = _get(ctx);
+        self._flushText();
+
+        self._qualifyName(localname, prefix, uri);
+        Node *repr = self._doc->createElement(self._name.c_str());
+
+        bool preserve = !self._open.empty() && self._open.back().preserve_space;
+        // Each attribute is given as localname, prefix, URI, start and end of the value.
+        for (int i = 0; i < nb_attributes; i++, attributes += 5) {
+            // Empty attributes are left unset, as the tree reader used to do.
+            if (attributes[3] == attributes[4]) {
+                continue;
+            }
+            self._qualifyName(attributes[0], attributes[1], attributes[2]);
+            self._value.assign(reinterpret_cast<const char *>(attributes[3]), reinterpret_cast<const char *>(attributes[4]));
+            repr->setAttribute(self._name.c_str(), self._value.c_str());
+
+            if (attributes[1] && !strcmp(reinterpret_cast<const char *>(attributes[1]), "xml") &&
+                !strcmp(reinterpret_cast<const char *>(attributes[0]), "space")) {
+                if (self._value == "preserve") {
+                    preserve = true;
+                } else if (self._value == "default") {
+                    preserve = false;
+                }
+            }
+        }
+
+        if (self._open.empty() && !self._root) {
+            self._root = repr;
+        }
+        self._append(repr);
+        self._open.push_back({repr, preserve});
+    }
+
+    static void _endElement(void *ctx, const xmlChar *, const xmlChar *, const xmlChar *)
+    {
+        auto &self = _get(ctx);
+        self._flushText();
+        self._open.pop_back();
+    }
+
+    static void _characters(void *ctx, const xmlChar *ch, int len)
+    {
+        _get(ctx)._addCharacters(ch, len, XML_TEXT_NODE);
+    }
+
+    static void _cdataBlock(void *ctx, const xmlChar *value, int len)
+    {
+        _get(ctx)._addCharacters(value, len, XML_CDATA_SECTION_NODE);
+    }
+
+    static void _comment(void *ctx, const xmlChar *value)
+    {
+        if (static_cast<xmlParserCtxtPtr>(ctx)->inSubset) {
+            return; // Comments in the DTD are not part of the document.
+        }
+        auto &self = _get(ctx);
+        self._flushText();
+        self._append(self._doc->createComment(reinterpret_cast<const gchar *>(value)));
+    }
+
+    static void _processingInstruction(void *ctx, const xmlChar *target, const xmlChar *data)
+    {
+        if (static_cast<xmlParserCtxtPtr>(ctx)->inSubset) {
+            return;
+        }
+        auto &self = _get(ctx);
+        self._flushText();
+        self._append(self._doc->createPI(reinterpret_cast<const gchar *>(target), reinterpret_cast<const gchar *>(data)));
+    }
+
+    static void _entityDecl(void *ctx, const xmlChar *, int, const xmlChar *, const xmlChar *, xmlChar *)
+    {
+        // The entity is not declared, so nothing can be substituted for it, least of all the
+        // contents of an external file.
+        _stop(ctx);
+    }
+
+    static xmlEntityPtr _getEntity(void *ctx, const xmlChar *)
+    {
+        // Only called for entities other than the predefined ones.
+        _stop(ctx);
+        return nullptr;
+    }
+
+    static void _stop(void *ctx)
+    {
+        _get(ctx)._needs_tree = true;
+        xmlStopParser(static_cast<xmlParserCtxtPtr>(ctx));
+    }
+};
+
+} // namespace
+
+/**
+ * Reads a document with libxml2's SAX2 interface, creating the nodes directly from the parser
+ * callbacks.
+ *
+ * \param ctxt A new parser context, which is freed.
+ * \param parse Runs the parser on ctxt, e.g. with xmlCtxtReadMemory(), and returns its result.
+ * XML_PARSE_NOENT should be given, so that attribute values have predefined entities replaced.
+ * \param data Passed on to parse.
+ * \param needs_tree Set if the document must be read with sp_repr_do_read() instead.
+ */
+static Document *sp_repr_sax_read(xmlParserCtxtPtr ctxt, xmlDocPtr (*parse)(xmlParserCtxtPtr, void *), void *data,
+                                  const gchar *default_ns, bool &needs_tree)
+{
+    if (!ctxt) {
+        needs_tree = true;
+        return nullptr;
+    }
+
+    SaxReader reader(ctxt);
+    // The returned document only holds the DTD, if any.
+    xmlDocPtr doc = parse(ctxt, data);
+    if (doc) {
+        xmlFreeDoc(doc);
+    }
+    xmlFreeParserCtxt(ctxt);
+
+    needs_tree = reader.needsTree();
+    if (!doc || needs_tree || !reader.root()) {
+        return nullptr;
+    }
+
+    sp_repr_fixup_root(reader.root(), default_ns);
+    return reader.release();
+}
+
+
 static void sp_repr_save_writer(Document *doc, Inkscape::IO::Writer *out,
                     gchar const *default_ns,
                     gchar const *old_href_abs_base,
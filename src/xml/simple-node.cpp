@@ -225,10 +225,44 @@ gchar const *SimpleNode::content() const {
     return this->_content;
 }
 
+/**
+ * Look up the quark for an attribute name, returning 0 if the name has never been interned,
+ * in which case no node can have such an attribute. The most frequently used names are
+ * resolved without going through GLib's locked quark table.
+ */
+static GQuark attribute_quark(gchar const *name)
+{
+    static GQuark const d = g_quark_from_static_string("d");
+    static GQuark const id = g_quark_from_static_string("id");
+    static GQuark const style = g_quark_from_static_string("style");
+    static GQuark const transform = g_quark_from_static_string("transform");
+
+    switch (name[0]) {
+        case 'd':
+            if (name[1] == '\0') return d;
+            break;
+        case 'i':
+            if (!std::strcmp(name, "id")) return id;
+            break;
+        case 's':
+            if (!std::strcmp(name, "style")) return style;
+            break;
+        case 't':
+            if (!std::strcmp(name, "transform")) return transform;
+            break;
+        default:
+            break;
+    }
+    return g_quark_try_string(name);
+}
+
 gchar const *SimpleNode::attribute(gchar const *name) const {
     g_return_val_if_fail(name != nullptr, NULL);
 
-    GQuark const key = g_quark_from_string(name);
+    GQuark const key = attribute_quark(name);
+    if (!key) {
+        return nullptr;
+    }
 
     for (const auto & iter : _attributes)
     {
@@ -358,7 +392,10 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
         }
     }
 
-    GQuark const key = g_quark_from_string(name);
+    GQuark key = attribute_quark(name);
+    if (!key) {
+        key = g_quark_from_string(name);
+    }
 
     AttributeRecord *ref = nullptr;
     for ( auto & existing : _attributes ) {
@@ -48,4 +48,15 @@ TEST_F(PixbufTest, creatingFromSvgUriWithoutViewboxOrWidthAndHeightReturnsNull)
     double default_dpi = 96.0;
 
     ASSERT_EQ(Inkscape::Pixbuf::create_from_data_uri(uri_data.c_str(), default_dpi), nullptr);
-}
\ No newline at end of file
+}
+
+TEST(CairoUtilsTest, UnpremulAlphaIsExact)
+{
+    for (guint32 alpha = 1; alpha < 256; ++alpha) {
+        for (guint32 color = 0; color < alpha; ++color) {
+            ASSERT_EQ(unpremul_alpha(color, alpha), (255 * color + alpha / 2) / alpha) << color << "/" << alpha;
+        }
+        ASSERT_EQ(unpremul_alpha(alpha, alpha), 0xffu);
+    }
+}
+
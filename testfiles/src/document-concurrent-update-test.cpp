@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test that updating independent subtrees of a document concurrently gives the same result as
+ * updating them one after the other.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <sstream>
+
+#include "document.h"
+#include "inkscape.h"
+#include "preferences.h"
+#include "object/sp-item.h"
+#include "object/sp-root.h"
+#include "style.h"
+
+using namespace Inkscape;
+
+class DocumentConcurrentUpdateTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        Application::create(false);
+
+        // Layers of shapes, plain or nested in groups, with a gradient, a clone and relative units
+        // entangling a few of them.
+        std::ostringstream svg;
+        svg << "<svg xmlns='http://www.w3.org/2000/svg' xmlns:xlink='http://www.w3.org/1999/xlink'"
+               " xmlns:inkscape='http://www.inkscape.org/namespaces/inkscape' width='1000' height='1000'>"
+               "<defs><linearGradient id='grad'><stop offset='0' stop-color='red'/></linearGradient></defs>";
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<double> pos(0, 950), size(1, 50);
+        for (int layer = 0; layer < 8; layer++) {
+            svg << "<g id='layer" << layer << "' inkscape:groupmode='layer' style='stroke:blue;stroke-width:2'"
+                << " transform='translate(" << layer << ",0)'>";
+            for (int i = 0; i < 60; i++) {
+                auto const id = layer * 100 + i;
+                if (i % 10 == 0) {
+                    svg << "<g id='group" << id << "' transform='rotate(" << i << ")'>";
+                }
+                switch (i % 4) {
+                    case 0:
+                        svg << "<rect id='item" << id << "' x='" << pos(gen) << "' y='" << pos(gen)
+                            << "' width='" << size(gen) << "%' height='" << size(gen) << "'/>";
+                        break;
+                    case 1:
+                        svg << "<ellipse id='item" << id << "' cx='" << pos(gen) << "' cy='" << pos(gen)
+                            << "' rx='" << size(gen) << "' ry='" << size(gen) << "' style='stroke-width:0.5em'/>";
+                        break;
+                    case 2:
+                        svg << "<path id='item" << id << "' d='M " << pos(gen) << "," << pos(gen) << " L "
+                            << pos(gen) << "," << pos(gen) << " " << pos(gen) << "," << pos(gen) << " Z'/>";
+                        break;
+                    default:
+                        svg << "<line id='item" << id << "' x1='" << pos(gen) << "' y1='" << pos(gen)
+                            << "' x2='" << pos(gen) << "' y2='" << pos(gen) << "'/>";
+                        break;
+                }
+                if (i % 10 == 9) {
+                    svg << "</g>";
+                }
+            }
+            svg << "</g>";
+        }
+        svg << "<rect id='gradient' x='10' y='10' width='10' height='10' style='fill:url(#grad)'/>"
+               "<use id='clone' xlink:href='#item101' x='5' y='5'/></svg>";
+        source = svg.str();
+    }
+
+    std::unique_ptr<SPDocument> load(int threads) { return load(threads, source); }
+
+    std::unique_ptr<SPDocument> load(int threads, std::string const &svg)
+    {
+        Preferences::get()->setInt("/options/threading/numthreads", threads);
+        auto doc = SPDocument::createNewDocFromMem(svg.c_str(), svg.size(), true);
+        doc->ensureUpToDate();
+        return doc;
+    }
+
+    void expect_same(SPDocument *serial, SPDocument *concurrent)
+    {
+        for (auto id : { "gradient", "clone" }) {
+            auto a = cast<SPItem>(serial->getObjectById(id));
+            auto b = cast<SPItem>(concurrent->getObjectById(id));
+            EXPECT_EQ(a->documentVisualBounds(), b->documentVisualBounds()) << id;
+        }
+        for (int layer = 0; layer < 8; layer++) {
+            for (int i = 0; i < 60; i++) {
+                auto const id = "item" + std::to_string(layer * 100 + i);
+                auto a = cast<SPItem>(serial->getObjectById(id));
+                auto b = cast<SPItem>(concurrent->getObjectById(id));
+                ASSERT_TRUE(a && b);
+                EXPECT_EQ(a->documentVisualBounds(), b->documentVisualBounds()) << id;
+                EXPECT_EQ(a->style->stroke_width.computed, b->style->stroke_width.computed) << id;
+                EXPECT_EQ(a->style->stroke.get_value(), b->style->stroke.get_value()) << id;
+            }
+        }
+    }
+
+    std::string source;
+};
+
+TEST_F(DocumentConcurrentUpdateTest, MatchesSerial)
+{
+    auto serial = load(1);
+    auto concurrent = load(8);
+    EXPECT_EQ(concurrent->update_threads, 8);
+    expect_same(serial.get(), concurrent.get());
+}
+
+TEST_F(DocumentConcurrentUpdateTest, GroupPathEffect)
+{
+    // Updating a shape under a group with a path effect reruns the effect over all of the group's
+    // children, so they must not be updated concurrently.
+    std::ostringstream svg;
+    svg << "<svg xmlns='http://www.w3.org/2000/svg' xmlns:inkscape='http://www.inkscape.org/namespaces/inkscape'"
+           " width='1000' height='1000'><defs><inkscape:path-effect id='effect' effect='offset' offset='3'"
+           " unit='px' linejoin_type='miter' lpeversion='1.2'/></defs>"
+           "<g id='group' inkscape:path-effect='#effect'>";
+    for (int i = 0; i < 80; i++) {
+        svg << "<g><rect id='item" << i << "' x='" << (i % 10) * 90 << "' y='" << (i / 10) * 90
+            << "' width='50' height='" << 20 + i << "'/></g>";
+    }
+    svg << "</g></svg>";
+
+    auto serial = load(1, svg.str());
+    auto concurrent = load(8, svg.str());
+    EXPECT_EQ(concurrent->update_concurrent_subtrees, 0u);
+
+    for (auto doc : { serial.get(), concurrent.get() }) {
+        doc->getObjectById("item5")->setAttribute("width", "70");
+        doc->ensureUpToDate();
+    }
+    for (int i = 0; i < 80; i++) {
+        auto const id = "item" + std::to_string(i);
+        auto a = cast<SPItem>(serial->getObjectById(id));
+        auto b = cast<SPItem>(concurrent->getObjectById(id));
+        ASSERT_TRUE(a && b);
+        EXPECT_EQ(a->documentVisualBounds(), b->documentVisualBounds()) << id;
+    }
+}
+
+TEST_F(DocumentConcurrentUpdateTest, FollowsChanges)
+{
+    auto serial = load(1);
+    auto concurrent = load(8);
+
+    for (auto doc : { serial.get(), concurrent.get() }) {
+        doc->getRoot()->setAttribute("width", "500");
+        doc->getObjectById("layer3")->setAttribute("style", "stroke:green;stroke-width:3;font-size:20px");
+        doc->getObjectById("item101")->setAttribute("transform", "scale(2)");
+        doc->ensureUpToDate();
+    }
+    expect_same(serial.get(), concurrent.get());
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,181 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test finding the items of a document by area.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "document.h"
+#include "inkscape.h"
+#include "object/sp-item.h"
+#include "object/sp-item-group.h"
+#include "object/sp-root.h"
+
+using namespace Inkscape;
+
+class DocumentItemsInBoxTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        Application::create(false);
+
+        // A layer of rectangles, some in groups, one of them hidden, and one locked.
+        std::ostringstream svg;
+        svg << "<svg xmlns='http://www.w3.org/2000/svg' xmlns:inkscape='http://www.inkscape.org/namespaces/inkscape'"
+               " xmlns:sodipodi='http://sodipodi.sourceforge.net/DTD/sodipodi-0.dtd' width='1000' height='1000'>"
+               "<g id='layer' inkscape:groupmode='layer'>";
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<double> pos(0, 950), size(1, 50);
+        for (int i = 0; i < 500; i++) {
+            if (i % 50 == 0) {
+                svg << "<g id='group" << i << "'>";
+            }
+            svg << "<rect id='rect" << i << "' x='" << pos(gen) << "' y='" << pos(gen)
+                << "' width='" << size(gen) << "' height='" << size(gen) << "'"
+                << (i == 7 ? " style='display:none'" : "") << (i == 8 ? " sodipodi:insensitive='true'" : "") << "/>";
+            if (i % 50 == 9) {
+                svg << "</g>";
+            }
+        }
+        svg << "</g></svg>";
+        auto const str = svg.str();
+        doc = SPDocument::createNewDocFromMem(str.c_str(), str.size(), true);
+        doc->ensureUpToDate();
+    }
+
+    // The items found by walking the whole document, as the search did before it was indexed.
+    void walk(std::vector<SPItem *> &s, SPGroup *group, Geom::Rect const &area, bool within,
+              bool take_groups, bool enter_groups)
+    {
+        for (auto &o : group->children) {
+            auto item = cast<SPItem>(&o);
+            if (!item || item->isLocked() || item->isHidden()) {
+                continue;
+            }
+            if (auto childgroup = cast<SPGroup>(item)) {
+                bool is_layer = childgroup->effectiveLayerMode(0) == SPGroup::LAYER;
+                if (is_layer || enter_groups) {
+                    walk(s, childgroup, area, within, take_groups, enter_groups);
+                }
+                if (!take_groups || is_layer) {
+                    continue;
+                }
+            }
+            auto box = item->documentVisualBounds();
+            if (box && (within ? area.contains(*box) : area.intersects(*box))) {
+                s.push_back(item);
+            }
+        }
+    }
+
+    void check(Geom::Rect const &area)
+    {
+        for (bool take_groups : { false, true }) {
+            for (bool enter_groups : { false, true }) {
+                std::vector<SPItem *> within, partially;
+                walk(within, doc->getRoot(), area, true, take_groups, enter_groups);
+                walk(partially, doc->getRoot(), area, false, take_groups, enter_groups);
+                EXPECT_EQ(doc->getItemsInBox(0, area, false, false, take_groups, enter_groups), within);
+                EXPECT_EQ(doc->getItemsPartiallyInBox(0, area, false, false, take_groups, enter_groups), partially);
+            }
+        }
+    }
+
+    std::unique_ptr<SPDocument> doc;
+};
+
+TEST_F(DocumentItemsInBoxTest, MatchesWalk)
+{
+    for (double size : { 10.0, 100.0, 400.0, 2000.0 }) {
+        for (double x = -50; x < 1000; x += 230) {
+            check(Geom::Rect::from_xywh(x, x / 2, size, size));
+        }
+    }
+}
+
+TEST_F(DocumentItemsInBoxTest, FollowsChanges)
+{
+    auto const area = Geom::Rect(500, 500, 700, 700);
+    check(area);
+
+    // Move an item into the area.
+    auto rect = cast<SPItem>(doc->getObjectById("rect3"));
+    rect->setAttribute("x", "600");
+    rect->setAttribute("y", "600");
+    doc->ensureUpToDate();
+    check(area);
+    auto const found = doc->getItemsInBox(0, area, false, false, true, true);
+    EXPECT_NE(std::find(found.begin(), found.end(), rect), found.end());
+
+    // Remove an item, and add one.
+    doc->getObjectById("rect4")->deleteObject();
+    auto repr = doc->getReprDoc()->createElement("svg:rect");
+    repr->setAttribute("x", "550");
+    repr->setAttribute("y", "550");
+    repr->setAttribute("width", "10");
+    repr->setAttribute("height", "10");
+    doc->getObjectById("layer")->getRepr()->appendChild(repr);
+    Inkscape::GC::release(repr);
+    doc->ensureUpToDate();
+    check(area);
+}
+
+TEST_F(DocumentItemsInBoxTest, FollowsReorder)
+{
+    auto const area = Geom::Rect(-100, -100, 1100, 1100);
+    check(area);
+
+    // Move items to the bottom and to the top, which changes only their order.
+    auto layer = doc->getObjectById("layer")->getRepr();
+    layer->changeOrder(doc->getObjectById("rect20")->getRepr(), nullptr);
+    layer->changeOrder(doc->getObjectById("rect30")->getRepr(), layer->lastChild());
+    doc->ensureUpToDate();
+    check(area);
+
+    auto const found = doc->getItemsInBox(0, area, false, false, true, true);
+    ASSERT_FALSE(found.empty());
+    EXPECT_EQ(found.front(), doc->getObjectById("rect20"));
+    EXPECT_EQ(found.back(), doc->getObjectById("rect30"));
+
+    // Reordering inside a group.
+    auto group = doc->getObjectById("group100")->getRepr();
+    group->changeOrder(group->lastChild(), nullptr);
+    doc->ensureUpToDate();
+    check(area);
+}
+
+TEST_F(DocumentItemsInBoxTest, RepeatedChanges)
+{
+    auto const area = Geom::Rect(0, 0, 500, 500);
+    check(area);
+
+    // Changing the same item many times between searches lists it once.
+    auto rect = doc->getObjectById("rect12");
+    for (int i = 0; i < 100; i++) {
+        rect->setAttribute("x", std::to_string(i * 5));
+        doc->ensureUpToDate();
+    }
+    check(area);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,205 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test the memory held by the undo history, and its limit.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "document.h"
+#include "document-undo.h"
+#include "event-log.h"
+#include "inkscape.h"
+#include "preferences.h"
+#include "xml/node.h"
+
+using namespace Inkscape;
+
+class DocumentUndoMemoryTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        Application::create(false);
+        Preferences::get()->setInt("/options/undo/memorylimit", 0);
+
+        auto const svg = "<svg xmlns='http://www.w3.org/2000/svg' width='100' height='100'><path id='path' d='"
+                         + path_data(-1) + "'/></svg>";
+        doc = SPDocument::createNewDocFromMem(svg.c_str(), svg.size(), true);
+        path = doc->getObjectById("path")->getRepr();
+    }
+
+    void TearDown() override
+    {
+        Preferences::get()->setInt("/options/undo/memorylimit", 0);
+    }
+
+    // A large path, moved a little further at each step.
+    static std::string path_data(int step)
+    {
+        std::ostringstream d;
+        d << "M 0," << step;
+        for (int i = 0; i < 4000; i++) {
+            d << " L " << i << "," << i % 7;
+        }
+        return d.str();
+    }
+
+    void nudge(int step, char const *key)
+    {
+        path->setAttribute("d", path_data(step));
+        DocumentUndo::maybeDone(doc.get(), key, "Nudge", "");
+    }
+
+    std::string d() const { return path->attribute("d"); }
+
+    std::unique_ptr<SPDocument> doc;
+    XML::Node *path = nullptr;
+};
+
+TEST_F(DocumentUndoMemoryTest, MergesRepeatedChanges)
+{
+    for (int step = 0; step < 20; step++) {
+        nudge(step, "nudge");
+    }
+
+    // Only the values before the first and after the last nudge are kept.
+    auto const size = path_data(0).size();
+    EXPECT_GE(DocumentUndo::getUndoMemory(doc.get()), 2 * size);
+    EXPECT_LT(DocumentUndo::getUndoMemory(doc.get()), 3 * size);
+
+    EXPECT_TRUE(DocumentUndo::undo(doc.get()));
+    EXPECT_EQ(d(), path_data(-1));
+    EXPECT_FALSE(DocumentUndo::undo(doc.get()));
+    EXPECT_TRUE(DocumentUndo::redo(doc.get()));
+    EXPECT_EQ(d(), path_data(19));
+}
+
+TEST_F(DocumentUndoMemoryTest, LimitsMemory)
+{
+    Preferences::get()->setInt("/options/undo/memorylimit", 1);
+
+    int const steps = 50;
+    for (int step = 0; step < steps; step++) {
+        nudge(step, nullptr);
+        EXPECT_LE(DocumentUndo::getUndoMemory(doc.get()), 1 << 20);
+    }
+
+    // The oldest steps are forgotten, and the remaining ones still undo and redo correctly.
+    int undone = 0;
+    while (DocumentUndo::undo(doc.get())) {
+        undone++;
+        EXPECT_EQ(d(), path_data(steps - 1 - undone));
+    }
+    EXPECT_GT(undone, 1);
+    EXPECT_LT(undone, steps);
+
+    while (DocumentUndo::redo(doc.get())) {
+    }
+    EXPECT_EQ(d(), path_data(steps - 1));
+}
+
+TEST_F(DocumentUndoMemoryTest, KeepsLatestStep)
+{
+    Preferences::get()->setInt("/options/undo/memorylimit", 1);
+
+    // A single step larger than the limit can still be undone.
+    std::string huge = "M 0,0";
+    while (huge.size() < std::size_t{2} << 20) {
+        huge += " L 1,1";
+    }
+    nudge(0, nullptr);
+    path->setAttribute("d", huge);
+    DocumentUndo::done(doc.get(), "Grow", "");
+
+    EXPECT_TRUE(DocumentUndo::undo(doc.get()));
+    EXPECT_EQ(d(), path_data(0));
+    EXPECT_FALSE(DocumentUndo::undo(doc.get()));
+}
+
+TEST_F(DocumentUndoMemoryTest, CountsSharedValuesOnce)
+{
+    nudge(0, nullptr);
+    nudge(1, nullptr);
+
+    // The value after the first step is also the value before the second, and is held once.
+    auto const size = path_data(0).size();
+    EXPECT_GE(DocumentUndo::getUndoMemory(doc.get()), 3 * size);
+    EXPECT_LT(DocumentUndo::getUndoMemory(doc.get()), 4 * size);
+}
+
+TEST_F(DocumentUndoMemoryTest, ExpiresBranchHead)
+{
+    auto const log = doc->get_event_log();
+    ASSERT_TRUE(log);
+    auto const store = log->getEventListStore();
+    auto const &columns = EventLog::getColumns();
+    auto const root = store->children().begin();
+    auto const head = [&] {
+        auto it = root;
+        return ++it;
+    };
+    auto const events = [&] { return static_cast<int>((*head())[columns.child_count]); };
+
+    // Steps with the same icon are grouped under the first one, which heads a branch. The document
+    // is saved after that first step.
+    nudge(0, nullptr);
+    doc->setModifiedSinceSave(false);
+    log->rememberFileSave();
+
+    // Commit until the first step expires.
+    Preferences::get()->setInt("/options/undo/memorylimit", 1);
+    int step = 1;
+    int count = 1;
+    for (; step < 100; step++) {
+        nudge(step, nullptr);
+        if (events() == count) {
+            break;
+        }
+        count = events();
+    }
+    ASSERT_LT(step, 100);
+
+    // The next step took the place of the expired head, and the branch is otherwise unchanged.
+    EXPECT_EQ(store->children().size(), 2u);
+    EXPECT_EQ(static_cast<int>(head()->children().size()) + 1, count);
+    EXPECT_EQ(log->getCurrEvent(), --head()->children().end());
+
+    // The root row now stands for the state after the expired step, which is the saved state.
+    for (int i = 0; i < count; i++) {
+        EXPECT_TRUE(DocumentUndo::undo(doc.get()));
+    }
+    EXPECT_FALSE(DocumentUndo::undo(doc.get()));
+    EXPECT_EQ(log->getCurrEvent(), root);
+    EXPECT_EQ(d(), path_data(0));
+    EXPECT_FALSE(doc->isModifiedSinceSave());
+
+    while (DocumentUndo::redo(doc.get())) {
+    }
+    EXPECT_EQ(d(), path_data(step));
+
+    // Once a later step expires too, the saved state can no longer be reached.
+    nudge(step + 1, nullptr);
+    while (DocumentUndo::undo(doc.get())) {
+    }
+    EXPECT_EQ(log->getCurrEvent(), root);
+    EXPECT_NE(d(), path_data(0));
+    EXPECT_TRUE(doc->isModifiedSinceSave());
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
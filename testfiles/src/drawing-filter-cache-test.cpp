@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test that filtered items not picked for caching reuse their filter results.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <cairomm/surface.h>
+#include <2geom/int-rect.h>
+
+#include "inkscape.h"
+#include "document.h"
+#include "display/drawing.h"
+#include "display/drawing-context.h"
+#include "display/drawing-surface.h"
+#include "object/sp-root.h"
+
+namespace {
+
+char const *const svg = R"(<svg xmlns="http://www.w3.org/2000/svg" width="100" height="100">
+  <filter id="blur" x="-50%" y="-50%" width="200%" height="200%">
+    <feGaussianBlur stdDeviation="4"/>
+  </filter>
+  <rect id="rect" x="30" y="30" width="40" height="40" fill="#ff0000" filter="url(#blur)"/>
+</svg>)";
+
+class Display
+{
+public:
+    Display(SPDocument *doc)
+        : root(doc->getRoot())
+        , dkey(SPItem::display_key_new(1))
+    {
+        drawing.setRoot(root->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
+        drawing.update();
+    }
+
+    ~Display() { root->invoke_hide(dkey); }
+
+    auto draw(Geom::IntRect const &rect)
+    {
+        auto cs = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, rect.width(), rect.height());
+        auto ds = Inkscape::DrawingSurface(cs->cobj(), rect.min());
+        auto dc = Inkscape::DrawingContext(ds);
+        drawing.render(dc, rect);
+        cs->flush();
+        return cs;
+    }
+
+    Inkscape::Drawing drawing;
+
+private:
+    SPRoot *root;
+    unsigned dkey;
+};
+
+bool same_pixels(Cairo::RefPtr<Cairo::ImageSurface> const &a, Cairo::RefPtr<Cairo::ImageSurface> const &b)
+{
+    for (int y = 0; y < a->get_height(); y++) {
+        if (std::memcmp(a->get_data() + y * a->get_stride(), b->get_data() + y * b->get_stride(), a->get_width() * 4)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(DrawingFilterCacheTest, RepeatedRenderDoesNotRunFilter)
+{
+    if (!Inkscape::Application::exists()) {
+        Inkscape::Application::create(false);
+    }
+
+    auto doc = std::unique_ptr<SPDocument>(SPDocument::createNewDocFromMem(svg, static_cast<int>(std::strlen(svg)), false));
+    ASSERT_TRUE(doc);
+    doc->ensureUpToDate();
+
+    // A drawing without a canvas has no cache budget, so no item is picked for caching.
+    Display display(doc.get());
+    auto const area = Geom::IntRect::from_xywh(0, 0, 100, 100);
+
+    auto const first = display.draw(area);
+    auto stats = display.drawing.takeFilterCacheStats();
+    EXPECT_EQ(stats.misses, 1ul);
+    EXPECT_EQ(stats.hits, 0ul);
+
+    auto const second = display.draw(area);
+    stats = display.drawing.takeFilterCacheStats();
+    EXPECT_EQ(stats.misses, 0ul);
+    EXPECT_EQ(stats.hits, 1ul);
+    EXPECT_TRUE(same_pixels(first, second));
+
+    // A different area is a different result.
+    display.draw(Geom::IntRect::from_xywh(0, 0, 50, 50));
+    stats = display.drawing.takeFilterCacheStats();
+    EXPECT_EQ(stats.misses, 1ul);
+
+    // Changing the item drops its results.
+    doc->getObjectById("rect")->setAttribute("fill", "#0000ff");
+    doc->ensureUpToDate();
+    display.drawing.update();
+    auto const third = display.draw(area);
+    stats = display.drawing.takeFilterCacheStats();
+    EXPECT_EQ(stats.misses, 1ul);
+    EXPECT_EQ(stats.hits, 0ul);
+    EXPECT_FALSE(same_pixels(first, third));
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test that shapes smaller than a pixel are splatted with the right colour and amount of ink.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <cairomm/surface.h>
+#include <2geom/int-rect.h>
+
+#include "inkscape.h"
+#include "document.h"
+#include "display/cairo-utils.h"
+#include "display/drawing.h"
+#include "display/drawing-context.h"
+#include "display/drawing-surface.h"
+#include "object/sp-root.h"
+
+namespace {
+
+// A triangle filling half of its bounds, and a line whose stroke fills three quarters of its bounds.
+// Both straddle the corner where four pixels meet.
+char const *const svg = R"(<svg xmlns="http://www.w3.org/2000/svg" width="40" height="40">
+  <path d="M 9.6 9.6 L 10.4 9.6 L 9.6 10.4 Z" fill="#ff8000"/>
+  <path d="M 19.6 20 H 20.4" fill="none" stroke="#0000ff" stroke-width="0.2" stroke-opacity="0.5"/>
+</svg>)";
+
+class Display
+{
+public:
+    Display(SPDocument *doc, bool level_of_detail)
+        : root(doc->getRoot())
+        , dkey(SPItem::display_key_new(1))
+    {
+        drawing.setRoot(root->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
+        drawing.setLevelOfDetail(level_of_detail);
+        drawing.update();
+    }
+
+    ~Display() { root->invoke_hide(dkey); }
+
+    auto draw(Geom::IntRect const &rect)
+    {
+        auto cs = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, rect.width(), rect.height());
+        auto ds = Inkscape::DrawingSurface(cs->cobj(), rect.min());
+        auto dc = Inkscape::DrawingContext(ds);
+        drawing.render(dc, rect);
+        cs->flush();
+        return cs;
+    }
+
+    Inkscape::Drawing drawing;
+
+private:
+    SPRoot *root;
+    unsigned dkey;
+};
+
+struct Pixel
+{
+    int r, g, b, a;
+};
+
+Pixel pixel_at(Cairo::RefPtr<Cairo::ImageSurface> const &surface, int x, int y)
+{
+    auto const px = reinterpret_cast<guint32 const *>(surface->get_data() + y * surface->get_stride())[x];
+    EXTRACT_ARGB32(px, a, r, g, b);
+    return { static_cast<int>(r), static_cast<int>(g), static_cast<int>(b), static_cast<int>(a) };
+}
+
+// The sum of each premultiplied channel over the four pixels around the given corner.
+Pixel ink_around(Cairo::RefPtr<Cairo::ImageSurface> const &surface, int x, int y)
+{
+    Pixel sum{ 0, 0, 0, 0 };
+    for (int j = y - 1; j <= y; ++j) {
+        for (int i = x - 1; i <= x; ++i) {
+            auto const p = pixel_at(surface, i, j);
+            sum.r += p.r;
+            sum.g += p.g;
+            sum.b += p.b;
+            sum.a += p.a;
+        }
+    }
+    return sum;
+}
+
+} // namespace
+
+TEST(DrawingLevelOfDetailTest, SplatKeepsColourAndCoverage)
+{
+    if (!Inkscape::Application::exists()) {
+        Inkscape::Application::create(false);
+    }
+
+    auto doc = std::unique_ptr<SPDocument>(SPDocument::createNewDocFromMem(svg, static_cast<int>(std::strlen(svg)), false));
+    ASSERT_TRUE(doc);
+    doc->ensureUpToDate();
+
+    auto const area = Geom::IntRect::from_xywh(0, 0, 40, 40);
+    auto const exact = Display(doc.get(), false).draw(area);
+    auto const splat = Display(doc.get(), true).draw(area);
+
+    // The exact triangle covers all of the pixel at its right angle and only part of the others,
+    // while its splat spreads the same ink evenly over its bounds.
+    EXPECT_GT(pixel_at(exact, 9, 9).a, pixel_at(exact, 10, 10).a + 10);
+    for (auto [x, y] : { std::pair{ 10, 9 }, std::pair{ 9, 10 }, std::pair{ 10, 10 } }) {
+        EXPECT_NEAR(pixel_at(splat, x, y).a, pixel_at(splat, 9, 9).a, 1) << "at " << x << "," << y;
+    }
+
+    for (auto [x, y] : { std::pair{ 10, 10 }, std::pair{ 20, 20 } }) {
+        auto const e = ink_around(exact, x, y);
+        auto const s = ink_around(splat, x, y);
+        EXPECT_GT(e.a, 0) << "around " << x << "," << y;
+        EXPECT_NEAR(s.a, e.a, 4) << "around " << x << "," << y;
+        EXPECT_NEAR(s.r, e.r, 4) << "around " << x << "," << y;
+        EXPECT_NEAR(s.g, e.g, 4) << "around " << x << "," << y;
+        EXPECT_NEAR(s.b, e.b, 4) << "around " << x << "," << y;
+    }
+
+    // The splats have the colour of their paint.
+    auto const fill = ink_around(splat, 10, 10);
+    EXPECT_EQ(fill.r, fill.a);
+    EXPECT_NEAR(fill.g * 2, fill.r, 4);
+    EXPECT_EQ(fill.b, 0);
+    auto const stroke = ink_around(splat, 20, 20);
+    EXPECT_EQ(stroke.r, 0);
+    EXPECT_EQ(stroke.g, 0);
+    EXPECT_EQ(stroke.b, stroke.a);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Test the paint servers used when rendering.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+#include <2geom/transforms.h>
+
+#include "display/drawing-paintserver.h"
+
+using namespace Inkscape;
+
+static auto paint(DrawingPaintServer const &server, int width, int height, bool dither,
+                  cairo_pattern_type_t *type = nullptr)
+{
+    auto cs = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+    auto cr = Cairo::Context::create(cs);
+    auto pat = server.create_pattern(cr->cobj(), Geom::Rect(0, 0, width, height), 0.8, dither);
+    if (type) {
+        *type = cairo_pattern_get_type(pat);
+    }
+    cairo_set_source(cr->cobj(), pat);
+    cairo_paint(cr->cobj());
+    cairo_pattern_destroy(pat);
+    cs->flush();
+    return cs;
+}
+
+static int max_difference(Cairo::RefPtr<Cairo::ImageSurface> const &a, Cairo::RefPtr<Cairo::ImageSurface> const &b)
+{
+    int result = 0;
+    for (int y = 0; y < a->get_height(); y++) {
+        auto p = a->get_data() + y * a->get_stride();
+        auto q = b->get_data() + y * b->get_stride();
+        for (int x = 0; x < a->get_width() * 4; x++) {
+            result = std::max(result, std::abs((int)p[x] - (int)q[x]));
+        }
+    }
+    return result;
+}
+
+static std::vector<SPGradientStop> smooth_stops()
+{
+    return {
+        { 0.0, SPColor(1.0, 0.0, 0.0), 1.0 },
+        { 0.3, SPColor(0.0, 1.0, 0.0), 0.5 },
+        { 1.0, SPColor(1.0, 1.0, 1.0), 0.0 },
+    };
+}
+
+static std::vector<SPGradientStop> hard_stops()
+{
+    return {
+        { 0.0, SPColor(1.0, 0.0, 0.0), 1.0 },
+        { 0.3, SPColor(0.0, 1.0, 0.0), 0.5 },
+        { 0.3, SPColor(0.0, 0.0, 1.0), 1.0 },
+        { 1.0, SPColor(1.0, 1.0, 1.0), 0.0 },
+    };
+}
+
+TEST(DrawingPaintServerTest, LinearGradientTableMatchesCairo)
+{
+    // When dithering, Cairo's own gradient is used, which serves as the reference.
+    // (Repeating gradients are left out, since their discontinuity is sampled slightly differently.)
+    for (auto spread : { SP_GRADIENT_SPREAD_PAD, SP_GRADIENT_SPREAD_REFLECT }) {
+        auto const gradient = DrawingLinearGradient(spread, SP_GRADIENT_UNITS_OBJECTBOUNDINGBOX, Geom::Rotate(0.3),
+                                                    0.2, 0.1, 0.6, 0.4, smooth_stops());
+        cairo_pattern_type_t table_type, reference_type;
+        auto const table = paint(gradient, 300, 200, false, &table_type);
+        auto const reference = paint(gradient, 300, 200, true, &reference_type);
+        ASSERT_EQ(table_type, CAIRO_PATTERN_TYPE_SURFACE);
+        ASSERT_EQ(reference_type, CAIRO_PATTERN_TYPE_LINEAR);
+        EXPECT_LE(max_difference(table, reference), 3);
+    }
+}
+
+TEST(DrawingPaintServerTest, LinearGradientHardStops)
+{
+    // A hard stop in a gradient shorter than the table is painted from it.
+    auto const short_gradient = DrawingLinearGradient(SP_GRADIENT_SPREAD_PAD, SP_GRADIENT_UNITS_USERSPACEONUSE,
+                                                      Geom::identity(), 0, 0, 400, 0, hard_stops());
+    cairo_pattern_type_t table_type;
+    auto const table = paint(short_gradient, 400, 1, false, &table_type);
+    auto const reference = paint(short_gradient, 400, 1, true);
+    ASSERT_EQ(table_type, CAIRO_PATTERN_TYPE_SURFACE);
+    // The table is sampled bilinearly, so the pixel straddling the stop may be blended.
+    int differing = 0;
+    for (int x = 0; x < 400 * 4; x++) {
+        differing += std::abs((int)table->get_data()[x] - (int)reference->get_data()[x]) > 3;
+    }
+    EXPECT_LE(differing, 4);
+
+    // In a gradient much longer than the table, it would be blurred, so Cairo's gradient is used.
+    auto const long_gradient = DrawingLinearGradient(SP_GRADIENT_SPREAD_PAD, SP_GRADIENT_UNITS_USERSPACEONUSE,
+                                                     Geom::identity(), 0, 0, 3000, 0, hard_stops());
+    paint(long_gradient, 3000, 1, false, &table_type);
+    EXPECT_EQ(table_type, CAIRO_PATTERN_TYPE_LINEAR);
+
+    // Smooth gradients that long still use the table.
+    auto const long_smooth = DrawingLinearGradient(SP_GRADIENT_SPREAD_PAD, SP_GRADIENT_UNITS_USERSPACEONUSE,
+                                                   Geom::identity(), 0, 0, 3000, 0, smooth_stops());
+    auto const long_table = paint(long_smooth, 3000, 1, false, &table_type);
+    auto const long_reference = paint(long_smooth, 3000, 1, true);
+    ASSERT_EQ(table_type, CAIRO_PATTERN_TYPE_SURFACE);
+    EXPECT_LE(max_difference(long_table, long_reference), 3);
+}
+
+TEST(DrawingPaintServerTest, LinearGradientTableShared)
+{
+    // Gradients made from the same stops share one table for each opacity.
+    auto const lut = std::make_shared<GradientLut>(smooth_stops());
+    auto const a = DrawingLinearGradient(SP_GRADIENT_SPREAD_PAD, SP_GRADIENT_UNITS_USERSPACEONUSE, Geom::identity(),
+                                         0, 0, 100, 0, smooth_stops(), lut);
+    auto const b = DrawingLinearGradient(SP_GRADIENT_SPREAD_REFLECT, SP_GRADIENT_UNITS_USERSPACEONUSE, Geom::Rotate(1),
+                                         10, 0, 50, 20, smooth_stops(), lut);
+    paint(a, 100, 10, false);
+    paint(b, 100, 10, false);
+
+    auto const table = lut->get(0.8);
+    auto const other = lut->get(0.5);
+    ASSERT_TRUE(table && other);
+    EXPECT_EQ(cairo_surface_get_reference_count(table), 2u);
+    EXPECT_NE(table, other);
+    cairo_surface_destroy(table);
+    cairo_surface_destroy(other);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -23,6 +23,7 @@
 #include "display/drawing.h"
 #include "display/drawing-surface.h"
 #include "display/drawing-context.h"
+#include "display/pattern-tile-cache.h"
 
 TEST(DrawingPatternTest, fragments)
 {
@@ -115,3 +116,25 @@ TEST(DrawingPatternTest, fragments)
 
     ASSERT_LE(maxdiff, 10);
 }
+
+TEST(DrawingPatternTest, TilesOutliveAllButLastUser)
+{
+    Inkscape::PatternTileCache cache;
+    cache.setBudget(1 << 20);
+
+    int content;
+    auto const key = Inkscape::PatternTileCache::Key{ .content = &content };
+
+    // Two views of the same pattern share its tiles.
+    cache.acquire(&content);
+    cache.acquire(&content);
+    auto const tiles = cache.get(key);
+
+    // Closing one view keeps them for the other.
+    cache.release(&content);
+    EXPECT_EQ(cache.get(key), tiles);
+
+    // Closing the last one drops them.
+    cache.release(&content);
+    EXPECT_NE(cache.get(key), tiles);
+}
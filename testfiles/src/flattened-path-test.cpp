@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Test the flattened paths that shapes are rendered from.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+#include <2geom/circle.h>
+#include <2geom/pathvector.h>
+#include <2geom/transforms.h>
+
+#include "display/cairo-utils.h"
+#include "display/drawing-context.h"
+#include "display/flattened-path.h"
+
+using namespace Inkscape;
+
+static auto render(Geom::IntRect const &area, bool stroke, std::function<void(DrawingContext &)> const &feed)
+{
+    auto cs = Cairo::ImageSurface::create(Cairo::FORMAT_A8, area.width(), area.height());
+    auto cr = Cairo::Context::create(cs);
+    {
+        DrawingContext dc(cr->cobj(), area.min());
+        feed(dc);
+        if (stroke) {
+            cairo_set_line_width(dc.raw(), 9.0);
+            cairo_set_line_join(dc.raw(), CAIRO_LINE_JOIN_ROUND);
+            cairo_set_line_cap(dc.raw(), CAIRO_LINE_CAP_SQUARE);
+            dc.stroke();
+        } else {
+            dc.fill();
+        }
+    }
+    cs->flush();
+    return cs;
+}
+
+static int max_difference(Cairo::RefPtr<Cairo::ImageSurface> const &a, Cairo::RefPtr<Cairo::ImageSurface> const &b)
+{
+    int result = 0;
+    for (int y = 0; y < a->get_height(); y++) {
+        auto p = a->get_data() + y * a->get_stride();
+        auto q = b->get_data() + y * b->get_stride();
+        for (int x = 0; x < a->get_width(); x++) {
+            result = std::max(result, std::abs((int)p[x] - (int)q[x]));
+        }
+    }
+    return result;
+}
+
+static Geom::PathVector test_path()
+{
+    Geom::PathVector pv;
+    pv.push_back(Geom::Path(Geom::Circle(200, 200, 180)));
+    pv.push_back(Geom::Path(Geom::Circle(150, 220, 60)));
+
+    // An open zigzag with many segments, crossing the circles.
+    Geom::Path zigzag(Geom::Point(10, 10));
+    for (int i = 1; i <= 200; i++) {
+        zigzag.appendNew<Geom::LineSegment>(Geom::Point(10 + 2 * i, i % 2 ? 40 + 1.8 * i : 10 + 1.8 * i));
+    }
+    pv.push_back(zigzag);
+    return pv;
+}
+
+TEST(FlattenedPathTest, MatchesCurves)
+{
+    auto const pv = test_path();
+    auto const ctm = Geom::Scale(2.0) * Geom::Rotate(0.2);
+    FlattenedPath const flat(pv, ctm, 0.1);
+    ASSERT_TRUE(flat.valid());
+
+    auto const area = Geom::IntRect(-200, -100, 800, 900);
+    for (bool stroke : { false, true }) {
+        auto const curves = render(area, stroke, [&] (DrawingContext &dc) {
+            dc.transform(ctm);
+            dc.path(pv);
+            dc.transform(ctm.inverse());
+        });
+        auto const flattened = render(area, stroke, [&] (DrawingContext &dc) { flat.feed(dc); });
+        EXPECT_LE(max_difference(curves, flattened), 8);
+    }
+}
+
+TEST(FlattenedPathTest, CulledTilesMatchWholePath)
+{
+    auto const pv = test_path();
+    auto const ctm = Geom::Scale(2.0) * Geom::Rotate(0.2);
+    FlattenedPath const flat(pv, ctm, 0.1);
+    ASSERT_TRUE(flat.valid());
+
+    // The line width is 9, with square caps and round joins.
+    double const margin = 4.5 * 1.5 + 1.0;
+
+    for (int y = -100; y < 900; y += 64) {
+        for (int x = -200; x < 800; x += 64) {
+            auto const tile = Geom::IntRect::from_xywh(x, y, 64, 64);
+            auto const whole_fill = render(tile, false, [&] (DrawingContext &dc) { flat.feed(dc); });
+            auto const culled_fill = render(tile, false, [&] (DrawingContext &dc) { flat.feedFill(dc, tile); });
+            EXPECT_EQ(max_difference(whole_fill, culled_fill), 0) << "fill at " << x << ", " << y;
+
+            auto const whole_stroke = render(tile, true, [&] (DrawingContext &dc) { flat.feed(dc); });
+            auto const culled_stroke = render(tile, true, [&] (DrawingContext &dc) { flat.feedStroke(dc, tile, margin); });
+            EXPECT_LE(max_difference(whole_stroke, culled_stroke), 1) << "stroke at " << x << ", " << y;
+        }
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test that the fast ways of applying feConvolveMatrix agree with applying the kernel directly.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "display/cairo-utils.h"
+#include "display/drawing-context.h"
+#include "display/drawing-item.h"
+#include "display/nr-filter-convolve-matrix.h"
+#include "display/nr-filter-slot.h"
+#include "display/nr-filter-units.h"
+
+using namespace Inkscape;
+using namespace Inkscape::Filters;
+
+namespace {
+
+int const WIDTH = 61;
+int const HEIGHT = 47;
+
+struct Params
+{
+    int orderX, orderY;
+    int targetX, targetY;
+    std::vector<double> kernel;
+    double divisor = 1.0;
+    double bias = 0.0;
+    bool preserveAlpha = false;
+    FilterConvolveMatrixEdgeMode edgeMode = CONVOLVEMATRIX_EDGEMODE_NONE;
+};
+
+// Random premultiplied pixels, with some fully transparent and some opaque.
+cairo_surface_t *random_surface(cairo_format_t format)
+{
+    auto surface = cairo_image_surface_create(format, WIDTH, HEIGHT);
+    auto data = cairo_image_surface_get_data(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int y = 0; y < HEIGHT; ++y) {
+        for (int x = 0; x < WIDTH; ++x) {
+            guint32 a = byte(gen);
+            a = a < 20 ? 0 : a > 235 ? 255 : a;
+            if (format == CAIRO_FORMAT_A8) {
+                data[y * stride + x] = a;
+            } else {
+                std::uniform_int_distribution<guint32> channel(0, a);
+                guint32 const r = channel(gen);
+                guint32 const g = channel(gen);
+                guint32 const b = channel(gen);
+                ASSEMBLE_ARGB32(px, a, r, g, b);
+                reinterpret_cast<guint32 *>(data + y * stride)[x] = px;
+            }
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+// Render the primitive on the input with the given method, and return a copy of its result.
+std::vector<unsigned char> render(cairo_surface_t *input, Params const &p, FilterConvolveMatrix::Method method)
+{
+    FilterConvolveMatrix primitive;
+    primitive.set_orderX(p.orderX);
+    primitive.set_orderY(p.orderY);
+    primitive.set_targetX(p.targetX);
+    primitive.set_targetY(p.targetY);
+    primitive.set_kernelMatrix(p.kernel);
+    primitive.set_divisor(p.divisor);
+    primitive.set_bias(p.bias);
+    primitive.set_preserveAlpha(p.preserveAlpha);
+    primitive.set_edgeMode(p.edgeMode);
+    primitive.set_method(method);
+    primitive.set_input(1);
+    primitive.set_output(2);
+
+    auto const area = Geom::Rect(0, 0, WIDTH, HEIGHT);
+    FilterUnits units(SP_FILTER_UNITS_USERSPACEONUSE, SP_FILTER_UNITS_USERSPACEONUSE);
+    units.set_ctm(Geom::identity());
+    units.set_item_bbox(area);
+    units.set_filter_area(area);
+    units.set_resolution(WIDTH, HEIGHT);
+    units.set_automatic_resolution(true);
+    units.set_paraller(false);
+
+    auto graphic_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, WIDTH, HEIGHT);
+    DrawingContext graphic(graphic_surface, Geom::Point(0, 0));
+    RenderContext rc{0};
+    FilterSlot slot(nullptr, graphic, units, rc, 0);
+    slot.set(1, input);
+
+    primitive.render_cairo(slot);
+
+    auto out = slot.getcairo(2);
+    cairo_surface_flush(out);
+    auto const data = cairo_image_surface_get_data(out);
+    int const stride = cairo_image_surface_get_stride(out);
+    int const row = cairo_image_surface_get_format(out) == CAIRO_FORMAT_A8 ? WIDTH : WIDTH * 4;
+    std::vector<unsigned char> result;
+    for (int y = 0; y < HEIGHT; ++y) {
+        result.insert(result.end(), data + y * stride, data + y * stride + row);
+    }
+    cairo_surface_destroy(graphic_surface);
+    return result;
+}
+
+// The largest difference between corresponding bytes; the paths may round differently by one.
+int max_difference(std::vector<unsigned char> const &a, std::vector<unsigned char> const &b)
+{
+    EXPECT_EQ(a.size(), b.size());
+    int result = 0;
+    for (std::size_t i = 0; i < std::min(a.size(), b.size()); ++i) {
+        result = std::max(result, std::abs(a[i] - b[i]));
+    }
+    return result;
+}
+
+// The outer product of a column and a row.
+std::vector<double> outer(std::vector<double> const &column, std::vector<double> const &row)
+{
+    std::vector<double> kernel;
+    for (auto c : column) {
+        for (auto r : row) {
+            kernel.push_back(c * r);
+        }
+    }
+    return kernel;
+}
+
+std::vector<double> random_kernel(int size)
+{
+    std::mt19937 gen(size);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+    std::vector<double> kernel(size);
+    for (auto &k : kernel) {
+        k = dist(gen);
+    }
+    return kernel;
+}
+
+void compare(Params p, FilterConvolveMatrix::Method method)
+{
+    for (auto format : { CAIRO_FORMAT_ARGB32, CAIRO_FORMAT_A8 }) {
+        auto input = random_surface(format);
+        for (auto edge : { CONVOLVEMATRIX_EDGEMODE_DUPLICATE, CONVOLVEMATRIX_EDGEMODE_WRAP, CONVOLVEMATRIX_EDGEMODE_NONE }) {
+            for (bool preserve : { false, true }) {
+                p.edgeMode = edge;
+                p.preserveAlpha = preserve;
+                auto const direct = render(input, p, FilterConvolveMatrix::Method::Direct);
+                auto const fast = render(input, p, method);
+                EXPECT_LE(max_difference(direct, fast), 1)
+                    << "order " << p.orderX << "x" << p.orderY << ", target " << p.targetX << "," << p.targetY
+                    << ", divisor " << p.divisor << ", bias " << p.bias << ", edge mode " << edge
+                    << ", preserveAlpha " << preserve << ", format " << format;
+            }
+        }
+        cairo_surface_destroy(input);
+    }
+}
+
+} // namespace
+
+TEST(FilterConvolveMatrixTest, SeparableMatchesDirect)
+{
+    // A box blur, a Sobel operator, and an asymmetric kernel with the target at its corners.
+    compare({ 3, 3, 1, 1, std::vector<double>(9, 1.0), 9.0 }, FilterConvolveMatrix::Method::Separable);
+    compare({ 3, 3, 1, 1, outer({ 1, 2, 1 }, { -1, 0, 1 }), 1.0, 0.5 }, FilterConvolveMatrix::Method::Separable);
+    for (auto [tx, ty] : { std::pair{ 0, 0 }, std::pair{ 4, 2 }, std::pair{ 1, 2 } }) {
+        compare({ 5, 3, tx, ty, outer({ 0.5, -1.5, 2 }, { 1, 3, -2, 0.25, 1 }), 2.5, -0.2 },
+                FilterConvolveMatrix::Method::Separable);
+    }
+}
+
+TEST(FilterConvolveMatrixTest, FftMatchesDirect)
+{
+    // Kernels large enough to be applied by FFT automatically, one of them wider than it is tall.
+    compare({ 15, 15, 7, 7, random_kernel(15 * 15), 4.0 }, FilterConvolveMatrix::Method::FFT);
+    for (auto [tx, ty] : { std::pair{ 0, 0 }, std::pair{ 16, 10 }, std::pair{ 3, 9 } }) {
+        compare({ 17, 11, tx, ty, random_kernel(17 * 11), -3.5, 0.25 }, FilterConvolveMatrix::Method::FFT);
+    }
+    // A kernel wider than the image, which leaves no interior for the FFT to compute.
+    compare({ WIDTH + 2, 5, 30, 2, random_kernel((WIDTH + 2) * 5), 10.0 }, FilterConvolveMatrix::Method::FFT);
+}
+
+TEST(FilterConvolveMatrixTest, AutomaticMatchesDirect)
+{
+    compare({ 3, 3, 1, 1, outer({ 1, 2, 1 }, { 1, 2, 1 }), 16.0 }, FilterConvolveMatrix::Method::Automatic);
+    compare({ 15, 15, 2, 12, random_kernel(15 * 15), 0.5, 0.1 }, FilterConvolveMatrix::Method::Automatic);
+    compare({ 4, 1, 3, 0, { 1, -1, 2, 0.5 } }, FilterConvolveMatrix::Method::Automatic);
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,241 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test that the ways of applying feGaussianBlur agree with each other.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "display/cairo-utils.h"
+#include "display/drawing-context.h"
+#include "display/drawing-item.h"
+#include "display/nr-filter-gaussian.h"
+#include "display/nr-filter-slot.h"
+#include "display/nr-filter-units.h"
+
+using namespace Inkscape;
+using namespace Inkscape::Filters;
+
+namespace {
+
+// Pixels of one format, row by row without padding.
+struct Image
+{
+    cairo_format_t format;
+    int width, height;
+    std::vector<unsigned char> data;
+
+    int bpp() const { return format == CAIRO_FORMAT_A8 ? 1 : 4; }
+    unsigned char *pixel(int x, int y) { return data.data() + (y * width + x) * bpp(); }
+    unsigned char const *pixel(int x, int y) const { return data.data() + (y * width + x) * bpp(); }
+};
+
+Image transposed(Image const &image)
+{
+    Image result{ image.format, image.height, image.width, std::vector<unsigned char>(image.data.size()) };
+    for (int y = 0; y < image.height; ++y) {
+        for (int x = 0; x < image.width; ++x) {
+            std::copy_n(image.pixel(x, y), image.bpp(), result.pixel(y, x));
+        }
+    }
+    return result;
+}
+
+// Random premultiplied pixels, with some fully transparent and some opaque.
+Image random_image(cairo_format_t format, int width, int height)
+{
+    Image image{ format, width, height, {} };
+    std::mt19937 gen(width * height);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int i = 0; i < width * height; ++i) {
+        guint32 a = byte(gen);
+        a = a < 20 ? 0 : a > 235 ? 255 : a;
+        image.data.push_back(a);
+        if (format == CAIRO_FORMAT_ARGB32) {
+            std::uniform_int_distribution<guint32> channel(0, a);
+            guint32 const r = channel(gen);
+            guint32 const g = channel(gen);
+            guint32 const b = channel(gen);
+            ASSEMBLE_ARGB32(px, a, r, g, b);
+            image.data.resize(image.data.size() + 3);
+            *reinterpret_cast<guint32 *>(image.data.data() + image.data.size() - 4) = px;
+        }
+    }
+    return image;
+}
+
+// Opaque rectangles of different colours on a transparent background, whose hard edges show the
+// difference between the Gaussian and its approximations the most.
+Image rectangles_image(cairo_format_t format, int width, int height)
+{
+    auto surface = cairo_image_surface_create(format, width, height);
+    auto ct = cairo_create(surface);
+    cairo_set_source_rgba(ct, 1, 0, 0, 1);
+    cairo_rectangle(ct, width / 8, height / 8, width / 3, height / 2);
+    cairo_fill(ct);
+    cairo_set_source_rgba(ct, 0, 0.5, 1, 0.75);
+    cairo_rectangle(ct, width / 2, height / 3, width / 3, height / 3);
+    cairo_fill(ct);
+    cairo_set_source_rgba(ct, 0, 1, 0, 1);
+    cairo_rectangle(ct, width / 4, height * 3 / 4, 3, height / 8);
+    cairo_fill(ct);
+    cairo_destroy(ct);
+    cairo_surface_flush(surface);
+
+    Image image{ format, width, height, {} };
+    auto const data = cairo_image_surface_get_data(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+    for (int y = 0; y < height; ++y) {
+        image.data.insert(image.data.end(), data + y * stride, data + y * stride + width * image.bpp());
+    }
+    cairo_surface_destroy(surface);
+    return image;
+}
+
+// Blur the image at the given quality with the given method, and return a copy of the result.
+Image blur(Image const &image, double deviation_x, double deviation_y, int quality,
+           FilterGaussian::Method method = FilterGaussian::Method::Automatic)
+{
+    auto input = cairo_image_surface_create(image.format, image.width, image.height);
+    auto const in_data = cairo_image_surface_get_data(input);
+    int const in_stride = cairo_image_surface_get_stride(input);
+    for (int y = 0; y < image.height; ++y) {
+        std::copy_n(image.pixel(0, y), image.width * image.bpp(), in_data + y * in_stride);
+    }
+    cairo_surface_mark_dirty(input);
+
+    FilterGaussian primitive;
+    primitive.set_deviation(deviation_x, deviation_y);
+    primitive.set_method(method);
+    primitive.set_input(1);
+    primitive.set_output(2);
+
+    auto const area = Geom::Rect(0, 0, image.width, image.height);
+    FilterUnits units(SP_FILTER_UNITS_USERSPACEONUSE, SP_FILTER_UNITS_USERSPACEONUSE);
+    units.set_ctm(Geom::identity());
+    units.set_item_bbox(area);
+    units.set_filter_area(area);
+    units.set_resolution(image.width, image.height);
+    units.set_automatic_resolution(true);
+    units.set_paraller(false);
+
+    auto graphic_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, image.width, image.height);
+    DrawingContext graphic(graphic_surface, Geom::Point(0, 0));
+    RenderContext rc{0};
+    FilterSlot slot(nullptr, graphic, units, rc, quality);
+    slot.set(1, input);
+
+    primitive.render_cairo(slot);
+
+    auto out = slot.getcairo(2);
+    cairo_surface_flush(out);
+    Image result{ image.format, image.width, image.height, {} };
+    auto const data = cairo_image_surface_get_data(out);
+    int const stride = cairo_image_surface_get_stride(out);
+    for (int y = 0; y < image.height; ++y) {
+        result.data.insert(result.data.end(), data + y * stride, data + y * stride + image.width * image.bpp());
+    }
+    cairo_surface_destroy(graphic_surface);
+    cairo_surface_destroy(input);
+    return result;
+}
+
+int max_difference(Image const &a, Image const &b)
+{
+    EXPECT_EQ(a.data.size(), b.data.size());
+    int result = 0;
+    for (std::size_t i = 0; i < std::min(a.data.size(), b.data.size()); ++i) {
+        result = std::max(result, std::abs(a.data[i] - b.data[i]));
+    }
+    return result;
+}
+
+double mean_difference(Image const &a, Image const &b)
+{
+    EXPECT_EQ(a.data.size(), b.data.size());
+    double sum = 0;
+    for (std::size_t i = 0; i < std::min(a.data.size(), b.data.size()); ++i) {
+        sum += std::abs(a.data[i] - b.data[i]);
+    }
+    return a.data.empty() ? 0.0 : sum / a.data.size();
+}
+
+} // namespace
+
+TEST(FilterGaussianTest, BlockedIirMatchesPerColumn)
+{
+    // The vertical pass filters blocks of adjacent columns together, while the horizontal pass still
+    // filters one row at a time like every pass used to. So blurring vertically must give the same
+    // result as blurring the transposed image horizontally. The image heights are not multiples of
+    // the block size, so the last block is a partial one.
+    for (auto format : { CAIRO_FORMAT_ARGB32, CAIRO_FORMAT_A8 }) {
+        auto const image = random_image(format, 61, 47);
+        for (double deviation : { 3.5, 8.0, 30.0 }) {
+            auto const blocked = blur(image, 0, deviation, BLUR_QUALITY_BEST, FilterGaussian::Method::IIR);
+            auto const per_column =
+                transposed(blur(transposed(image), deviation, 0, BLUR_QUALITY_BEST, FilterGaussian::Method::IIR));
+            EXPECT_LE(max_difference(blocked, per_column), 1) << "deviation " << deviation << ", format " << format;
+        }
+    }
+}
+
+TEST(FilterGaussianTest, BoxCascadeApproximatesGaussian)
+{
+    for (auto format : { CAIRO_FORMAT_ARGB32, CAIRO_FORMAT_A8 }) {
+        auto const image = rectangles_image(format, 160, 120);
+        for (double deviation : { 3.5, 6.0, 15.0 }) {
+            auto const exact = blur(image, deviation, deviation, BLUR_QUALITY_BEST, FilterGaussian::Method::IIR);
+            auto const box = blur(image, deviation, deviation, BLUR_QUALITY_BEST, FilterGaussian::Method::Box);
+            EXPECT_LE(max_difference(exact, box), 8) << "deviation " << deviation << ", format " << format;
+            EXPECT_LE(mean_difference(exact, box), 1.0) << "deviation " << deviation << ", format " << format;
+        }
+    }
+}
+
+TEST(FilterGaussianTest, AutomaticMatchesIirAtBestQuality)
+{
+    for (auto format : { CAIRO_FORMAT_ARGB32, CAIRO_FORMAT_A8 }) {
+        auto const image = random_image(format, 53, 70);
+        auto const automatic = blur(image, 5.0, 12.0, BLUR_QUALITY_BEST);
+        auto const iir = blur(image, 5.0, 12.0, BLUR_QUALITY_BEST, FilterGaussian::Method::IIR);
+        EXPECT_EQ(max_difference(automatic, iir), 0) << "format " << format;
+    }
+}
+
+// Not run by default: prints the time taken to blur a screen-sized image for radii of 1 to 500 px at
+// every quality. Run with --gtest_also_run_disabled_tests to compare changes to the blur.
+TEST(FilterGaussianTest, DISABLED_Timings)
+{
+    auto const image = rectangles_image(CAIRO_FORMAT_ARGB32, 1920, 1080);
+    for (int quality = BLUR_QUALITY_WORST; quality <= BLUR_QUALITY_BEST; ++quality) {
+        for (double radius : { 1, 2, 5, 10, 20, 50, 100, 200, 500 }) {
+            auto const start = std::chrono::steady_clock::now();
+            blur(image, radius, radius, quality);
+            auto const end = std::chrono::steady_clock::now();
+            std::cout << "quality " << quality << ", radius " << radius << ": "
+                      << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+        }
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
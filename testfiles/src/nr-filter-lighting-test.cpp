@@ -0,0 +1,362 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test that the lighting primitives give the same results as the per-pixel renderer they replaced.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <2geom/affine.h>
+#include <2geom/point.h>
+
+#include "display/cairo-templates.h"
+#include "display/cairo-utils.h"
+#include "display/nr-3dutils.h"
+#include "display/nr-filter-lighting.h"
+#include "display/nr-filter-utils.h"
+#include "display/nr-light.h"
+
+using namespace Inkscape::Filters;
+
+namespace {
+
+int const WIDTH = 61;
+int const HEIGHT = 47;
+guint32 const COLOR = 0xffc080ff;
+
+// The bump map the lighting primitives used to read from, pixel by pixel.
+struct ReferenceBumpMap : public SurfaceSynth
+{
+    ReferenceBumpMap(cairo_surface_t *surface)
+        : SurfaceSynth(surface) {}
+
+    // The surface normal, as SurfaceSynth computed it from the 3x3 Sobel gradient before BumpMap replaced it.
+    NR::Fvector surfaceNormalAt(int x, int y, double scale) const {
+        // Below there are some multiplies by zero. They will be optimized out.
+        // Do not remove them, because they improve readability.
+        // NOTE: fetching using alphaAt is slightly lazy.
+        NR::Fvector normal;
+        double fx = -scale/255.0, fy = -scale/255.0;
+        normal[Z_3D] = 1.0;
+        if (G_UNLIKELY(x == 0)) {
+            // leftmost column
+            if (G_UNLIKELY(y == 0)) {
+                // upper left corner
+                fx *= (2.0/3.0);
+                fy *= (2.0/3.0);
+                double p00 = alphaAt(x,y),   p10 = alphaAt(x+1, y),
+                       p01 = alphaAt(x,y+1), p11 = alphaAt(x+1, y+1);
+                normal[X_3D] =
+                    -2.0 * p00 +2.0 * p10
+                    -1.0 * p01 +1.0 * p11;
+                normal[Y_3D] = 
+                    -2.0 * p00 -1.0 * p10
+                    +2.0 * p01 +1.0 * p11;
+            } else if (G_UNLIKELY(y == (_h - 1))) {
+                // lower left corner
+                fx *= (2.0/3.0);
+                fy *= (2.0/3.0);
+                double p00 = alphaAt(x,y-1), p10 = alphaAt(x+1, y-1),
+                       p01 = alphaAt(x,y  ), p11 = alphaAt(x+1, y);
+                normal[X_3D] =
+                    -1.0 * p00 +1.0 * p10
+                    -2.0 * p01 +2.0 * p11;
+                normal[Y_3D] = 
+                    -2.0 * p00 -1.0 * p10
+                    +2.0 * p01 +1.0 * p11;
+            } else {
+                // leftmost column
+                fx *= (1.0/2.0);
+                fy *= (1.0/3.0);
+                double p00 = alphaAt(x, y-1), p10 = alphaAt(x+1, y-1),
+                       p01 = alphaAt(x, y  ), p11 = alphaAt(x+1, y  ),
+                       p02 = alphaAt(x, y+1), p12 = alphaAt(x+1, y+1);
+                normal[X_3D] =
+                    -1.0 * p00 +1.0 * p10
+                    -2.0 * p01 +2.0 * p11
+                    -1.0 * p02 +1.0 * p12;
+                normal[Y_3D] =
+                    -2.0 * p00 -1.0 * p10
+                    +0.0 * p01 +0.0 * p11 // this will be optimized out
+                    +2.0 * p02 +1.0 * p12;
+            }
+        } else if (G_UNLIKELY(x == (_w - 1))) {
+            // rightmost column
+            if (G_UNLIKELY(y == 0)) {
+                // top right corner
+                fx *= (2.0/3.0);
+                fy *= (2.0/3.0);
+                double p00 = alphaAt(x-1,y),   p10 = alphaAt(x, y),
+                       p01 = alphaAt(x-1,y+1), p11 = alphaAt(x, y+1);
+                normal[X_3D] =
+                    -2.0 * p00 +2.0 * p10
+                    -1.0 * p01 +1.0 * p11;
+                normal[Y_3D] = 
+                    -1.0 * p00 -2.0 * p10
+                    +1.0 * p01 +2.0 * p11;
+            } else if (G_UNLIKELY(y == (_h - 1))) {
+                // bottom right corner
+                fx *= (2.0/3.0);
+                fy *= (2.0/3.0);
+                double p00 = alphaAt(x-1,y-1), p10 = alphaAt(x, y-1),
+                       p01 = alphaAt(x-1,y  ), p11 = alphaAt(x, y);
+                normal[X_3D] =
+                    -1.0 * p00 +1.0 * p10
+                    -2.0 * p01 +2.0 * p11;
+                normal[Y_3D] = 
+                    -1.0 * p00 -2.0 * p10
+                    +1.0 * p01 +2.0 * p11;
+            } else {
+                // rightmost column
+                fx *= (1.0/2.0);
+                fy *= (1.0/3.0);
+                double p00 = alphaAt(x-1, y-1), p10 = alphaAt(x, y-1),
+                       p01 = alphaAt(x-1, y  ), p11 = alphaAt(x, y  ),
+                       p02 = alphaAt(x-1, y+1), p12 = alphaAt(x, y+1);
+                normal[X_3D] =
+                    -1.0 * p00 +1.0 * p10
+                    -2.0 * p01 +2.0 * p11
+                    -1.0 * p02 +1.0 * p12;
+                normal[Y_3D] =
+                    -1.0 * p00 -2.0 * p10
+                    +0.0 * p01 +0.0 * p11
+                    +1.0 * p02 +2.0 * p12;
+            }
+        } else {
+            // interior
+            if (G_UNLIKELY(y == 0)) {
+                // top row
+                fx *= (1.0/3.0);
+                fy *= (1.0/2.0);
+                double p00 = alphaAt(x-1, y  ), p10 = alphaAt(x, y  ), p20 = alphaAt(x+1, y  ),
+                       p01 = alphaAt(x-1, y+1), p11 = alphaAt(x, y+1), p21 = alphaAt(x+1, y+1);
+                normal[X_3D] =
+                    -2.0 * p00 +0.0 * p10 +2.0 * p20
+                    -1.0 * p01 +0.0 * p11 +1.0 * p21;
+                normal[Y_3D] =
+                    -1.0 * p00 -2.0 * p10 -1.0 * p20
+                    +1.0 * p01 +2.0 * p11 +1.0 * p21;
+            } else if (G_UNLIKELY(y == (_h - 1))) {
+                // bottom row
+                fx *= (1.0/3.0);
+                fy *= (1.0/2.0);
+                double p00 = alphaAt(x-1, y-1), p10 = alphaAt(x, y-1), p20 = alphaAt(x+1, y-1),
+                       p01 = alphaAt(x-1, y  ), p11 = alphaAt(x, y  ), p21 = alphaAt(x+1, y  );
+                normal[X_3D] =
+                    -1.0 * p00 +0.0 * p10 +1.0 * p20
+                    -2.0 * p01 +0.0 * p11 +2.0 * p21;
+                normal[Y_3D] =
+                    -1.0 * p00 -2.0 * p10 -1.0 * p20
+                    +1.0 * p01 +2.0 * p11 +1.0 * p21;
+            } else {
+                // interior pixels
+                // note: p11 is actually unused, so we don't fetch its value
+                fx *= (1.0/4.0);
+                fy *= (1.0/4.0);
+                double p00 = alphaAt(x-1, y-1), p10 = alphaAt(x, y-1), p20 = alphaAt(x+1, y-1),
+                       p01 = alphaAt(x-1, y  ), p11 = 0.0,             p21 = alphaAt(x+1, y  ),
+                       p02 = alphaAt(x-1, y+1), p12 = alphaAt(x, y+1), p22 = alphaAt(x+1, y+1);
+                normal[X_3D] =
+                    -1.0 * p00 +0.0 * p10 +1.0 * p20
+                    -2.0 * p01 +0.0 * p11 +2.0 * p21
+                    -1.0 * p02 +0.0 * p12 +1.0 * p22;
+                normal[Y_3D] =
+                    -1.0 * p00 -2.0 * p10 -1.0 * p20
+                    +0.0 * p01 +0.0 * p11 +0.0 * p21
+                    +1.0 * p02 +2.0 * p12 +1.0 * p22;
+            }
+        }
+        normal[X_3D] *= fx;
+        normal[Y_3D] *= fy;
+        NR::normalize_vector(normal);
+        return normal;
+    }
+};
+
+// A bump map with smooth hills, hard edges, flat areas and noise, touching every edge of the surface.
+cairo_surface_t *bump_surface()
+{
+    auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, WIDTH, HEIGHT);
+    auto ct = cairo_create(surface);
+    auto gradient = cairo_pattern_create_radial(20, 20, 0, 20, 20, 25);
+    cairo_pattern_add_color_stop_rgba(gradient, 0, 0, 0, 0, 1);
+    cairo_pattern_add_color_stop_rgba(gradient, 1, 0, 0, 0, 0);
+    cairo_set_source(ct, gradient);
+    cairo_paint(ct);
+    cairo_pattern_destroy(gradient);
+    cairo_set_source_rgba(ct, 0, 0, 0, 0.6);
+    cairo_rectangle(ct, 35, 5, 30, 20);
+    cairo_fill(ct);
+    cairo_destroy(ct);
+    cairo_surface_flush(surface);
+
+    auto const data = cairo_image_surface_get_data(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (int y = HEIGHT / 2; y < HEIGHT; ++y) {
+        for (int x = WIDTH / 2; x < WIDTH; ++x) {
+            guint32 const a = byte(gen);
+            ASSEMBLE_ARGB32(px, a, 0, 0, 0);
+            reinterpret_cast<guint32 *>(data + y * stride)[x] = px;
+        }
+    }
+    cairo_surface_mark_dirty(surface);
+    return surface;
+}
+
+// The pixel the removed renderer computed from a surface normal and light, for either primitive.
+guint32 reference_pixel(bool specular, NR::Fvector const &normal, NR::Fvector const &light,
+                        NR::Fvector const &light_components, double constant, double exponent)
+{
+    double k;
+    if (specular) {
+        NR::Fvector halfway;
+        NR::normalized_sum(halfway, light, NR::EYE_VECTOR);
+        double const sp = NR::scalar_product(normal, halfway);
+        k = sp <= 0.0 ? 0.0 : constant * std::pow(sp, exponent);
+    } else {
+        k = constant * NR::scalar_product(normal, light);
+    }
+
+    guint32 r = CLAMP_D_TO_U8(k * light_components[LIGHT_RED]);
+    guint32 g = CLAMP_D_TO_U8(k * light_components[LIGHT_GREEN]);
+    guint32 b = CLAMP_D_TO_U8(k * light_components[LIGHT_BLUE]);
+    guint32 a = 255;
+    if (specular) {
+        a = std::max(std::max(r, g), b);
+        r = premul_alpha(r, a);
+        g = premul_alpha(g, a);
+        b = premul_alpha(b, a);
+    }
+    ASSEMBLE_ARGB32(pxout, a, r, g, b)
+    return pxout;
+}
+
+// The light at each pixel: its unit vector and its colour.
+using LightAt = std::function<void (int x, int y, double z, NR::Fvector &light, NR::Fvector &components)>;
+
+// Render the lighting of the surface the way the removed renderer did.
+cairo_surface_t *reference_render(cairo_surface_t *input, bool specular, LightAt const &light_at,
+                                  double scale, double constant, double exponent)
+{
+    auto out = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, WIDTH, HEIGHT);
+    ReferenceBumpMap bumpmap(input);
+    auto const data = cairo_image_surface_get_data(out);
+    int const stride = cairo_image_surface_get_stride(out);
+    for (int y = 0; y < HEIGHT; ++y) {
+        for (int x = 0; x < WIDTH; ++x) {
+            NR::Fvector light, components;
+            light_at(x, y, scale * bumpmap.alphaAt(x, y) / 255.0, light, components);
+            reinterpret_cast<guint32 *>(data + y * stride)[x] =
+                reference_pixel(specular, bumpmap.surfaceNormalAt(x, y, scale), light, components, constant, exponent);
+        }
+    }
+    cairo_surface_mark_dirty(out);
+    return out;
+}
+
+// The largest difference between corresponding channels of two surfaces.
+int max_difference(cairo_surface_t *a, cairo_surface_t *b)
+{
+    cairo_surface_flush(a);
+    cairo_surface_flush(b);
+    int result = 0;
+    for (int y = 0; y < HEIGHT; ++y) {
+        auto const row_a = cairo_image_surface_get_data(a) + y * cairo_image_surface_get_stride(a);
+        auto const row_b = cairo_image_surface_get_data(b) + y * cairo_image_surface_get_stride(b);
+        for (int i = 0; i < WIDTH * 4; ++i) {
+            result = std::max(result, std::abs(row_a[i] - row_b[i]));
+        }
+    }
+    return result;
+}
+
+struct Lights
+{
+    DistantLightData distant{ 30, 40 };
+    PointLightData point{ 20, 10, 30 };
+    SpotLightData spot{ 50, -10, 60, 30, 30, 0, 40, 2 };
+};
+
+// Compare both renderers for every type of light, at the given surface scale.
+void compare(bool specular, double scale, double constant, double exponent)
+{
+    auto input = bump_surface();
+    auto const trans = Geom::identity();
+    auto const origin = Geom::Point(0, 0);
+    Lights lights;
+    BumpMap const bumpmap(input);
+
+    auto check = [&] (LightSource const &source, LightAt const &light_at, char const *name) {
+        auto out = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, WIDTH, HEIGHT);
+        if (specular) {
+            render_specular_lighting(out, bumpmap, source, scale, constant, exponent);
+        } else {
+            render_diffuse_lighting(out, bumpmap, source, scale, constant);
+        }
+        auto reference = reference_render(input, specular, light_at, scale, constant, exponent);
+        EXPECT_LE(max_difference(out, reference), 1)
+            << name << (specular ? " specular" : " diffuse") << ", scale " << scale << ", exponent " << exponent;
+        cairo_surface_destroy(reference);
+        cairo_surface_destroy(out);
+    };
+
+    DistantLight distant(lights.distant, COLOR);
+    check(LightSource(lights.distant, COLOR), [&] (int, int, double, NR::Fvector &light, NR::Fvector &components) {
+        distant.light_vector(light);
+        distant.light_components(components);
+    }, "distant");
+
+    PointLight point(lights.point, COLOR, trans, 1);
+    check(LightSource(lights.point, COLOR, trans, origin, 1), [&] (int x, int y, double z, NR::Fvector &light, NR::Fvector &components) {
+        point.light_vector(light, x, y, z);
+        point.light_components(components);
+    }, "point");
+
+    SpotLight spot(lights.spot, COLOR, trans, 1);
+    check(LightSource(lights.spot, COLOR, trans, origin, 1), [&] (int x, int y, double z, NR::Fvector &light, NR::Fvector &components) {
+        spot.light_vector(light, x, y, z);
+        spot.light_components(components, light);
+    }, "spot");
+
+    cairo_surface_destroy(input);
+}
+
+} // namespace
+
+TEST(FilterLightingTest, DiffuseMatchesPerPixelRenderer)
+{
+    for (double scale : { 1.0, 5.0, -3.0 }) {
+        compare(false, scale, 1.3, 1.0);
+    }
+}
+
+TEST(FilterLightingTest, SpecularMatchesPerPixelRenderer)
+{
+    for (double scale : { 1.0, 5.0, -3.0 }) {
+        for (double exponent : { 1.0, 8.0, 30.0 }) {
+            compare(true, scale, 1.2, exponent);
+        }
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test that feTurbulence rendered from cached cells matches the noise computed directly.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+#include <2geom/transforms.h>
+
+#include "display/cairo-utils.h"
+#include "display/drawing-context.h"
+#include "display/drawing-item.h"
+#include "display/nr-filter-slot.h"
+#include "display/nr-filter-turbulence.h"
+#include "display/nr-filter-units.h"
+
+using namespace Inkscape;
+using namespace Inkscape::Filters;
+
+namespace {
+
+std::size_t const BUDGET = std::size_t{64} << 20;
+
+// Render the turbulence over the given screen pixels, and return a copy of them.
+std::vector<guint32> render(FilterTurbulence &primitive, Geom::Affine const &ctm, Geom::IntRect const &rect)
+{
+    auto const area = Geom::Rect(rect) * ctm.inverse();
+    FilterUnits units(SP_FILTER_UNITS_USERSPACEONUSE, SP_FILTER_UNITS_USERSPACEONUSE);
+    units.set_ctm(ctm);
+    units.set_item_bbox(area);
+    units.set_filter_area(area);
+    units.set_resolution(rect.width(), rect.height());
+    units.set_automatic_resolution(true);
+    units.set_paraller(false);
+
+    auto graphic_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, rect.width(), rect.height());
+    DrawingContext graphic(graphic_surface, Geom::Point(rect.min()));
+    RenderContext rc{0};
+    FilterSlot slot(nullptr, graphic, units, rc, 0, BUDGET);
+    auto input = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, rect.width(), rect.height());
+    slot.set(1, input);
+
+    primitive.set_input(1);
+    primitive.set_output(2);
+    primitive.render_cairo(slot);
+
+    auto out = slot.getcairo(2);
+    cairo_surface_flush(out);
+    auto const data = cairo_image_surface_get_data(out);
+    int const stride = cairo_image_surface_get_stride(out);
+    std::vector<guint32> result;
+    for (int y = 0; y < rect.height(); ++y) {
+        auto const row = reinterpret_cast<guint32 const *>(data + y * stride);
+        result.insert(result.end(), row, row + rect.width());
+    }
+    cairo_surface_destroy(input);
+    cairo_surface_destroy(graphic_surface);
+    return result;
+}
+
+// Render the rect at once, which uses cached cells, and one row at a time, which is too small to
+// be worth caching and so computes the noise directly. The results must be identical.
+void compare(FilterTurbulence &primitive, Geom::Affine const &ctm, Geom::IntRect const &rect)
+{
+    auto const cached = render(primitive, ctm, rect);
+    ASSERT_EQ(cached.size(), static_cast<std::size_t>(rect.width() * rect.height()));
+    for (int y = 0; y < rect.height(); ++y) {
+        auto const row = Geom::IntRect::from_xywh(rect.left(), rect.top() + y, rect.width(), 1);
+        auto const direct = render(primitive, ctm, row);
+        for (int x = 0; x < rect.width(); ++x) {
+            ASSERT_EQ(cached[y * rect.width() + x], direct[x])
+                << "at " << rect.left() + x << "," << rect.top() + y << " of " << rect;
+        }
+    }
+}
+
+} // namespace
+
+TEST(FilterTurbulenceTest, CachedCellsMatchDirectRendering)
+{
+    for (auto type : { TURBULENCE_TURBULENCE, TURBULENCE_FRACTALNOISE }) {
+        FilterTurbulence primitive;
+        primitive.set_baseFrequency(0, 0.05);
+        primitive.set_baseFrequency(1, 0.03);
+        primitive.set_numOctaves(3);
+        primitive.set_seed(7);
+        primitive.set_type(type);
+
+        auto const view = Geom::IntRect::from_xywh(0, 0, 300, 200);
+        compare(primitive, Geom::identity(), view);
+
+        // Panning by a distance that is not a multiple of the cell size, into negative coordinates,
+        // reuses some of the cells and generates the rest.
+        auto const panned = view + Geom::IntPoint(130, -70);
+        compare(primitive, Geom::identity(), panned);
+        compare(primitive, Geom::identity(), view);
+
+        // A new transform makes new cells.
+        auto const zoomed = Geom::Affine(Geom::Scale(1.5)) * Geom::Translate(-20, 10);
+        compare(primitive, zoomed, panned);
+        compare(primitive, zoomed, view);
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -11,6 +11,14 @@
  * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
  */
 
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <set>
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <doc-per-case-test.h>
 
@@ -21,6 +29,28 @@
 using namespace Inkscape;
 using namespace Inkscape::XML;
 
+// Count the bytes allocated by the whole test program, to measure the memory of documents.
+static std::atomic<std::size_t> allocated_bytes = 0;
+
+void *operator new(std::size_t size)
+{
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (auto p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
 class ObjectTest: public DocPerCaseTest {
 public:
     ObjectTest() {
@@ -197,3 +227,51 @@ TEST_F(ObjectTest, StyleFontSizes) {
     // 50% is 118.59 == ((300^2 + 150^2) / 2)^0.5 * 0.5
     EXPECT_FLOAT_EQ(eight->style->stroke_width.computed, 118.58541);
 }
+
+/*
+ * Test that the objects of a large generated document share their font variants, and measure the
+ * heap memory that giving every style its own copy would take.
+ */
+TEST_F(ObjectTest, SharedFontVariantsMemory) {
+    int constexpr count = 20000;
+    std::string svg = "<svg xmlns='http://www.w3.org/2000/svg'>";
+    for (int i = 0; i < count / 100; i++) {
+        svg += i % 10 ? "<g>" : "<g style='font-variant-caps:small-caps'>";
+        for (int j = 0; j < 99; j++) {
+            svg += j % 50 ? "<rect width='1' height='1'/>" : "<text style='font-variant-numeric:ordinal'>x</text>";
+        }
+        svg += "</g>";
+    }
+    svg += "</svg>";
+
+    auto const before_load = allocated_bytes.load();
+    auto big = std::unique_ptr<SPDocument>(SPDocument::createNewDocFromMem(svg.c_str(), static_cast<int>(svg.size()), false));
+    big->ensureUpToDate();
+    auto const document_bytes = allocated_bytes.load() - before_load;
+
+    std::vector<SPStyle *> styles;
+    std::set<SPStyle::FontVariants const *> blocks;
+    for (auto &group : big->getRoot()->children) {
+        for (auto &child : group.children) {
+            ASSERT_TRUE(child.style);
+            blocks.insert(&child.style->fontVariants());
+            styles.push_back(child.style);
+        }
+    }
+    ASSERT_GE(styles.size(), static_cast<std::size_t>(count * 99 / 100));
+
+    // Plain, small caps, ordinal, and both.
+    EXPECT_LE(blocks.size(), 4u);
+
+    // Give every style its own copy, and count what it allocates.
+    auto const before_unshare = allocated_bytes.load();
+    for (auto style : styles) {
+        style->writableFontVariants();
+    }
+    auto const unshared_bytes = allocated_bytes.load() - before_unshare;
+
+    RecordProperty("document_bytes", std::to_string(document_bytes));
+    RecordProperty("font_variants_unshared_bytes", std::to_string(unshared_bytes));
+    EXPECT_GE(unshared_bytes, styles.size() * sizeof(SPStyle::FontVariants));
+    EXPECT_LT(blocks.size() * sizeof(SPStyle::FontVariants) * 100, unshared_bytes);
+}
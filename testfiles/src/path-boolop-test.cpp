@@ -83,4 +83,25 @@ TEST_F(PathBoolopTest, DifferenceOutside){
     comparePaths(pvRectangleDifference, pvBothPaths);
 }
 
+TEST_F(PathBoolopTest, UnionMany){
+    // test that an n-ary union merges overlapping inputs and keeps disjoint ones apart,
+    // with the same result whether or not the disjoint clusters are processed concurrently
+    std::vector<Geom::PathVector> pathvs;
+    for (int i = 0; i < 10; i++) {
+        for (int j = 0; j < 10; j++) {
+            // a unit square, plus a smaller one overlapping its corner
+            pathvs.push_back(sp_svg_read_pathv(("M " + std::to_string(3 * i) + "," + std::to_string(3 * j) + " h 1 v 1 h -1 z").c_str()));
+            pathvs.push_back(sp_svg_read_pathv(("M " + std::to_string(3 * i + 0.5) + "," + std::to_string(3 * j + 0.5) + " h 1 v 1 h -1 z").c_str()));
+        }
+    }
+    std::vector<FillRule> fill_rules(pathvs.size(), fill_nonZero);
+
+    auto serial = sp_pathvector_union(pathvs, fill_rules, 1);
+    auto parallel = sp_pathvector_union(pathvs, fill_rules, 4);
+
+    EXPECT_EQ(serial.size(), 100u);
+    EXPECT_EQ(*serial.boundsExact(), Geom::Rect(0, 0, 28.5, 28.5));
+    comparePaths(parallel, serial);
+}
+
 //
\ No newline at end of file
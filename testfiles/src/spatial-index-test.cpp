@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/**
+ * @file
+ * Test the spatial index from src/util
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <random>
+#include <2geom/int-rect.h>
+
+#include "util/spatial-index.h"
+
+using Inkscape::Util::SpatialIndex;
+
+namespace {
+
+std::vector<unsigned> brute_force(std::vector<Geom::OptIntRect> const &boxes, Geom::IntRect const &area)
+{
+    std::vector<unsigned> result;
+    for (unsigned i = 0; i < boxes.size(); i++) {
+        if (boxes[i] && boxes[i]->intersects(area)) {
+            result.emplace_back(i);
+        }
+    }
+    return result;
+}
+
+Geom::IntRect random_rect(std::mt19937 &gen, int max_size)
+{
+    auto pos = std::uniform_int_distribution(0, 10000);
+    auto size = std::uniform_int_distribution(0, max_size);
+    auto const x = pos(gen);
+    auto const y = pos(gen);
+    return Geom::IntRect::from_xywh(x, y, size(gen), size(gen));
+}
+
+} // namespace
+
+TEST(SpatialIndexTest, Empty)
+{
+    SpatialIndex<Geom::IntCoord> index;
+    EXPECT_TRUE(index.query(Geom::IntRect(0, 0, 100, 100)).empty());
+
+    index.build({{}, {}, {}});
+    EXPECT_EQ(index.size(), 3u);
+    EXPECT_TRUE(index.query(Geom::IntRect(0, 0, 100, 100)).empty());
+}
+
+TEST(SpatialIndexTest, MatchesLinearScan)
+{
+    auto gen = std::mt19937(12345);
+
+    std::vector<Geom::OptIntRect> boxes;
+    for (int i = 0; i < 100000; i++) {
+        if (i % 97 == 0) {
+            boxes.emplace_back();
+        } else {
+            boxes.emplace_back(random_rect(gen, 50));
+        }
+    }
+
+    SpatialIndex<Geom::IntCoord> index;
+    index.build(boxes);
+
+    auto check = [&] {
+        for (int i = 0; i < 100; i++) {
+            auto const area = random_rect(gen, 500);
+            ASSERT_EQ(index.query(area), brute_force(boxes, area));
+        }
+    };
+    check();
+
+    // Move every third box, then refit.
+    for (unsigned i = 0; i < boxes.size(); i += 3) {
+        if (boxes[i]) {
+            boxes[i] = random_rect(gen, 5);
+            ASSERT_TRUE(index.update(i, boxes[i]));
+        }
+    }
+    EXPECT_TRUE(index.refit());
+    EXPECT_FALSE(index.refit());
+    check();
+
+    // Changing between empty and non-empty requires a rebuild.
+    EXPECT_FALSE(index.update(0, Geom::IntRect(1, 1, 2, 2)));
+    EXPECT_FALSE(index.update(1, {}));
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
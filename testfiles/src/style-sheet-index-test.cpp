@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test that the style sheet index matches the same rules as the selector engine does by itself.
+ */
+/*
+ * Copyright (C) 2024 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "document.h"
+#include "inkscape.h"
+#include "style-sheet-index.h"
+#include "3rdparty/libcroco/src/cr-selector.h"
+#include "object/sp-object.h"
+#include "object/sp-root.h"
+#include "xml/croco-node-iface.h"
+
+using namespace Inkscape;
+
+class StyleSheetIndexTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        Application::create(false);
+        sel_eng = cr_sel_eng_new(&XML::croco_node_iface);
+
+        // Rules of every kind the index buckets differently, and elements matching them in
+        // different combinations.
+        std::ostringstream svg;
+        svg << "<svg xmlns='http://www.w3.org/2000/svg' width='100' height='100'><style>"
+               "rect { fill: red; } .a { fill: green; } .a.b { stroke: blue; } rect.c { opacity: 0.5; }"
+               "#one { stroke-width: 3; } g > .b { stroke: yellow; } g .c { fill: purple; }"
+               "circle:first-child { fill: orange; } [x] { stroke-dasharray: 1; } * { stroke-opacity: 0.9; }"
+               ".a, ellipse { fill-opacity: 0.3; } .d .a { fill: black !important; } RECT { fill: gray; }"
+               "</style><style>.a { fill: white; }</style>";
+        char const *classes[] = { "", "a", "b", "a b", "b a", "c", "a c", "  c\tb ", "d", "e" };
+        char const *names[] = { "rect", "circle", "ellipse", "path" };
+        int n = 0;
+        for (auto outer : { "", "b", "d" }) {
+            svg << "<g class='" << outer << "'>";
+            for (auto name : names) {
+                for (auto cls : classes) {
+                    svg << "<" << name << " id='" << (n == 7 ? "one" : "n" + std::to_string(n)) << "' class='" << cls
+                        << "' x='1'/>";
+                    n++;
+                }
+            }
+            svg << "</g>";
+        }
+        svg << "</svg>";
+        auto const str = svg.str();
+        doc = SPDocument::createNewDocFromMem(str.c_str(), str.size(), true);
+    }
+
+    void TearDown() override
+    {
+        cr_sel_eng_destroy(sel_eng);
+    }
+
+    static std::vector<CRDeclaration *> declarations(CRPropList *props)
+    {
+        std::vector<CRDeclaration *> result;
+        for (auto p = props; p; p = cr_prop_list_get_next(p)) {
+            CRDeclaration *decl = nullptr;
+            cr_prop_list_get_decl(p, &decl);
+            result.push_back(decl);
+        }
+        return result;
+    }
+
+    void check(SPObject *object)
+    {
+        CRPropList *expected = nullptr;
+        cr_sel_eng_get_matched_properties_from_cascade(sel_eng, doc->getStyleCascade(), object->getRepr(), &expected);
+        auto const actual = doc->getStyleSheetIndex().matchedProperties(sel_eng, object->getRepr());
+        EXPECT_EQ(declarations(actual.get()), declarations(expected)) << object->getRepr()->name();
+        if (expected) {
+            cr_prop_list_destroy(expected);
+        }
+
+        for (auto &child : object->children) {
+            check(&child);
+        }
+    }
+
+    CRSelEng *sel_eng = nullptr;
+    std::unique_ptr<SPDocument> doc;
+};
+
+TEST_F(StyleSheetIndexTest, MatchesSelectorEngine)
+{
+    // Twice, to check the cached results too.
+    check(doc->getRoot());
+    check(doc->getRoot());
+}
+
+TEST_F(StyleSheetIndexTest, FollowsStyleSheetChanges)
+{
+    check(doc->getRoot());
+    auto style = doc->getObjectsByElement("style").front()->getRepr();
+    style->firstChild()->setContent(".b { fill: blue; } path.e { fill: red; }");
+    check(doc->getRoot());
+}
+
+TEST_F(StyleSheetIndexTest, FindsObjectsBySelector)
+{
+    for (auto selector : { ".a", ".a.b", "rect.c", "#one", "g > .b", "circle:first-child", "[x]", "*", "ellipse",
+                           ".d .a, path", "RECT" })
+    {
+        auto cr_selector = cr_selector_parse_from_buf(reinterpret_cast<guchar const *>(selector), CR_UTF_8);
+        std::vector<SPObject *> expected;
+        for (auto cur = cr_selector; cur; cur = cur->next) {
+            auto search = [&] (auto &search, SPObject *object) -> void {
+                gboolean result = false;
+                cr_sel_eng_matches_node(sel_eng, cur->simple_sel, object->getRepr(), &result);
+                if (result) {
+                    expected.push_back(object);
+                }
+                for (auto &child : object->children) {
+                    search(search, &child);
+                }
+            };
+            search(search, doc->getRoot());
+        }
+        cr_selector_destroy(cr_selector);
+
+        EXPECT_EQ(doc->getObjectsBySelector(selector), expected) << selector;
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -589,6 +589,67 @@ TEST(StyleTest, Cascade) {
   }
 }
 
+TEST(StyleTest, Properties) {
+  // The property list is shared between styles, but each style must see its own members.
+  SPStyle style_a;
+  SPStyle style_b;
+  style_a.mergeString("fill:red;stroke-width:2");
+
+  auto const props_a = style_a.properties();
+  auto const props_b = style_b.properties();
+  ASSERT_EQ(props_a.size(), props_b.size());
+  for (std::size_t i = 0; i < props_a.size(); ++i) {
+    EXPECT_EQ(props_a[i]->id(), props_b[i]->id());
+    EXPECT_NE(props_a[i], props_b[i]);
+  }
+  EXPECT_EQ(props_a.front(), &style_a.d);
+  EXPECT_TRUE(style_a.fill.set);
+  EXPECT_FALSE(style_b.fill.set);
+}
+
+TEST(StyleTest, SharedFontVariants) {
+  SPStyle parent;
+  SPStyle child_a;
+  SPStyle child_b;
+  SPStyle child_c;
+
+  // Styles without font variants share one block, also after cascading.
+  EXPECT_EQ(&child_a.fontVariants(), &child_b.fontVariants());
+  child_a.cascade(&parent);
+  EXPECT_EQ(&child_a.fontVariants(), &parent.fontVariants());
+
+  // Equal font variants are shared once cascaded; setting one copies it.
+  child_a.mergeString("font-variant-caps:small-caps;font-feature-settings:'liga' 0");
+  child_b.mergeString("font-feature-settings:'liga' 0;font-variant-caps:small-caps");
+  EXPECT_NE(&child_a.fontVariants(), &parent.fontVariants());
+  child_a.cascade(&parent);
+  child_b.cascade(&parent);
+  EXPECT_EQ(&child_a.fontVariants(), &child_b.fontVariants());
+  EXPECT_EQ(child_a.fontVariants().font_variant_caps.computed, SP_CSS_FONT_VARIANT_CAPS_SMALL);
+  EXPECT_TRUE(child_a.isSet(SPAttr::FONT_VARIANT_CAPS));
+
+  child_b.readIfUnset(SPAttr::FONT_VARIANT_POSITION, "super");
+  EXPECT_NE(&child_a.fontVariants(), &child_b.fontVariants());
+  EXPECT_FALSE(child_a.fontVariants().font_variant_position.set);
+  EXPECT_TRUE(child_b.fontVariants().font_variant_position.set);
+
+  // Inherited values are cascaded into the shared block.
+  parent.mergeString("font-variant-numeric:slashed-zero");
+  child_c.cascade(&parent);
+  EXPECT_FALSE(child_c.fontVariants().font_variant_numeric.set);
+  EXPECT_EQ(child_c.fontVariants().font_variant_numeric.computed, SP_CSS_FONT_VARIANT_NUMERIC_SLASHED_ZERO);
+  EXPECT_NE(&child_c.fontVariants(), &parent.fontVariants());
+
+  // Merging takes the parent's set values.
+  child_a.merge(&parent);
+  EXPECT_TRUE(child_a.fontVariants().font_variant_numeric.set);
+  EXPECT_TRUE(child_a.fontVariants().font_variant_caps.set);
+  EXPECT_NE(&child_a.fontVariants(), &parent.fontVariants());
+
+  // Clearing returns to the block shared by unset styles.
+  child_a.clear();
+  EXPECT_EQ(&child_a.fontVariants(), &SPStyle().fontVariants());
+}
 
 } // namespace
 
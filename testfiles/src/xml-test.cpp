@@ -13,8 +13,12 @@
  */
 
 #include "gtest/gtest.h"
+#include "xml/attribute-record.h"
 #include "xml/repr.h"
 
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <list>
 
 TEST(XmlTest, nodeiter)
@@ -97,6 +101,95 @@ NODE
 )""");
 }
 
+TEST(XmlReadTest, whitespaceAndText)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(
+        "<!-- c --><svg> <g> </g><g xml:space='preserve'> <g xml:space='default'> </g>a&amp;&#10;b<![CDATA[c]]><![CDATA[d]]></g></svg>",
+        SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    ASSERT_EQ(testdoc->firstChild()->type(), Inkscape::XML::NodeType::COMMENT_NODE);
+    ASSERT_STREQ(testdoc->root()->name(), "svg:svg");
+
+    // White space is dropped unless xml:space is "preserve".
+    auto first = testdoc->root()->firstChild();
+    ASSERT_EQ(first->firstChild(), nullptr);
+    auto second = first->next();
+    ASSERT_NE(second, nullptr);
+    ASSERT_EQ(second->childCount(), 4u);
+
+    auto child = second->firstChild();
+    ASSERT_STREQ(child->content(), " ");
+    child = child->next();
+    ASSERT_STREQ(child->name(), "svg:g");
+    ASSERT_EQ(child->firstChild(), nullptr);
+
+    // Adjacent character data is merged into one node.
+    child = child->next();
+    ASSERT_EQ(child->type(), Inkscape::XML::NodeType::TEXT_NODE);
+    ASSERT_STREQ(child->content(), "a&\nb");
+    child = child->next();
+    ASSERT_STREQ(child->content(), "cd");
+}
+
+TEST(XmlReadTest, userEntities)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(
+        "<!DOCTYPE svg [<!ENTITY w '12'>]><svg><rect width='&w;'/></svg>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    ASSERT_STREQ(testdoc->root()->firstChild()->attribute("width"), "12");
+}
+
+TEST(XmlReadTest, emptyAttributesSkipped)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(
+        "<svg><rect id='r' style='' xml:space=''/></svg>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto rect = testdoc->root()->firstChild();
+    ASSERT_STREQ(rect->attribute("id"), "r");
+    ASSERT_EQ(rect->attribute("style"), nullptr);
+    ASSERT_EQ(rect->attribute("xml:space"), nullptr);
+    ASSERT_EQ(rect->attributeList().size(), 1u);
+}
+
+TEST(XmlReadTest, externalEntitiesNotLoaded)
+{
+    auto const secret = std::filesystem::temp_directory_path() / "inkscape-xml-test-secret.txt";
+    std::ofstream(secret) << "SECRET";
+
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(
+        "<!DOCTYPE svg [<!ENTITY x SYSTEM 'file://" + secret.string() + "'>]>"
+        "<svg><text title='&x;'>&x;</text></svg>", SP_SVG_NS_URI));
+    std::filesystem::remove(secret);
+
+    ASSERT_TRUE(testdoc);
+    ASSERT_EQ(sp_repr_save_buf(testdoc.get()).find("SECRET"), Glib::ustring::npos);
+}
+
+TEST(XmlAttributeTest, setAndClear)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf("<svg><path/></svg>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto path = testdoc->root()->firstChild();
+
+    // More attributes than are stored inline.
+    char const *names[] = {"d", "id", "style", "transform", "fill", "stroke", "inkscape:label", "x-test-attribute"};
+    for (auto name : names) {
+        path->setAttribute(name, name);
+    }
+    ASSERT_EQ(path->attributeList().size(), std::size(names));
+    for (auto name : names) {
+        ASSERT_STREQ(path->attribute(name), name);
+    }
+    ASSERT_EQ(path->attribute("x-never-used-as-an-attribute"), nullptr);
+
+    path->setAttribute("id", nullptr);
+    path->setAttribute("x-test-attribute", nullptr);
+    ASSERT_EQ(path->attributeList().size(), std::size(names) - 2);
+    ASSERT_EQ(path->attribute("id"), nullptr);
+    ASSERT_STREQ(path->attribute("d"), "d");
+    ASSERT_STREQ(path->attribute("inkscape:label"), "inkscape:label");
+}
+
 /*
   Local Variables:
   mode:c++